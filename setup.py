@@ -19,13 +19,25 @@ sources = ["src/system/utility.cc",
            "src/loop/move.cc",
            "src/loop/moveutil.cc",
            "src/loop/loop.cc",
+           "src/loop/looppool.cc",
            "src/system/energyoptions.cc",
            "src/energymodel/nupackenergymodel.cc",
            "src/energymodel/energymodel.cc",
+           "src/energymodel/energycache.cc",
+           "src/energymodel/parametersnapshot.cc",
+           "src/energymodel/boltzmannsampler.cc",
            "src/state/scomplex.cc",
            "src/state/scomplexlist.cc",
+           "src/state/looptree.cc",
+           "src/state/flatcomplex.cc",
+           "src/state/complexindex.cc",
            "src/system/statespace.cc",
            "src/system/simoptions.cc",
+           "src/system/resultsink.cc",
+           "src/system/trajectorywriter.cc",
+           "src/system/passagetime.cc",
+           "src/system/rng.cc",
+           "src/system/stopconditions.cc",
            "src/system/ssystem.cc",
            "src/state/strandordering.cc"
            ]
@@ -37,7 +49,8 @@ def setup_ext( ):
                           include_dirs=["./src/include"],
                           language="c++",
                         undef_macros=['NDEBUG'],
-                        extra_compile_args = ['-O3', '-w', "-std=c++11", ], #FD: adding c++11 flag 
+                        extra_compile_args = ['-O3', '-w', "-std=c++11", "-pthread", ], #FD: adding c++11 flag 
+                        extra_link_args = ["-pthread", ], # worker threads in SimSystem.start
                           )
     return multi_ext
 
@@ -0,0 +1,532 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/*
+ * The partition function follows the loops of the complex. A pair (i, j) closes a hairpin, an
+ * interior loop, a multiloop or, when a strand ends inside it, an open loop. The unpaired runs
+ * of a multiloop or open loop carry the multiloop base penalty and the dangles of the pairs
+ * next to them, so a segment of such a loop is summed with the pairs on either side known:
+ *
+ * 		L, R:	0 when the segment starts (ends) at a strand end, otherwise 1 + the slot of the
+ * 				partner of base a - 1 (b + 1) in the partners table
+ *
+ * In the tables, family 0 is an exterior (open) loop and family 1 a multiloop.
+ *
+ * 		oneOrMore[f](a, b, L, R)	a..b holds at least one branch
+ * 		twoOrMore(a, b, L, R)		a..b holds at least two branches, for multiloops
+ * 		firstBranch[f](p, b, R, s)	p pairs with the base in slot s, then anything up to b
+ * 		firstOfTwo(p, b, R, s)		the same, with at least one more branch
+ */
+
+#include <boltzmannsampler.h>
+#include <energymodel.h>
+#include <options.h>
+#include <rng.h>
+
+#include <math.h>
+
+// the bases a base can pair with, GT pairs included
+static const char partners[BASES][2] = { { 0, 0 }, { baseT, 0 }, { baseG, 0 }, { baseC, baseT }, { baseA, baseG } };
+
+BoltzmannSampler::BoltzmannSampler(NupackEnergyModel *model, const string& sequence) {
+
+	this->model = model;
+	RT = model->_RT;
+
+	for (char c : sequence) {
+
+		if (c == '+') {
+			strandEnd.push_back(base.size() - 1);
+		} else {
+			base.push_back(baseLookup(c));
+		}
+	}
+
+	length = base.size();
+	strandEnd.push_back(length - 1);
+
+	nickIndex.assign(length, -1);
+	nicksBefore.assign(length + 1, 0);
+
+	for (int k = 0; k + 1 < (int) strandEnd.size(); k++) {
+		nickIndex[strandEnd[k]] = k;
+	}
+
+	for (int i = 0; i < length; i++) {
+		nicksBefore[i + 1] = nicksBefore[i] + (nickIndex[i] >= 0);
+	}
+
+	for (int pt = 0; pt < PAIRS_NUPACK; pt++) {
+		for (int b = 0; b < BASES; b++) {
+
+			danglesFive[pt][b] = expl(-model->multiloop_dG.dangle_5[pt][b] / RT);
+			danglesThree[pt][b] = expl(-model->multiloop_dG.dangle_3[pt][b] / RT);
+
+		}
+	}
+
+	unpaired.resize(length + 1);
+
+	for (int len = 0; len <= length; len++) {
+		unpaired[len] = expl(-model->multiloop_dG.base * len / RT);
+	}
+
+	fill();
+
+}
+
+double BoltzmannSampler::freeEnergy(void) {
+
+	return -RT * logl(partition);
+
+}
+
+bool BoltzmannSampler::hasStructures(void) {
+
+	return partition > 0.0;
+
+}
+
+int BoltzmannSampler::pairType(int first, int second) const {
+
+	return pairtypes_mfold[(int) base[first]][(int) base[second]] - 1;
+
+}
+
+int BoltzmannSampler::slotOf(int position, int partner) const {
+
+	return (partners[(int) base[position]][0] == partner) ? 1 : 2;
+
+}
+
+// the unpaired bases a..b between two pairs, or a pair and a strand end
+BoltzmannSampler::weight BoltzmannSampler::gap(int family, int a, int b, int L, int R) const {
+
+	if (!noNick(L ? a - 1 : a, R ? b : b - 1))
+		return 0.0;
+
+	int size = b - a + 1;
+	weight output = family ? unpaired[size] : 1.0;
+
+	if (model->dangles == DANGLES_NONE || (!L && !R))
+		return output;
+
+	int typeL = L ? pairtypes_mfold[(int) base[a - 1]][(int) partners[(int) base[a - 1]][L - 1]] - 1 : -1;
+	int typeR = R ? pairtypes_mfold[(int) partners[(int) base[b + 1]][R - 1]][(int) base[b + 1]] - 1 : -1;
+
+	if (!L)
+		return size > 0 ? output * danglesThree[typeR][(int) base[b]] : output;
+
+	if (!R)
+		return size > 0 ? output * danglesFive[typeL][(int) base[a]] : output;
+
+	weight five = danglesFive[typeL][(int) base[a]];
+	weight three = danglesThree[typeR][(int) base[b]];
+
+	if (model->dangles == DANGLES_SOME && size == 0)
+		return output;
+
+	if (model->dangles == DANGLES_SOME && size == 1)
+		return output * ((five > three) ? five : three); // the lower of the two energies
+
+	return output * five * three;
+
+}
+
+// the AU and GT penalties of a pair in a multiloop or open loop, and the multiloop internal term
+BoltzmannSampler::weight BoltzmannSampler::terminal(int family, int i, int j) const {
+
+	int pt = pairType(i, j);
+	double energy = 0.0;
+
+	if ((pt == 0) || (pt > 2))
+		energy += model->terminal_AU;
+
+	if (!model->gtenable && (pt > 3))
+		energy += 100000.0;
+
+	if (family)
+		energy += model->multiloop_dG.internal;
+
+	return expl(-energy / RT);
+
+}
+
+BoltzmannSampler::weight BoltzmannSampler::hairpin(int i, int j) const {
+
+	int size = j - i - 1;
+
+	if (size < 3 || !noNick(i, j - 1))
+		return 0.0;
+
+	return expl(-model->HairpinEnergy((char*) &base[i], size, model->hairpin_dG) / RT);
+
+}
+
+BoltzmannSampler::weight BoltzmannSampler::interior(int i, int j, int p, int q) const {
+
+	int size1 = p - i - 1;
+	int size2 = j - q - 1;
+	double energy;
+
+	if (!noNick(i, p - 1) || !noNick(q, j - 1))
+		return 0.0;
+
+	if (size1 == 0 && size2 == 0) {
+		energy = model->stack_37_dG[pairType(i, j)][pairType(p, q)];
+	} else if (size1 == 0 || size2 == 0) {
+		energy = model->BulgeEnergy(base[i], base[j], base[p], base[q], size1 + size2, model->bulge_37_dG, model->stack_37_dG);
+	} else {
+		energy = model->InteriorEnergy((char*) &base[i], (char*) &base[q], size1, size2, model->internal_dG);
+	}
+
+	return expl(-energy / RT);
+
+}
+
+BoltzmannSampler::weight BoltzmannSampler::multiloop(int i, int j) const {
+
+	if (j - i - 1 < 2)
+		return 0.0;
+
+	weight inside = twoOrMore[segment(i + 1, j - 1, slotOf(i, base[j]), slotOf(j, base[i]))];
+
+	return inside * terminal(1, i, j) * expl(-model->multiloop_dG.closing / RT);
+
+}
+
+// the strand that ends at nick is the last one in the loop
+BoltzmannSampler::weight BoltzmannSampler::openloop(int i, int j, int nick) const {
+
+	return terminal(0, i, j) * any(0, i + 1, nick, slotOf(i, base[j]), 0) * any(0, nick + 1, j - 1, 0, slotOf(j, base[i]));
+
+}
+
+BoltzmannSampler::weight BoltzmannSampler::any(int family, int a, int b, int L, int R) const {
+
+	return gap(family, a, b, L, R) + atLeastOne(family, a, b, L, R);
+
+}
+
+BoltzmannSampler::weight BoltzmannSampler::atLeastOne(int family, int a, int b, int L, int R) const {
+
+	return (a <= b) ? oneOrMore[family][segment(a, b, L, R)] : 0.0;
+
+}
+
+void BoltzmannSampler::fill(void) {
+
+	int cells = length * length;
+
+	paired.assign(cells, 0.0);
+	twoOrMore.assign(cells * 9, 0.0);
+	firstOfTwo.assign(cells * 6, 0.0);
+
+	for (int f = 0; f < 2; f++) {
+		oneOrMore[f].assign(cells * 9, 0.0);
+		firstBranch[f].assign(cells * 6, 0.0);
+	}
+
+	for (int span = 0; span < length; span++) {
+		for (int a = 0; a + span < length; a++) {
+
+			int b = a + span;
+
+			// a pairs with b
+			if (pairtypes_mfold[(int) base[a]][(int) base[b]] > 0) {
+
+				weight Q = hairpin(a, b);
+
+				for (int p = a + 1; p < b - 1 && p - a - 1 <= BOLTZMANN_MAX_INTERIOR; p++) {
+					for (int q = b - 1; q > p && (p - a - 1) + (b - q - 1) <= BOLTZMANN_MAX_INTERIOR; q--) {
+
+						if (paired[at(p, q)] > 0.0)
+							Q += interior(a, b, p, q) * paired[at(p, q)];
+
+					}
+				}
+
+				Q += multiloop(a, b);
+
+				for (int k = a; k < b; k++) {
+					if (nickIndex[k] >= 0)
+						Q += openloop(a, b, k);
+				}
+
+				paired[at(a, b)] = Q;
+
+			}
+
+			// a pairs first, with the base in slot s
+			for (int s = 0; s < 2 && partners[(int) base[a]][s]; s++) {
+				for (int R = 0; R < 3; R++) {
+
+					if (R && (b + 1 == length || !partners[(int) base[b + 1]][R - 1]))
+						continue;
+
+					weight sum[2] = { 0.0, 0.0 }, two = 0.0;
+
+					for (int q = a + 1; q <= b; q++) {
+
+						if (base[q] != partners[(int) base[a]][s] || paired[at(a, q)] == 0.0)
+							continue;
+
+						int Lq = slotOf(q, base[a]);
+
+						for (int f = 0; f < 2; f++)
+							sum[f] += paired[at(a, q)] * terminal(f, a, q) * any(f, q + 1, b, Lq, R);
+
+						two += paired[at(a, q)] * terminal(1, a, q) * atLeastOne(1, q + 1, b, Lq, R);
+
+					}
+
+					firstBranch[0][branch(a, b, R, s)] = sum[0];
+					firstBranch[1][branch(a, b, R, s)] = sum[1];
+					firstOfTwo[branch(a, b, R, s)] = two;
+
+				}
+			}
+
+			// a..b, after the pair or strand end L and before R
+			for (int L = 0; L < 3; L++) {
+
+				if (L && (a == 0 || !partners[(int) base[a - 1]][L - 1]))
+					continue;
+
+				for (int R = 0; R < 3; R++) {
+
+					if (R && (b + 1 == length || !partners[(int) base[b + 1]][R - 1]))
+						continue;
+
+					for (int f = 0; f < 2; f++) {
+
+						// the runs of a multiloop are always between two pairs
+						if (f && (!L || !R))
+							continue;
+
+						weight one = 0.0, two = 0.0;
+
+						for (int p = a; p <= b; p++) {
+
+							if (!noNick(L ? a - 1 : a, p - 1))
+								break;
+
+							for (int s = 0; s < 2 && partners[(int) base[p]][s]; s++) {
+
+								weight before = gap(f, a, p - 1, L, s + 1);
+
+								one += before * firstBranch[f][branch(p, b, R, s)];
+
+								if (f)
+									two += before * firstOfTwo[branch(p, b, R, s)];
+
+							}
+						}
+
+						oneOrMore[f][segment(a, b, L, R)] = one;
+
+						if (f)
+							twoOrMore[segment(a, b, L, R)] = two;
+
+					}
+				}
+			}
+		}
+	}
+
+	partition = any(0, 0, length - 1, 0, 0);
+
+}
+
+string BoltzmannSampler::sample(RandomGenerator& rng) const {
+
+	string pairs(length, '.');
+
+	if (partition > 0.0)
+		sampleAny(rng, 0, 0, length - 1, 0, 0, pairs);
+
+	string output;
+
+	for (int i = 0; i < length; i++) {
+
+		output.push_back(pairs[i]);
+
+		if (nickIndex[i] >= 0)
+			output.push_back('+');
+
+	}
+
+	return output;
+
+}
+
+// Each choice is drawn with its own variate, in the order the tables were summed. When
+// rounding leaves the variate past the last option, the last option with weight is taken.
+
+void BoltzmannSampler::samplePair(RandomGenerator& rng, int i, int j, string& structure) const {
+
+	structure[i] = '(';
+	structure[j] = ')';
+
+	weight target = rng.uniform() * paired[at(i, j)];
+	weight total = hairpin(i, j);
+
+	if (target < total)
+		return;
+
+	int lastP = -1, lastQ = -1;
+
+	for (int p = i + 1; p < j - 1 && p - i - 1 <= BOLTZMANN_MAX_INTERIOR; p++) {
+		for (int q = j - 1; q > p && (p - i - 1) + (j - q - 1) <= BOLTZMANN_MAX_INTERIOR; q--) {
+
+			if (paired[at(p, q)] == 0.0)
+				continue;
+
+			weight w = interior(i, j, p, q) * paired[at(p, q)];
+
+			if (w == 0.0)
+				continue;
+
+			total += w;
+			lastP = p;
+			lastQ = q;
+
+			if (target < total) {
+				samplePair(rng, p, q, structure);
+				return;
+			}
+		}
+	}
+
+	int Li = slotOf(i, base[j]);
+	int Rj = slotOf(j, base[i]);
+	weight w = multiloop(i, j);
+
+	total += w;
+
+	if (target < total && w > 0.0) {
+		sampleBranches(rng, 1, i + 1, j - 1, Li, Rj, true, structure);
+		return;
+	}
+
+	int lastNick = -1;
+
+	for (int k = i; k < j; k++) {
+
+		if (nickIndex[k] < 0)
+			continue;
+
+		w = openloop(i, j, k);
+
+		if (w == 0.0)
+			continue;
+
+		total += w;
+		lastNick = k;
+
+		if (target < total)
+			break;
+	}
+
+	if (lastNick >= 0) {
+
+		sampleAny(rng, 0, i + 1, lastNick, Li, 0, structure);
+		sampleAny(rng, 0, lastNick + 1, j - 1, 0, Rj, structure);
+
+	} else if (multiloop(i, j) > 0.0) {
+
+		sampleBranches(rng, 1, i + 1, j - 1, Li, Rj, true, structure);
+
+	} else if (lastP >= 0) {
+
+		samplePair(rng, lastP, lastQ, structure);
+
+	}
+
+}
+
+void BoltzmannSampler::sampleAny(RandomGenerator& rng, int family, int a, int b, int L, int R, string& structure) const {
+
+	weight open = gap(family, a, b, L, R);
+	weight branches = atLeastOne(family, a, b, L, R);
+
+	if (rng.uniform() * (open + branches) < open || branches == 0.0)
+		return;
+
+	sampleBranches(rng, family, a, b, L, R, false, structure);
+
+}
+
+void BoltzmannSampler::sampleBranches(RandomGenerator& rng, int family, int a, int b, int L, int R, bool twoOrMore, string& structure) const {
+
+	const vector<weight>& first = twoOrMore ? firstOfTwo : firstBranch[family];
+
+	weight target = rng.uniform() * (twoOrMore ? this->twoOrMore[segment(a, b, L, R)] : oneOrMore[family][segment(a, b, L, R)]);
+	weight total = 0.0;
+	int p = -1, s = -1;
+
+	for (int p2 = a; p2 <= b && (p < 0 || total <= target); p2++) {
+
+		if (!noNick(L ? a - 1 : a, p2 - 1))
+			break;
+
+		for (int s2 = 0; s2 < 2 && partners[(int) base[p2]][s2]; s2++) {
+
+			weight w = gap(family, a, p2 - 1, L, s2 + 1) * first[branch(p2, b, R, s2)];
+
+			if (w == 0.0)
+				continue;
+
+			total += w;
+			p = p2;
+			s = s2;
+
+			if (target < total)
+				break;
+		}
+	}
+
+	if (p < 0)
+		return;
+
+	target = rng.uniform() * first[branch(p, b, R, s)];
+	total = 0.0;
+
+	int q = -1;
+
+	for (int q2 = p + 1; q2 <= b; q2++) {
+
+		if (base[q2] != partners[(int) base[p]][s] || paired[at(p, q2)] == 0.0)
+			continue;
+
+		int Lq = slotOf(q2, base[p]);
+		weight rest = twoOrMore ? atLeastOne(1, q2 + 1, b, Lq, R) : any(family, q2 + 1, b, Lq, R);
+		weight w = paired[at(p, q2)] * terminal(family, p, q2) * rest;
+
+		if (w == 0.0)
+			continue;
+
+		total += w;
+		q = q2;
+
+		if (target < total)
+			break;
+	}
+
+	if (q < 0)
+		return;
+
+	samplePair(rng, p, q, structure);
+
+	int Lq = slotOf(q, base[p]);
+
+	if (twoOrMore) {
+		sampleBranches(rng, 1, q + 1, b, Lq, R, false, structure);
+	} else {
+		sampleAny(rng, family, q + 1, b, Lq, R, structure);
+	}
+
+}
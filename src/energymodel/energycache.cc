@@ -0,0 +1,127 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the EnergyCache found in energycache.h
+#include "energycache.h"
+
+thread_local EnergyCache *EnergyCache::current = NULL;
+std::atomic<long> EnergyCache::enabled(0);
+
+EnergyCache::EnergyCache(void) {
+
+}
+
+EnergyCache::~EnergyCache(void) {
+
+	if (current == this)
+		current = NULL;
+
+	if (!entries.empty())
+		enabled--;
+
+}
+
+void EnergyCache::resize(long size) {
+
+	unsigned long capacity = 0;
+
+	if (size > 0)
+		for (capacity = 1; capacity < (unsigned long) size; capacity <<= 1)
+			;
+
+	if (!entries.empty())
+		enabled--;
+
+	entries.clear();
+	entries.resize(capacity);
+	mask = (capacity > 0) ? capacity - 1 : 0;
+
+	if (!entries.empty())
+		enabled++;
+
+}
+
+// empty keys never match, every key starts with its kind
+void EnergyCache::clear(void) {
+
+	for (Entry& entry : entries)
+		entry.key.clear();
+
+}
+
+void EnergyCache::use(EnergyCache *cache) {
+
+	current = cache;
+
+}
+
+EnergyCache *EnergyCache::threadCache(void) {
+
+	if (current == NULL || current->entries.empty())
+		return NULL;
+
+	return current;
+
+}
+
+void EnergyCache::begin(char kind) {
+
+	key.clear();
+	key.push_back(kind);
+
+}
+
+void EnergyCache::add(int value) {
+
+	key.append((const char *) &value, sizeof(int));
+
+}
+
+void EnergyCache::add(const char *bases, int length) {
+
+	key.append(bases, length);
+
+}
+
+// FNV-1a
+unsigned long EnergyCache::slot(void) const {
+
+	unsigned long hash = 14695981039346656037UL;
+
+	for (char c : key) {
+		hash ^= (unsigned char) c;
+		hash *= 1099511628211UL;
+	}
+
+	return hash & mask;
+
+}
+
+bool EnergyCache::find(double& value) {
+
+	found = slot();
+	Entry& entry = entries[found];
+
+	if (entry.key == key) {
+		value = entry.value;
+		hits++;
+		return true;
+	}
+
+	misses++;
+	return false;
+
+}
+
+// stores under the key of the last find
+void EnergyCache::store(double value) {
+
+	Entry& entry = entries[found];
+
+	entry.key = key;
+	entry.value = value;
+
+}
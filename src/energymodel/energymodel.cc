@@ -19,10 +19,6 @@ bool printedRates = false; // to print the constants to file once
 const double INIT_PENALTY = 0.0; //kcal / mol
 
 
-int pairs[5] = { 0, 0, 0, 0, 0 };
-int pairtypes[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 } };
-int basepair_sw[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-
 constexpr int lookuphelper[26] = { 1, 0, 2, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 0, 0, 0, 0, 0 };		// A C G T    1 2 3 4
 //                      A,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q,R,S,T,U,V,W,X,Y,Z
 
@@ -97,6 +93,8 @@ void EnergyModel::computeArrheniusRates(double temperature) {
 
 	}
 
+	fillJoinRates();
+
 }
 
 void EnergyModel::writeConstantsToFile() {
@@ -229,19 +227,68 @@ double EnergyModel::fastestUniRate(void) {
 
 }
 
-double EnergyModel::applyPrefactors(double tempRate, MoveType left, MoveType right) {
+const double InspectionPolicy::value = 1.0;
+const double InvalidPolicy::value = -9999.99;
+
+// Picks the kernels of the rate method, so that computing a rate does not branch on it.
+void EnergyModel::selectRatePolicy(void) {
+
+	rateConstants.prefactors = arrheniusRates;
 
 	if (inspection) {
-		return 1.0;
+
+		ratePolicy = makeFixedRatePolicy<InspectionPolicy>();
+
+	} else {
+
+		switch (simOptions->energyOptions->getKineticRateMethod()) {
+
+		case RATE_METHOD_METROPOLIS:
+			ratePolicy = makeRatePolicy<MetropolisPolicy>();
+			break;
+		case RATE_METHOD_KAWASAKI:
+			ratePolicy = makeRatePolicy<KawasakiPolicy>();
+			break;
+		case RATE_METHOD_ARRHENIUS:
+			ratePolicy = makeRatePolicy<ArrheniusPolicy>();
+			break;
+		default:
+			ratePolicy = makeFixedRatePolicy<InvalidPolicy>();
+			break;
+
+		}
+
 	}
 
-	if (useArrhenius()) {
+	fillJoinRates();
+
+}
 
-		return tempRate * arrheniusRates[left * MOVETYPE_SIZE + right];
+// The join flux is a sum of base pairings weighted by these, so they are only computed once.
+void EnergyModel::fillJoinRates(void) {
 
-	} else {
+	double joinRate = getJoinRate();
+
+	for (int left = 0; left < MOVETYPE_SIZE; left++) {
+		for (int right = 0; right < MOVETYPE_SIZE; right++) {
+
+			joinRates[left * MOVETYPE_SIZE + right] = applyPrefactors(joinRate, (MoveType) left, (MoveType) right);
+
+		}
+	}
+
+	int index = 0;
+
+	for (QuartContext topLeft : { endC, strandC, stackC }) {
+		for (QuartContext topRight : { endC, strandC, stackC }) {
+			for (QuartContext botLeft : { endC, strandC, stackC }) {
+				for (QuartContext botRight : { endC, strandC, stackC }) {
 
-		return tempRate;
+					contextJoinRates[index++] = joinRateFor(moveutil::combineBi(topLeft, botRight), moveutil::combineBi(topRight, botLeft));
+
+				}
+			}
+		}
 	}
 
 }
@@ -9,9 +9,12 @@
 #include <math.h>
 #include <ctype.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 #include "simoptions.h"
 #include "options.h"
+#include "energycache.h"
+#include "parametersnapshot.h"
 
 #undef DEBUG
 //#define DEBUG
@@ -26,41 +29,26 @@ static double T_scale(double dG, double dH, double T) {
 const double CELSIUS37_IN_KELVIN = 310.15;
 const double TEMPERATURE_ZERO_CELSIUS_IN_KELVIN = 273.15;
 
-extern  int pairs[5];
-extern  int pairtypes[5][5];
-extern  int basepair_sw[8];
-
 // helper function to convert to numerical base format.
 extern int baseLookup(char base);
 
+// Unimolecular rates go through the rate policy, toggle 3 is the rate of a join.
 double NupackEnergyModel::returnRate(double start_energy, double end_energy, int enth_entr_toggle) {
 
-	if (inspection) {
-		return 1.0;
-	}
+	if (enth_entr_toggle == 3) {
 
-	double dE = end_energy - start_energy;
+		if (inspection) {
+			return 1.0;
+		}
+
+		double dE = end_energy - start_energy;
 
-	if (enth_entr_toggle == 3) {
 		return biscale * exp(-(dE - dG_assoc) / _RT);
 	}
 	// dG_assoc, if it were included in (start_energy, end_energy), would need to be deleted here. However, it never gets added into any energies except for display purposes. So it gets used in the join move rate, but not here.
 	// OLD: dG_assoc is typically a negative number, and included as part of the complex before disassociation. Thus it must be subtracted from the dE (leading to a typically slower disassociation rate.).
-	if (kinetic_rate_method == RATE_METHOD_KAWASAKI) {  // Kawasaki
 
-		return uniscale * exp(-0.5 * dE / _RT);
-
-	} else if (kinetic_rate_method == RATE_METHOD_METROPOLIS or RATE_METHOD_ARRHENIUS == kinetic_rate_method) {
-		// Metropolis
-		if (dE < 0) {
-			return uniscale * 1.0;
-		} else {
-			return uniscale * exp(-dE / _RT);
-		}
-
-	}
-
-	return -9999.99;
+	return ratePolicy.rate(rateConstants, start_energy, end_energy);
 
 }
 
@@ -94,14 +82,14 @@ double NupackEnergyModel::getAssocEnergy(void) {
 // non entropy/enthalpy energy functions
 double NupackEnergyModel::StackEnergy(int i, int j, int p, int q) {
 
-	return stack_37_dG[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
+	return stack_37_dG[pairtypes_mfold[i][j] - 1][pairtypes_mfold[p][q] - 1];
 
 }
 
 // non entropy/enthalpy energy functions
 double NupackEnergyModel::StackEnthalpy(int i, int j, int p, int q) {
 
-	return stack_37_dH[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
+	return stack_37_dH[pairtypes_mfold[i][j] - 1][pairtypes_mfold[p][q] - 1];
 
 }
 
@@ -133,13 +121,13 @@ double NupackEnergyModel::BulgeEnergy(int i, int j, int p, int q, int bulgesize,
 
 	if (bulgesize == 1) { // add stacking term for single-base bulges.
 
-		energy += stack[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
+		energy += stack[pairtypes_mfold[i][j] - 1][pairtypes_mfold[p][q] - 1];
 
 	} else { // AU penalty doesn't apply if they stack.
 
-		if (pairtypes[i][j] == 1 || pairtypes[i][j] > 3) // AT penalty applies
+		if (pairtypes_mfold[i][j] == 1 || pairtypes_mfold[i][j] > 3) // AT penalty applies
 			energy += terminal_AU;
-		if (pairtypes[q][p] == 1 || pairtypes[q][p] > 3) // AT penalty applies
+		if (pairtypes_mfold[q][p] == 1 || pairtypes_mfold[q][p] > 3) // AT penalty applies
 			energy += terminal_AU;
 
 	}
@@ -149,13 +137,39 @@ double NupackEnergyModel::BulgeEnergy(int i, int j, int p, int q, int bulgesize,
 
 double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int size2) {
 
-	return this->InteriorEnergy(seq1, seq2, size1, size2, internal_dG);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return InteriorEnergy(seq1, seq2, size1, size2, internal_dG);
+
+	interiorKey(*cache, 'I', seq1, seq2, size1, size2);
+
+	if (!cache->find(energy)) {
+		energy = InteriorEnergy(seq1, seq2, size1, size2, internal_dG);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
 double NupackEnergyModel::InteriorEnthalpy(char *seq1, char *seq2, int size1, int size2) {
 
-	return this->InteriorEnergy(seq1, seq2, size1, size2, internal_dH);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return InteriorEnergy(seq1, seq2, size1, size2, internal_dH);
+
+	interiorKey(*cache, 'i', seq1, seq2, size1, size2);
+
+	if (!cache->find(energy)) {
+		energy = InteriorEnergy(seq1, seq2, size1, size2, internal_dH);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
@@ -163,8 +177,8 @@ double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int
 
 	double energy, ninio;
 
-	int type1 = pairtypes[seq1[0]][seq2[size2 + 1]] - 1;
-	int type2 = pairtypes[seq1[size1 + 1]][seq2[0]] - 1;
+	int type1 = pairtypes_mfold[seq1[0]][seq2[size2 + 1]] - 1;
+	int type2 = pairtypes_mfold[seq1[size1 + 1]][seq2[0]] - 1;
 
 	// special case time. 1x1, 2x1 and 2x2's all get special cases.
 	if (size1 == 1 && size2 == 1)
@@ -222,13 +236,39 @@ double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int
 
 double NupackEnergyModel::HairpinEnergy(char *seq, int size) {
 
-	return HairpinEnergy(seq, size, hairpin_dG);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return HairpinEnergy(seq, size, hairpin_dG);
+
+	hairpinKey(*cache, 'H', seq, size);
+
+	if (!cache->find(energy)) {
+		energy = HairpinEnergy(seq, size, hairpin_dG);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
 double NupackEnergyModel::HairpinEnthalpy(char *seq, int size) {
 
-	return HairpinEnergy(seq, size, hairpin_dH);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return HairpinEnergy(seq, size, hairpin_dH);
+
+	hairpinKey(*cache, 'h', seq, size);
+
+	if (!cache->find(energy)) {
+		energy = HairpinEnergy(seq, size, hairpin_dH);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
@@ -264,7 +304,7 @@ double NupackEnergyModel::HairpinEnergy(char *seq, int size, hairpin_energies& h
 	}
 
 	if (size >= 4)
-		energy += hairpin.mismatch[(pairtypes[seq[0]][seq[size + 1]] - 1)][seq[1]][seq[size]];
+		energy += hairpin.mismatch[(pairtypes_mfold[seq[0]][seq[size + 1]] - 1)][seq[1]][seq[size]];
 
 	// FD: single stranded stacks.
 	energy += singleStrandedStacking(seq, size);
@@ -274,13 +314,39 @@ double NupackEnergyModel::HairpinEnergy(char *seq, int size, hairpin_energies& h
 
 double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequences) {
 
-	return MultiloopEnergy(size, sidelen, sequences, multiloop_dG);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return MultiloopEnergy(size, sidelen, sequences, multiloop_dG);
+
+	multiloopKey(*cache, 'M', size, sidelen, sequences);
+
+	if (!cache->find(energy)) {
+		energy = MultiloopEnergy(size, sidelen, sequences, multiloop_dG);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
 double NupackEnergyModel::MultiloopEnthalpy(int size, int *sidelen, char **sequences) {
 
-	return MultiloopEnergy(size, sidelen, sequences, multiloop_dH);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return MultiloopEnergy(size, sidelen, sequences, multiloop_dH);
+
+	multiloopKey(*cache, 'm', size, sidelen, sequences);
+
+	if (!cache->find(energy)) {
+		energy = MultiloopEnergy(size, sidelen, sequences, multiloop_dH);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
@@ -295,7 +361,7 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 	for (int loop = 0; loop < size; loop++) {
 
 		totallength += sidelen[loop];
-		pt = pairtypes[sequences[loopminus1][sidelen[loopminus1] + 1]][sequences[loop][0]] - 1;
+		pt = pairtypes_mfold[sequences[loopminus1][sidelen[loopminus1] + 1]][sequences[loop][0]] - 1;
 
 		if ((pt == 0) || (pt > 2)) { // AT penalty applies
 			energy += terminal_AU;
@@ -339,11 +405,11 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 	} else {
 
 		loopminus1 = size - 1;
-		pt = pairtypes[sequences[loopminus1][0]][sequences[loopminus1 - 1][sidelen[loopminus1 - 1] + 1]] - 1;
+		pt = pairtypes_mfold[sequences[loopminus1][0]][sequences[loopminus1 - 1][sidelen[loopminus1 - 1] + 1]] - 1;
 
 		for (int loop = 0; loop < size; loop++) {
 
-			rt_pt = pairtypes[sequences[loop][0]][sequences[loopminus1][sidelen[loopminus1] + 1]] - 1;
+			rt_pt = pairtypes_mfold[sequences[loop][0]][sequences[loopminus1][sidelen[loopminus1] + 1]] - 1;
 
 			if (!(dangles == DANGLES_SOME && sidelen[loopminus1] == 0)) {
 
@@ -372,13 +438,39 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 
 double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequences) {
 
-	return OpenloopEnergy(size, sidelen, sequences, multiloop_dG);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return OpenloopEnergy(size, sidelen, sequences, multiloop_dG);
+
+	openloopKey(*cache, 'O', size, sidelen, sequences);
+
+	if (!cache->find(energy)) {
+		energy = OpenloopEnergy(size, sidelen, sequences, multiloop_dG);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
 double NupackEnergyModel::OpenloopEnthalpy(int size, int *sidelen, char **sequences) {
 
-	return OpenloopEnergy(size, sidelen, sequences, multiloop_dH);
+	EnergyCache *cache = EnergyCache::active();
+	double energy;
+
+	if (cache == NULL)
+		return OpenloopEnergy(size, sidelen, sequences, multiloop_dH);
+
+	openloopKey(*cache, 'o', size, sidelen, sequences);
+
+	if (!cache->find(energy)) {
+		energy = OpenloopEnergy(size, sidelen, sequences, multiloop_dH);
+		cache->store(energy);
+	}
+
+	return energy;
 
 }
 
@@ -393,7 +485,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 	int pt, loop, rt_pt;
 
 	for (loop = 0; loop < size; loop++) {
-		pt = pairtypes[sequences[loop][sidelen[loop] + 1]][sequences[loop + 1][0]] - 1;
+		pt = pairtypes_mfold[sequences[loop][sidelen[loop] + 1]][sequences[loop + 1][0]] - 1;
 		// TODO: slight efficiency gain if we wrap this into the dangles version separately, rather than doing a double pass in the dangle case.
 
 		if ((pt == 0) || (pt > 2)) { // AT penalty applies
@@ -421,7 +513,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		double dangle3 = 0.0, dangle5 = 0.0;
 
 		// 5' most sequence's dangle3 component.
-		pt = pairtypes[sequences[1][0]][sequences[0][sidelen[0] + 1]] - 1;
+		pt = pairtypes_mfold[sequences[1][0]][sequences[0][sidelen[0] + 1]] - 1;
 
 		if (sidelen[0] == 0)
 			dangle3 = 0.0;
@@ -436,7 +528,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 
 		for (loop = 0; loop < size - 1; loop++) {
 
-			rt_pt = pairtypes[sequences[loop + 2][0]][sequences[loop + 1][sidelen[loop + 1] + 1]] - 1;
+			rt_pt = pairtypes_mfold[sequences[loop + 2][0]][sequences[loop + 1][sidelen[loop + 1] + 1]] - 1;
 			dangle5 = multiloop.dangle_5[pt][sequences[loop + 1][1]];
 			dangle3 = multiloop.dangle_3[rt_pt][sequences[loop + 1][sidelen[loop + 1]]];
 			if (dangles == DANGLES_SOME && sidelen[loop + 1] == 1) {
@@ -472,6 +564,99 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 	return energy;
 }
 
+// Keys for the EnergyCache: the sizes, and only those bases that the functions above read.
+// Single stranded stacking reads whole sides, so with it these are added in full.
+void NupackEnergyModel::hairpinKey(EnergyCache& cache, char kind, char *seq, int size) {
+
+	cache.begin(kind);
+	cache.add(size);
+
+	if (size <= 4 || simOptions->energyOptions->usingArrhenius()) {
+		cache.add(seq, size + 2);
+	} else {
+		cache.add(seq[0]);
+		cache.add(seq[1]);
+		cache.add(seq[size]);
+		cache.add(seq[size + 1]);
+	}
+
+}
+
+void NupackEnergyModel::interiorKey(EnergyCache& cache, char kind, char *seq1, char *seq2, int size1, int size2) {
+
+	cache.begin(kind);
+	cache.add(size1);
+	cache.add(size2);
+
+	if (simOptions->energyOptions->usingArrhenius()) {
+		cache.add(seq1, size1 + 2);
+		cache.add(seq2, size2 + 2);
+	} else {
+		cache.add(seq1[0]);
+		cache.add(seq1[1]);
+		cache.add(seq1[size1]);
+		cache.add(seq1[size1 + 1]);
+		cache.add(seq2[0]);
+		cache.add(seq2[1]);
+		cache.add(seq2[size2]);
+		cache.add(seq2[size2 + 1]);
+	}
+
+}
+
+void NupackEnergyModel::multiloopKey(EnergyCache& cache, char kind, int size, int *sidelen, char **sequences) {
+
+	bool stacking = simOptions->energyOptions->usingArrhenius();
+
+	cache.begin(kind);
+	cache.add(size);
+
+	for (int loop = 0; loop < size; loop++) {
+
+		char *side = sequences[loop];
+		cache.add(sidelen[loop]);
+
+		if (stacking && sidelen[loop] > 4) {
+			cache.add(side, sidelen[loop] + 2);
+		} else {
+			cache.add(side[0]);
+			cache.add(side[1]);
+			cache.add(side[sidelen[loop]]);
+			cache.add(side[sidelen[loop] + 1]);
+		}
+	}
+
+}
+
+// The first side has no closing base on its 5' end and the last none on its 3' end.
+void NupackEnergyModel::openloopKey(EnergyCache& cache, char kind, int size, int *sidelen, char **sequences) {
+
+	bool stacking = simOptions->energyOptions->usingArrhenius();
+
+	cache.begin(kind);
+	cache.add(size);
+
+	for (int loop = 0; loop <= size; loop++) {
+
+		char *side = sequences[loop];
+		cache.add(sidelen[loop]);
+
+		if (loop > 0)
+			cache.add(side[0]);
+		if (loop < size)
+			cache.add(side[sidelen[loop] + 1]);
+
+		if (sidelen[loop] > 0) {
+			cache.add(side[1]);
+			cache.add(side[sidelen[loop]]);
+		}
+
+		if (stacking && loop < size && sidelen[loop] > 4)
+			cache.add(side, sidelen[loop]);
+	}
+
+}
+
 // constructors, internal functions
 
 NupackEnergyModel::NupackEnergyModel(PyObject* energy_options) :
@@ -533,6 +718,44 @@ FILE* NupackEnergyModel::openFiles(char* nupackhome, string& paramPath, string&
 
 }
 
+// The parsed tables depend on the parameter files, the temperature and the salt only.
+// Files are identified by path, size and modification time, conditions by their exact bits.
+static string parameterKey(string *files, double temperature, double sodium, double magnesium) {
+
+	char buffer[128];
+	string key = "nupack 1";
+
+	for (int i = 0; i < 2; i++) {
+
+		struct stat info;
+		long size = 0, modified = 0;
+
+		if (stat(files[i].c_str(), &info) == 0) {
+			size = info.st_size;
+			modified = info.st_mtime;
+		}
+
+		snprintf(buffer, sizeof(buffer), " %ld %ld ", size, modified);
+		key += buffer + files[i];
+	}
+
+	snprintf(buffer, sizeof(buffer), " %a %a %a", temperature, sodium, magnesium);
+	key += buffer;
+
+	return key;
+
+}
+
+void NupackEnergyModel::snapshotFields(ParameterSnapshot::Fields& fields) {
+
+	fields = { { &stack_37_dG, sizeof(stack_37_dG) }, { &stack_37_dH, sizeof(stack_37_dH) }, { &hairpin_dG, sizeof(hairpin_dG) }, { &hairpin_dH,
+			sizeof(hairpin_dH) }, { &bulge_37_dG, sizeof(bulge_37_dG) }, { &bulge_37_dH, sizeof(bulge_37_dH) }, { &internal_dG, sizeof(internal_dG) }, {
+			&internal_dH, sizeof(internal_dH) }, { &multiloop_dG, sizeof(multiloop_dG) }, { &multiloop_dH, sizeof(multiloop_dH) }, { &terminal_AU,
+			sizeof(terminal_AU) }, { &terminal_AU_dH, sizeof(terminal_AU_dH) }, { &bimolecular_penalty, sizeof(bimolecular_penalty) }, {
+			&bimolecular_penalty_dH, sizeof(bimolecular_penalty_dH) } };
+
+}
+
 void NupackEnergyModel::processOptions() {
 
 	// 	This is the tough part, performing all read/input duties.
@@ -552,14 +775,6 @@ void NupackEnergyModel::processOptions() {
 	gtenable = myEnergyOptions->getGtenable();
 	kinetic_rate_method = myEnergyOptions->getKineticRateMethod();
 
-	for (loop = 0; loop < BASES; loop++)
-		pairs[loop] = pairs_mfold[loop];
-	for (loop = 0; loop < PAIRS_VIENNA; loop++)
-		basepair_sw[loop] = basepair_sw_mfold[loop];
-	for (loop = 0; loop < BASES; loop++)
-		for (loop2 = 0; loop2 < BASES; loop2++)
-			pairtypes[loop][loop2] = pairtypes_mfold[loop][loop2];
-
 	if (myEnergyOptions->compareSubstrateType(SUBSTRATE_INVALID)) {
 
 		PyObject *tmpStr = NULL;
@@ -607,6 +822,28 @@ void NupackEnergyModel::processOptions() {
 
 	}
 
+	ParameterSnapshot::Fields fields;
+	string snapshotKey;
+
+	if (fp2 != NULL) {
+
+		snapshotFields(fields);
+		snapshotKey = parameterKey(paramFiles, temperature, myEnergyOptions->sodium, myEnergyOptions->magnesium);
+
+		if (ParameterSnapshot::restore(snapshotKey, myEnergyOptions->snapshotDirectory, fields)) {
+
+			fclose(fp);
+			fclose(fp2);
+
+			log_loop_penalty = 100.0 * 1.75 * kBoltzmann * current_temp;
+			_RT = kBoltzmann * temperature;
+			numActiveNT = simOptions->initialActiveNT;
+
+			setupRates();
+			return;
+		}
+	}
+
 	fgets(in_buffer, 2048, fp);
 	while (!feof(fp)) {
 		if (in_buffer[0] == '>') // data area or comment (mfold)
@@ -974,6 +1211,9 @@ void NupackEnergyModel::processOptions() {
 
 	current_temp = temperature;
 
+	if (!snapshotKey.empty())
+		ParameterSnapshot::save(snapshotKey, myEnergyOptions->snapshotDirectory, fields);
+
 	//FD: adding cotranscriptional initialziation
 	numActiveNT = simOptions->initialActiveNT;
 
@@ -1549,4 +1789,8 @@ void NupackEnergyModel::setupRates() {
 
 	joinrate = biscale * eOptions->getJoinConcentration();
 
+	rateConstants.scale = uniscale;
+	rateConstants.RT = _RT;
+	selectRatePolicy();
+
 }
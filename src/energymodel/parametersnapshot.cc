@@ -0,0 +1,200 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the ParameterSnapshot found in parametersnapshot.h
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include "parametersnapshot.h"
+
+// A file is the header, the key and then the payload, the tables back to back.
+struct SnapshotHeader {
+	char magic[8];
+	uint64_t keyLength;
+	uint64_t payloadLength;
+	uint64_t checksum; // of the payload
+};
+
+static const char snapshotMagic[8] = { 'M', 'S', 'P', 'A', 'R', 'A', 'M', '2' };
+
+struct SnapshotImage {
+	const char *data;
+	size_t size;
+};
+
+// images live until the process exits, whether mapped or copied
+static std::mutex imagesLock;
+static std::map<string, SnapshotImage> images;
+
+static size_t payloadSize(const ParameterSnapshot::Fields& fields) {
+
+	size_t size = 0;
+
+	for (const ParameterSnapshot::Field& field : fields)
+		size += field.size;
+
+	return size;
+
+}
+
+// FNV-1a
+static uint64_t fingerprint(const char *data, size_t size) {
+
+	uint64_t hash = 14695981039346656037UL;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 1099511628211UL;
+	}
+
+	return hash;
+
+}
+
+// named by the fingerprint of the key, the key itself is checked after opening
+static string snapshotPath(const string& key, const string& directory) {
+
+	std::stringstream ss;
+	ss << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << fingerprint(key.data(), key.size()) << ".msp";
+
+	return ss.str();
+
+}
+
+static bool mapSnapshot(const string& key, const string& directory, size_t size, SnapshotImage& image) {
+
+	int fd = open(snapshotPath(key, directory).c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	size_t length = sizeof(SnapshotHeader) + key.size() + size;
+
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size != length) {
+		close(fd);
+		return false;
+	}
+
+	void *region = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (region == MAP_FAILED)
+		return false;
+
+	const char *base = (const char *) region;
+	const SnapshotHeader *header = (const SnapshotHeader *) base;
+
+	if (memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header->keyLength != key.size() || header->payloadLength != size
+			|| memcmp(base + sizeof(SnapshotHeader), key.data(), key.size()) != 0
+			|| header->checksum != fingerprint(base + sizeof(SnapshotHeader) + key.size(), size)) {
+		munmap(region, length);
+		return false;
+	}
+
+	image.data = base + sizeof(SnapshotHeader) + key.size();
+	image.size = size;
+
+	return true;
+
+}
+
+// Written under a name of its own and then renamed, so concurrent processes never map half a file.
+static void writeSnapshot(const string& key, const string& directory, const SnapshotImage& image) {
+
+	string target = snapshotPath(key, directory);
+	string temporary = target + ".tmp" + std::to_string((long) getpid());
+
+	FILE *fp = fopen(temporary.c_str(), "wb");
+
+	if (fp == NULL)
+		return;
+
+	SnapshotHeader header;
+	memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+	header.keyLength = key.size();
+	header.payloadLength = image.size;
+	header.checksum = fingerprint(image.data, image.size);
+
+	bool written = fwrite(&header, sizeof(header), 1, fp) == 1;
+	written = written && fwrite(key.data(), 1, key.size(), fp) == key.size();
+	written = written && fwrite(image.data, 1, image.size, fp) == image.size;
+	written = (fclose(fp) == 0) && written;
+
+	if (!written || rename(temporary.c_str(), target.c_str()) != 0)
+		remove(temporary.c_str());
+
+}
+
+bool ParameterSnapshot::restore(const string& key, const string& directory, const Fields& fields) {
+
+	size_t size = payloadSize(fields);
+	SnapshotImage image;
+
+	{
+		std::lock_guard<std::mutex> lock(imagesLock);
+
+		auto found = images.find(key);
+
+		if (found != images.end()) {
+			image = found->second;
+		} else if (!directory.empty() && mapSnapshot(key, directory, size, image)) {
+			images[key] = image;
+		} else {
+			return false;
+		}
+	}
+
+	if (image.size != size)
+		return false;
+
+	const char *position = image.data;
+
+	for (const Field& field : fields) {
+		memcpy(field.data, position, field.size);
+		position += field.size;
+	}
+
+	return true;
+
+}
+
+void ParameterSnapshot::save(const string& key, const string& directory, const Fields& fields) {
+
+	SnapshotImage image;
+	image.size = payloadSize(fields);
+
+	char *data = new char[image.size];
+	char *position = data;
+
+	for (const Field& field : fields) {
+		memcpy(position, field.data, field.size);
+		position += field.size;
+	}
+
+	image.data = data;
+
+	std::lock_guard<std::mutex> lock(imagesLock);
+
+	if (images.count(key)) {
+		delete[] data;
+		return;
+	}
+
+	images[key] = image;
+
+	if (!directory.empty())
+		writeSnapshot(key, directory, image);
+
+}
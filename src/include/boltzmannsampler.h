@@ -0,0 +1,102 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* BoltzmannSampler header. The partition function of a complex, and structures drawn from its
+ * Boltzmann distribution by stochastic traceback, on the parameters a NupackEnergyModel has
+ * loaded. This takes the place of the NUPACK sample binary for Complex.boltzmann_sample.
+ *
+ * Only connected, pseudoknot free structures of the complex in its given strand order are
+ * counted, with the loop energies of the model: hairpins, stacks, bulges and interior loops
+ * through the model functions, multiloops and open loops from the same terms as
+ * MultiloopEnergy and OpenloopEnergy, with exact dangles for every setting. As in NUPACK,
+ * interior loops are limited to 30 unpaired bases and the multiloop penalty is linear. The
+ * single stranded stacking of Arrhenius models is not counted in multiloops and open loops.
+ *
+ * Once built, sampling does not change the sampler and the loop energies bypass the
+ * EnergyCache, so threads can share one, each with its own RandomGenerator. */
+
+#ifndef __BOLTZMANNSAMPLER_H__
+#define __BOLTZMANNSAMPLER_H__
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+class NupackEnergyModel;
+class RandomGenerator;
+
+const int BOLTZMANN_MAX_INTERIOR = 30;
+
+class BoltzmannSampler {
+public:
+	// sequence: the strands in order, separated by '+'
+	BoltzmannSampler(NupackEnergyModel *model, const string& sequence);
+
+	double freeEnergy(void); // -RT ln Z, loop energies only
+	bool hasStructures(void); // false if no connected structure exists
+
+	// a structure in dot paren notation, with '+' between the strands
+	string sample(RandomGenerator& rng) const;
+
+private:
+	typedef long double weight;
+
+	inline int at(int i, int j) const {
+		return i * length + j;
+	}
+	inline int segment(int a, int b, int L, int R) const {
+		return (at(a, b) * 3 + L) * 3 + R;
+	}
+	inline int branch(int p, int b, int R, int s) const {
+		return (at(p, b) * 3 + R) * 2 + s;
+	}
+	inline bool noNick(int lo, int hi) const {
+		return hi < lo || nicksBefore[hi + 1] == nicksBefore[lo];
+	}
+
+	int pairType(int first, int second) const;
+	int slotOf(int position, int partner) const;
+
+	weight gap(int family, int a, int b, int L, int R) const;
+	weight terminal(int family, int i, int j) const;
+	weight hairpin(int i, int j) const;
+	weight interior(int i, int j, int p, int q) const;
+	weight multiloop(int i, int j) const;
+	weight openloop(int i, int j, int nick) const;
+
+	weight any(int family, int a, int b, int L, int R) const;
+	weight atLeastOne(int family, int a, int b, int L, int R) const;
+
+	void fill(void);
+
+	void samplePair(RandomGenerator& rng, int i, int j, string& structure) const;
+	void sampleAny(RandomGenerator& rng, int family, int a, int b, int L, int R, string& structure) const;
+	void sampleBranches(RandomGenerator& rng, int family, int a, int b, int L, int R, bool twoOrMore, string& structure) const;
+
+	NupackEnergyModel *model;
+	double RT;
+	int length;
+
+	vector<char> base; // codes, as in the loop graph
+	vector<int> nicksBefore; // number of strand ends before each position
+	vector<int> strandEnd; // the last base of each strand
+	vector<int> nickIndex; // the number of the strand that ends at a position, -1 if none
+
+	weight danglesFive[6][5], danglesThree[6][5]; // Boltzmann factors
+	vector<weight> unpaired; // of the multiloop base penalty, by length
+
+	// Qb, and over the segments of an exterior (0) or multi (1) loop, those with at least one
+	// branch, then per first branch, the sums over its partners
+	vector<weight> paired;
+	vector<weight> oneOrMore[2], twoOrMore;
+	vector<weight> firstBranch[2], firstOfTwo;
+
+	weight partition;
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* ComplexIndex class header. Sum trees over the complexes of an SComplexList, in the layout
+ * of LoopTree: one over their rates, one per half context and base over their exposed bases,
+ * and one per join class over the pairings of each complex with itself. With k complexes,
+ * the complex of the next unimolecular transition and both partners of the next join are
+ * chosen in O(log k), and a complex is updated in O(log k).
+ *
+ * A join class is a half context for either nucleotide and the base of the top nucleotide,
+ * A or G, so every pairing of exposed nucleotides is in exactly one class. Without Arrhenius
+ * rates there is a single context. The exposed bases are those of the entry snapshots, the
+ * same that SComplexList counts its join flux with. An entry with copies weighs as that many
+ * complexes, and its copies pair with each other. */
+
+#ifndef __COMPLEXINDEX_H__
+#define __COMPLEXINDEX_H__
+
+#include <vector>
+#include "moveutil.h"
+
+using std::vector;
+
+class SComplexListEntry;
+class EnergyModel;
+class SimTimer;
+
+class ComplexIndex {
+public:
+	ComplexIndex(EnergyModel *energyModel);
+
+	void clear(void);
+	void insert(SComplexListEntry *entry);
+	void remove(SComplexListEntry *entry);
+	void updateRate(SComplexListEntry *entry);
+	void updateExposed(SComplexListEntry *entry);
+
+	SComplexListEntry *getChoice(SimTimer& timer);
+	JoinCriteria getJoinChoice(SimTimer& timer, SComplexListEntry *partners[2]);
+
+private:
+	inline int baseTree(int context, int base) const {
+		return context * 4 + base - 1;
+	}
+	inline int joinClass(int top, int bottom, int base) const {
+		return (top * contexts + bottom) * 2 + (base == baseG);
+	}
+
+	long exposed(SComplexListEntry *entry, int context, int base);
+	double classRate(int top, int bottom);
+
+	void grow(void);
+	void setRate(int slot, double rate);
+	void setCount(vector<long>& tree, int slot, long value);
+	int findCount(vector<long>& tree, long& choice);
+
+	EnergyModel *eModel;
+	int contexts; // one per half context for Arrhenius rates, otherwise one
+
+	int capacity;
+	int used; // slots [0, used) have been handed out at least once
+	vector<double> rates; // rates[1] is the root, leaves start at rates[capacity]
+	vector<vector<long> > baseCounts; // per context and base
+	vector<vector<long> > selfPairs; // per join class
+	vector<SComplexListEntry*> entries;
+	vector<int> freeSlots;
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* EnergyCache class header. A bounded memo of loop energies, keyed by the part of the loop's
+ * sequence context that the energy model actually reads: sizes, closing pairs and the
+ * unpaired bases next to them (the whole sides when single stranded stacking applies).
+ *
+ * The table is direct mapped, a new context replaces whatever was stored in its slot.
+ * Every SimulationSystem owns a cache, the energy model uses the one set for the thread. */
+
+#ifndef __ENERGYCACHE_H__
+#define __ENERGYCACHE_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class EnergyCache {
+public:
+	EnergyCache(void);
+	EnergyCache(const EnergyCache&) = delete;
+	~EnergyCache(void);
+
+	void resize(long entries); // rounded up to a power of two, 0 disables the cache
+	void clear(void);
+
+	static void use(EnergyCache *cache);
+
+	// NULL when the thread has no enabled cache. While no cache is enabled anywhere,
+	// this is a single load, so the energy model pays nothing for a cache that is off.
+	static inline EnergyCache *active(void) {
+		if (enabled.load(std::memory_order_relaxed) == 0)
+			return NULL;
+		return threadCache();
+	}
+
+	// A key is built with begin/add, then either found or stored.
+	void begin(char kind);
+	inline void add(char c) {
+		key.push_back(c);
+	}
+	void add(int value);
+	void add(const char *bases, int length);
+
+	bool find(double& value);
+	void store(double value); // after a find that failed
+
+	long hits = 0;
+	long misses = 0;
+
+private:
+	struct Entry {
+		std::string key;
+		double value;
+	};
+
+	unsigned long slot(void) const;
+	static EnergyCache *threadCache(void);
+
+	thread_local static EnergyCache *current;
+	static std::atomic<long> enabled; // caches with entries, in any thread
+
+	std::string key;
+	std::vector<Entry> entries;
+	unsigned long mask = 0;
+	unsigned long found = 0; // slot of the last find
+};
+
+#endif
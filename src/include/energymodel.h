@@ -14,6 +14,8 @@
 #include <array>
 #include <moveutil.h>
 #include <sequtil.h>
+#include "parametersnapshot.h"
+#include "ratepolicy.h"
 
 using std::string;
 using std::array;
@@ -21,23 +23,20 @@ using std::array;
 class SimOptions;
 class Loop;
 class EnergyOptions;
+class EnergyCache;
 
 const int VIENNA = 0;
 const int MFOLD = 1;
 
 const int pairs_vienna[5] = { 0, 4, 3, 2, 1 };
 const int pairs_mfold[5] = { 0, 4, 3, 2, 1 };
-extern  int pairs[5];
 
 const int pairtypes_vienna[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 5 }, { 0, 0, 0, 1, 0 }, { 0, 0, 2, 0, 3 }, { 0, 6, 0, 4, 0 } };
 const int pairtypes_mfold[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 1 }, { 0, 0, 0, 2, 0 }, { 0, 0, 3, 0, 5 }, { 0, 4, 0, 6, 0 } };
 
-extern int pairtypes[5][5];
-
 const int basepair_sw_vienna[8] = { 0, 2, 1, 4, 3, 6, 5, 7 };
 const int basepair_sw_mfold[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
 const int basepair_sw_mfold_actual[8] = { 0, 4, 3, 2, 1, 6, 5, 7 }; // Why do this? Vienna's parameter file stores pairings in the opposite ordering. So for one of them, we need to swap basepairs to get the correct ordering, in the other one, we don't.
-extern  int basepair_sw[8]; // = {0,0,0,0,0,0,0,0};
 
 int baseLookup(char base);
 
@@ -69,7 +68,21 @@ public:
 	double saltCorrection(void);
 	void setArrheniusRate(double ratesArray[], EnergyOptions* options, double temperature, int left, int right);
 	void computeArrheniusRates(double temperature);
-	double applyPrefactors(double tempRate, MoveType left, MoveType right);
+	void selectRatePolicy(void); // again whenever inspection is switched
+	void fillJoinRates(void);
+	inline double applyPrefactors(double tempRate, MoveType left, MoveType right) {
+		return ratePolicy.prefactor(rateConstants, tempRate, left, right);
+	}
+	inline void returnRates(double start_energy, int count, const double *end_energies, double *rates) {
+		ratePolicy.rates(rateConstants, start_energy, count, end_energies, rates);
+	}
+	// the join rate with its prefactors, per pair of MoveTypes, or per top and bottom half context
+	inline double joinRateFor(MoveType left, MoveType right) {
+		return joinRates[left * MOVETYPE_SIZE + right];
+	}
+	inline double joinRateFor(QuartContext topLeft, QuartContext topRight, QuartContext botLeft, QuartContext botRight) {
+		return contextJoinRates[((topLeft * HALFCONTEXT_SIZE + topRight) * HALFCONTEXT_SIZE + botLeft) * HALFCONTEXT_SIZE + botRight];
+	}
 	MoveType getPrefactorsMulti(int, int, int[]);
 	MoveType prefactorOpen(int, int, int[]);
 	MoveType prefactorInternal(int, int);
@@ -129,6 +142,11 @@ public:
 protected:
 	long dangles;
 	double arrheniusRates[MOVETYPE_SIZE * MOVETYPE_SIZE];
+	double joinRates[MOVETYPE_SIZE * MOVETYPE_SIZE];
+	double contextJoinRates[HALFCONTEXT_SIZE * HALFCONTEXT_SIZE * HALFCONTEXT_SIZE * HALFCONTEXT_SIZE];
+
+	RatePolicy ratePolicy = makeFixedRatePolicy<InvalidPolicy>();
+	RateConstants rateConstants;
 
 };
 
@@ -178,6 +196,8 @@ struct multiloop_energies{
 
 class NupackEnergyModel: public EnergyModel {
 
+	friend class BoltzmannSampler; // sums over the loop parameters
+
 public:
 	NupackEnergyModel(void);
 	NupackEnergyModel(PyObject* options);
@@ -212,6 +232,7 @@ private:
 
 	void processOptions();
 	FILE* openFiles(char*, string&, string&, int);
+	void snapshotFields(ParameterSnapshot::Fields& fields); // the tables read from the parameter files
 
 	// FD jan 2018: helper functions, now seperated out
 	double HairpinEnergy(char *seq, int size, hairpin_energies&);
@@ -220,6 +241,11 @@ private:
 	double MultiloopEnergy(int size, int *sidelen, char **sequences, multiloop_energies& multiloop);
 	double OpenloopEnergy(int size, int *sidelen, char **sequences, multiloop_energies& multiloop);
 
+	void hairpinKey(EnergyCache& cache, char kind, char *seq, int size);
+	void interiorKey(EnergyCache& cache, char kind, char *seq1, char *seq2, int size1, int size2);
+	void multiloopKey(EnergyCache& cache, char kind, int size, int *sidelen, char **sequences);
+	void openloopKey(EnergyCache& cache, char kind, int size, int *sidelen, char **sequences);
+
 	// JS: All energy units are integers, in units of .01 kcal/mol, as used by ViennaRNA
 	// FD: In 2.0, the units changed to 0.01 kcal/mol for dH and kcal/mol for dG.
 	// FD: as of jan 2018, dH and dG are now both kcal/mol.
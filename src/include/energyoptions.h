@@ -79,6 +79,9 @@ public:
 	double sodium = 1.0;
 	double magnesium = 0.0;
 
+	// directory of binary parameter snapshots, empty to keep them in memory only
+	string snapshotDirectory;
+
 
 protected:
 
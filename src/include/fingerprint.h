@@ -0,0 +1,76 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* Fingerprint header. A 128-bit FNV-1a hash, used to identify states by their contents
+ * without keeping the contents around. Fields are added with their length, so moving
+ * characters from one field to the next gives a different fingerprint. */
+
+#ifndef __FINGERPRINT_H__
+#define __FINGERPRINT_H__
+
+#include <stdint.h>
+#include <string>
+
+struct Fingerprint {
+
+	uint64_t high = 0;
+	uint64_t low = 0;
+
+	bool operator==(const Fingerprint& other) const {
+		return high == other.high && low == other.low;
+	}
+
+};
+
+class FingerprintBuilder {
+public:
+	FingerprintBuilder(void) {
+		state = ((unsigned __int128) 0x6c62272e07bb0142UL << 64) | 0x62b821756295c58dUL;
+	}
+
+	inline void add(const char *data, size_t length) {
+
+		const unsigned __int128 prime = ((unsigned __int128) 0x0000000001000000UL << 64) | 0x000000000000013BUL;
+
+		for (size_t i = 0; i < length; i++) {
+			state ^= (unsigned char) data[i];
+			state *= prime;
+		}
+	}
+
+	inline void add(uint64_t value) {
+		add((const char*) &value, sizeof(value));
+	}
+
+	inline void add(const std::string& field) {
+		add((uint64_t) field.size());
+		add(field.data(), field.size());
+	}
+
+	Fingerprint get(void) const {
+		Fingerprint output;
+		output.high = (uint64_t) (state >> 64);
+		output.low = (uint64_t) state;
+		return output;
+	}
+
+private:
+	unsigned __int128 state;
+};
+
+namespace std {
+
+template<> struct hash<Fingerprint> {
+	size_t operator()(const Fingerprint& k) const {
+
+		return k.low ^ (k.high * 0x9e3779b97f4a7c15UL);
+
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* FlatComplex class header. A second engine for the state of a complex, selected through the
+ * state_engine option. Instead of a graph of Loop objects, the state is held in contiguous
+ * arrays: a pair table, the loop that each base lies in, and per loop its side lengths and
+ * side sequences (the same arrays the energy model takes). Transitions are the base pair
+ * creations and deletions of the loop graph, with rates from the same energy calls, kept
+ * in a sum tree over the loops.
+ *
+ * Loops are identified by the 5' base of their closing pair, the exterior loop by the
+ * length of the strand. The engine covers a single strand that is alone in the system:
+ * it has no joins or splits, so any other system keeps the loop graph. */
+
+#ifndef __FLATCOMPLEX_H__
+#define __FLATCOMPLEX_H__
+
+#include <vector>
+#include "move.h"
+#include "moveutil.h"
+
+// State engines, selected through the state_engine option.
+const int STATEENGINE_LOOPS = 0;
+const int STATEENGINE_FLAT = 1;
+
+class StrandOrdering;
+class EnergyModel;
+class SimTimer;
+
+class FlatComplex {
+public:
+	FlatComplex(StrandOrdering *ordering);
+	FlatComplex(const FlatComplex& original, StrandOrdering *ordering); // for the copy of the strand
+
+	void generateMoves(void);
+	double getTotalFlux(void);
+	uint16_t getMoveCount(void);
+	double getEnergy(void);
+	double getEnthalpy(void);
+	BaseCount& getExteriorBases(void);
+	OpenInfo& getOpenInfo(void);
+
+	Move *getChoice(SimTimer& timer);
+	void doChoice(Move *move); // also updates the structure held by the ordering
+	void listMoves(std::vector<BasePairMove>& output);
+
+private:
+	struct Creation {
+		int first, second;
+		RateEnv rate;
+	};
+
+	inline char *base(int index) {
+		return &code[index + 1];
+	}
+	inline int indexOf(char *position) {
+		return position - &code[1];
+	}
+	inline bool isOpen(int loop) {
+		return loop == length;
+	}
+
+	void describe(int loop);
+	double loopEnergy(bool open, int count, int *sidelen, char **seqs, bool enthalpy = false);
+	MoveType context(bool open, int count, int *sidelen, int pair);
+
+	void generateCreations(int loop);
+	void generateDeletion(int first);
+	void relabel(int loop, int from, int to);
+	void refreshLoop(int loop);
+	void setLeaf(int slot);
+
+	StrandOrdering *ordering;
+	EnergyModel *energyModel;
+	int length;
+
+	std::vector<char> code; // code sequence padded with a zero on either side
+	std::vector<int> pairs; // partner of each base, -1 if unpaired
+	std::vector<int> loopOf; // loop of each unpaired base, paired bases belong to the loop outside their pair
+
+	// per loop
+	std::vector<double> energy;
+	std::vector<std::vector<int>> sideLength;
+	std::vector<std::vector<char*>> sideSeq;
+	std::vector<std::vector<int>> branches; // 5' base of every pair of the loop, the closing pair first
+	std::vector<std::vector<Creation>> creations;
+	std::vector<double> creationRate;
+
+	// per pair, at its 5' base
+	std::vector<RateEnv> deletion;
+
+	int capacity;
+	std::vector<double> tree; // tree[1] is the root, leaf k of loop / pair k at tree[capacity + k]
+
+	std::vector<int> mergedLength; // scratch for the sides of candidate loops
+	std::vector<char*> mergedSeq;
+	std::vector<int> innerLength;
+	std::vector<char*> innerSeq;
+	std::vector<double> endEnergy; // scratch for the rates of the creations of a loop
+	std::vector<MoveType> leftContext;
+	std::vector<MoveType> rightContext;
+	std::vector<double> rates;
+
+	Move choice;
+	BaseCount exteriorBases;
+	bool exteriorCounted = false;
+	OpenInfo openInfo;
+};
+
+#endif
@@ -10,7 +10,9 @@ help@multistrand.org
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include "energymodel.h"
+#include "looppool.h"
 #include "move.h"
 #include "moveutil.h"
 //#include "simtimer.h"
@@ -18,6 +20,26 @@ help@multistrand.org
 using std::vector;
 
 class EnergyOptions;
+class Loop;
+
+// Maps the bases and loops of a complex onto those of its copy, see StrandComplex::copy.
+class LoopCopier {
+public:
+	void addStrand(char *original, char *copy, int size);
+	char *base(char *original); // a pointer into the code sequence of a strand, or one before it
+	void addLoop(Loop *original, Loop *copy);
+	Loop *loop(Loop *original);
+
+private:
+	struct Strand {
+		char *original;
+		char *copy;
+		int size;
+	};
+
+	vector<Strand> strands;
+	std::unordered_map<Loop*, Loop*> loops;
+};
 
 struct RateArr {
 
@@ -46,6 +68,8 @@ public:
 	char getType(void);
 	Loop(void);
 	virtual ~Loop(void);
+	static void *operator new(size_t size); // loops are recycled through the current LoopPool
+	static void operator delete(void *block);
 	virtual void calculateEnergy(void) = 0;
 	virtual void calculateEnthalpy(void){};	// TODO: implement this.
 	virtual void generateMoves(void) = 0;
@@ -53,7 +77,10 @@ public:
 	virtual Move *getChoice(SimTimer& timer, Loop *from) = 0;
 	virtual double doChoice(Move *move, Loop **returnLoop) = 0;
 	virtual char *getLocation(Move *move, int index) =0;
+	virtual char *getLastBase(void) = 0; // the 3'-most base of the loop, closing bases included
 	virtual char *verifyLoop(char *incoming_sequence, Loop *from) =0;
+	virtual Loop *copy(LoopCopier& copier) = 0; // the same loop on the bases of the copy, without its links
+	void linkCopy(LoopCopier& copier); // gives the copy of this loop its adjacent loops and moves
 	virtual string typeInternalsToString(void) = 0;
 	virtual void printMove(Loop *comefrom, char *structure_p, char *seq_p) = 0;
 	Loop *getAdjacent(int index);
@@ -82,13 +109,30 @@ public:
 	string toString(void);
 	string toStringShort(void);
 	void printAllMoves(Loop*);
+	void listAllMoves(Loop*, std::vector<Move*>& output);
 	void generateAndSaveDeleteMove(Loop*, int);
 
+	// cotranscriptional mode: every base is behind the frozen window, and the loop is left out of the LoopTree
+	inline void freeze(void) {
+		frozen = true;
+	}
+	inline bool isFrozen(void) {
+		return frozen;
+	}
+
 	// FD: moving private to public
 	int numAdjacent;
 
+	friend class LoopTree;
+
 protected:
-	static EnergyModel *energyModel;
+	// Static as the loops have always read it, rather than a member of every loop, but per
+	// thread, so that worker threads can each simulate with their own model. A thread sets it
+	// before it builds complexes, SimulationSystem::InitializeSystem asserts that it did.
+	static thread_local EnergyModel *energyModel;
+	static MoveContainer *newMoveContainer(int initial_size);
+	void resetMoves(int initial_size); // empty the move container, creating it if needed
+	Loop *copyState(Loop *original); // the energies, rate and flags of the original, returns this
 
 	Loop** adjacentLoops;
 	int curAdjacent;
@@ -100,6 +144,8 @@ protected:
 	MoveContainer *moves;
 	char identity;
 	int add_index;
+	int treeIndex = -1; // slot in the owning complex's LoopTree, -1 if not indexed
+	bool frozen = false;
 };
 
 class StackLoop: public Loop {
@@ -112,7 +158,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence,  Loop *from);
+	Loop *copy(LoopCopier& copier);
 	friend RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end);
 	friend Loop * Loop::performDeleteMove(Move *move);
 	friend void Loop::performComplexSplit(Move *move, Loop **firstOpen, Loop **secondOpen);
@@ -134,7 +182,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence,  Loop *from);
+	Loop *copy(LoopCopier& copier);
 
 	HairpinLoop(void);
 	HairpinLoop( int size, char *hairpin_sequence, Loop *previous = NULL);
@@ -158,7 +208,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence, Loop *from);
+	Loop *copy(LoopCopier& copier);
 	BulgeLoop(void);
 	BulgeLoop(int size1, int size2, char *bulge_sequence1, char *bulge_sequence2, Loop *left = NULL, Loop *right = NULL);
 	friend Loop * Loop::performDeleteMove(Move *move);
@@ -181,7 +233,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence,  Loop *from);
+	Loop *copy(LoopCopier& copier);
 	InteriorLoop(void);
 	InteriorLoop(int size1, int size2, char *int_seq1, char *int_seq2, Loop *left = NULL, Loop *right = NULL);
 
@@ -205,7 +259,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence, Loop *from);
+	Loop *copy(LoopCopier& copier);
 	MultiLoop(void);
 	MultiLoop(int branches, int *sidelengths, char **sequences);
 	~MultiLoop(void);
@@ -230,7 +286,9 @@ public:
 	double doChoice(Move *move, Loop **returnLoop);
 	void printMove(Loop *comefrom, char *structure_p, char *seq_p);
 	char *getLocation(Move *move, int index);
+	char *getLastBase(void);
 	char *verifyLoop(char *incoming_sequence,  Loop *from);
+	Loop *copy(LoopCopier& copier);
 
 	// OpenLoop::getFreeBases returns the base composition information for the
 	//   open loop. Return form is a pointer to an array of size 5, containing
@@ -249,6 +307,7 @@ public:
 	// check for cotranscriptional folding.
 	bool nucleotideIsActive(const char* sequence, const char* initial, const int pos);
 	bool nucleotideIsActive(const char* sequence, const char* initial, const int pos1, const int pos2);
+	bool holdsNewestNucleotide(void);
 
 	char* getBase(char type, int index);
 	char* getBase(char type, int index, HalfContext);
@@ -0,0 +1,61 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* LoopPool class header. Every SimulationSystem owns a pool that recycles the memory of
+ * its loops and of their side length / sequence arrays, which are created and destroyed
+ * on nearly every transition. Blocks are kept on free lists per size class, so that a
+ * loop of a given type, or an array for a few branches, reuses a block freed earlier. */
+
+#ifndef __LOOPPOOL_H__
+#define __LOOPPOOL_H__
+
+#include <stddef.h>
+#include <vector>
+
+const int LOOPPOOL_GRANULE = 16;
+const int LOOPPOOL_CLASSES = 32; // blocks up to 512 bytes are pooled, larger ones use the heap
+const int LOOPPOOL_CHUNK = 65536;
+
+class LoopPool {
+public:
+	LoopPool(void);
+	~LoopPool(void);
+
+	// Blocks are taken from the pool of the calling thread, see use(). Every block remembers
+	// its pool, so it can be released from anywhere as long as that pool still exists.
+	static void *allocate(size_t size);
+	static void release(void *block);
+
+	static void use(LoopPool *pool); // NULL: allocate from the heap
+
+private:
+	struct Header {
+		LoopPool *pool;
+		int sizeClass;
+	};
+
+	void *take(int sizeClass);
+	void give(Header *header);
+
+	thread_local static LoopPool *current;
+
+	void *freeBlocks[LOOPPOOL_CLASSES + 1];
+	char *cursor;
+	char *chunkEnd;
+	std::vector<char*> chunks;
+};
+
+// Side length and sequence arrays owned by MultiLoop and OpenLoop.
+template<class T>
+inline T *poolArray(int size) {
+	return (T *) LoopPool::allocate(size * sizeof(T));
+}
+
+inline void poolFree(void *array) {
+	LoopPool::release(array);
+}
+
+#endif
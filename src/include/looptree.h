@@ -0,0 +1,46 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* LoopTree class header. A sum tree over the loops of a single complex, used to
+ * select the loop that contains the next transition in O(log n), and to report the
+ * total flux of the complex without walking the loop graph. Frozen loops are indexed with
+ * a zero rate. */
+
+#ifndef __LOOPTREE_H__
+#define __LOOPTREE_H__
+
+#include <vector>
+
+class Loop;
+class Move;
+class SimTimer;
+
+class LoopTree {
+public:
+	LoopTree(void);
+
+	void clear(void);
+	void rebuild(Loop *beginLoop); // re-index every loop reachable from beginLoop
+	void insert(Loop *loop);
+	void remove(Loop *loop);
+	void update(Loop *loop); // refresh the rate of a loop that is already indexed
+	void updateRegion(Loop *newLoop); // index new loops reachable from newLoop, refresh their neighbours
+
+	double getRate(void);
+	Move *getChoice(SimTimer& timer);
+
+private:
+	void grow(void);
+	void setLeaf(int slot, double rate);
+
+	int capacity;
+	int used; // slots [0, used) have been handed out at least once
+	std::vector<double> rates; // rates[1] is the root, leaves start at rates[capacity]
+	std::vector<Loop*> loops;
+	std::vector<int> freeSlots;
+};
+
+#endif
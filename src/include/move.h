@@ -17,13 +17,19 @@ const int MOVE_1 = 8;
 const int MOVE_2 = 16;
 const int MOVE_3 = 32;
 
+// Move containers, selected through the move_container option.
+const int MOVECONTAINER_LIST = 0;
+const int MOVECONTAINER_INDEXED = 1;
+
 #include <string>
+#include <vector>
 #include <moveutil.h>
 #include "simtimer.h"
 
 using std::string;
 
 class Loop;
+class LoopCopier;
 class EnergyModel;
 
 class RateEnv {
@@ -50,11 +56,12 @@ public:
 	Move(int mtype, RateEnv mrate, Loop *affected_1, Loop *affected_2, int index1, int index2RateEnv);
 	Move(int mtype, RateEnv mrate, Loop *affected_1, Loop *affected_2, int index1RateEnv);
 	~Move(void);
-	double getRate(void);
-	int getType(void);
+	double getRate(void) const;
+	int getType(void) const;
 	int getArrType(void);
 	Loop *getAffected(int index);
 	Loop *doChoice(void);
+	void relink(LoopCopier& copier); // affect the copies of the loops instead
 	string toString(bool);
 
 	friend class Loop;
@@ -65,6 +72,8 @@ public:
 	friend class OpenLoop;
 	friend class BulgeLoop;
 	friend class StrandComplex;
+	friend class FlatComplex;
+	friend class MoveBatch;
 protected:
 	int type;
 
@@ -74,11 +83,13 @@ protected:
 
 };
 
+// Containers own their moves by value, in storage that is kept when a loop regenerates its moves.
 class MoveContainer {
 public:
 	MoveContainer(void);
 	virtual ~MoveContainer(void);
-	virtual void addMove(Move *newmove) = 0;
+	virtual void addMove(const Move& newmove) = 0;
+	virtual void clear(void) = 0; // drops every move, keeps the storage
 	double getRate(void);
 
 	virtual void resetDeleteMoves(void) = 0;
@@ -86,6 +97,8 @@ public:
 	virtual Move *getMove(Move *iterator) = 0;
 	virtual uint16_t getCount(void) = 0;
 	virtual void printAllMoves(bool) = 0;
+	virtual void listAllMoves(std::vector<Move*>& output) = 0; // appends every move, the deletion moves last
+	virtual MoveContainer *copy(LoopCopier& copier) = 0; // the same moves, on the copies of their loops
 
 protected:
 	double totalrate;
@@ -96,17 +109,20 @@ class MoveList: public MoveContainer {
 public:
 	MoveList(int initial_size);
 	~MoveList(void);
-	void addMove(Move *newmove);
+	void addMove(const Move& newmove);
+	void clear(void);
 	Move *getChoice(SimTimer& timer);
 	Move *getMove(Move *iterator);
 	uint16_t getCount(void);
 	void resetDeleteMoves(void);
 	void printAllMoves(bool);
+	void listAllMoves(std::vector<Move*>& output);
+	MoveContainer *copy(LoopCopier& copier);
 
 	//  friend class Move;
 private:
-	Move **moves;
-	Move **del_moves;
+	Move *moves;
+	Move *del_moves;
 	uint16_t moves_size;
 	uint16_t moves_index;
 	uint16_t del_moves_size;
@@ -114,4 +130,46 @@ private:
 	uint16_t int_index;
 };
 
+// Keeps the running sum of the creation rates next to the moves, so a choice is a binary
+// search instead of a linear scan. Moves are chosen in the same order as in MoveList:
+// creation moves first, then the (at most a handful of) deletion moves.
+class IndexedMoveList: public MoveContainer {
+public:
+	IndexedMoveList(int initial_size);
+	~IndexedMoveList(void);
+	void addMove(const Move& newmove);
+	void clear(void);
+	Move *getChoice(SimTimer& timer);
+	Move *getMove(Move *iterator);
+	uint16_t getCount(void);
+	void resetDeleteMoves(void);
+	void printAllMoves(bool);
+	void listAllMoves(std::vector<Move*>& output);
+	MoveContainer *copy(LoopCopier& copier);
+
+private:
+	std::vector<Move> moves;
+	std::vector<double> prefix; // prefix[i] is the summed rate of moves[0..i]
+	std::vector<Move> del_moves;
+	unsigned int int_index;
+};
+
+// Creation moves of a loop are collected with the energy of the state they lead to, then
+// their rates are computed in one pass and the moves are handed to the container in order.
+class MoveBatch {
+public:
+	void clear(void);
+	void add(const Move& move, double energy, MoveType left, MoveType right);
+	void flush(EnergyModel *model, double startEnergy, MoveContainer *container);
+
+	static MoveBatch& local(void); // scratch batch of the calling thread
+
+private:
+	std::vector<Move> moves;
+	std::vector<double> energies;
+	std::vector<MoveType> left;
+	std::vector<MoveType> right;
+	std::vector<double> rates;
+};
+
 #endif
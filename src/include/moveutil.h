@@ -24,6 +24,14 @@ enum MoveType {
 	endMove, loopMove, stackMove, stackStackMove, loopEndMove, stackEndMove, stackLoopMove, MOVETYPE_SIZE
 };
 
+// A transition of a complex: the base pair it creates or deletes, by the index of its
+// bases in the flat sequence of the complex, and its rate.
+struct BasePairMove {
+	bool create;
+	int first, second;
+	double rate;
+};
+
 enum QuartContext {
 	endC, strandC, stackC, HALFCONTEXT_SIZE
 };
@@ -88,38 +96,6 @@ struct ExportFinal {
 
 };
 
-struct ExportTransition {
-
-	ExportData state1, state2;
-	double type;
-
-	bool operator==(const ExportTransition &other) const {
-		return (type == other.type && state1 == other.state1 && state2 == other.state2);
-	}
-
-	friend std::ostream & operator<<(std::ostream& str, const ExportTransition& k);
-};
-
-namespace std {
-
-template<> struct hash<ExportData> {
-	size_t operator()(const ExportData& k) const {
-
-		return hash<string>()(k.sequence) ^ hash<string>()(k.structure) ^ hash<int>()(k.id);
-
-	}
-};
-
-template<> struct hash<ExportTransition> {
-	size_t operator()(const ExportTransition& k) const {
-
-		return hash<ExportData>()(k.state1) ^ hash<ExportData>()(k.state2) ^ hash<int>()(k.type);
-
-	}
-};
-
-}
-
 struct HalfContext {
 
 	HalfContext();
@@ -150,6 +126,9 @@ struct JoinCriteria {
 
 // This struct contains info computed
 // at-time-of-creation for the OpenLoop object.
+// The exposed bases are tallied per half context, indexed [left][right], in place.
+
+typedef array<array<BaseCount, HALFCONTEXT_SIZE>, HALFCONTEXT_SIZE> ContextTally;
 
 struct OpenInfo {
 
@@ -158,14 +137,18 @@ public:
 	void clear(void);
 	void increment(QuartContext, char, QuartContext);
 	void increment(HalfContext, BaseCount&);
-	void increment(OpenInfo&);
+	void increment(OpenInfo&, int times = 1);
 
 	void decrement(HalfContext, BaseCount&);
-	void decrement(OpenInfo&);
+	void decrement(OpenInfo&, int times = 1);
 
 	double crossRate(OpenInfo&, EnergyModel&);
 
-	map<HalfContext, BaseCount> tally;
+	inline BaseCount& get(const HalfContext& con) {
+		return tally[con.left][con.right];
+	}
+
+	ContextTally tally;
 
 	int numExposedInternal = 0;
 	int numExposed = 0;
@@ -45,6 +45,7 @@ class identList {
 
   // Functions
   void  make_unique( strandList *strands);
+  identList *copy(void);
   std::string toString(void);
 
   // public variables.
@@ -70,6 +71,8 @@ class complexItem {
   char *structure;
   int type;
   int count; // for use with percentage or count stop types
+  int id_count = 0; // number of strands, filled in by StopConditions
+  int trackIndex = -1; // structure target in StopConditions, -1 if compared as a string
   class identList *strand_ids;
   class complexItem *next;
 };
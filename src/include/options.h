@@ -145,6 +145,10 @@ help@multistrand.org
 #define pushTransitionInfo( options_obj, obj ) \
   _m_pushList( options_obj, obj, add_transition_info )
 
+// This macro DECREFs the passed obj once it's done with it.
+#define pushResultArrays( options_obj, obj ) \
+  _m_pushList( options_obj, obj, add_result_arrays )
+
 #endif  // DEBUG_MACROS is FALSE (not set).
 
 /***************************************************
@@ -288,6 +292,10 @@ help@multistrand.org
 #define pushTransitionInfo( options_obj, obj ) \
   _m_d_pushList( options_obj, obj, add_transition_info )
 
+// This macro DECREFs the passed obj once it's done with it.
+#define pushResultArrays( options_obj, obj ) \
+  _m_d_pushList( options_obj, obj, add_result_arrays )
+
 #endif
 
 /*****************************************************
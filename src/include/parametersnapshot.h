@@ -0,0 +1,40 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* ParameterSnapshot header. The energy tables of a NupackEnergyModel, after parsing the
+ * parameter files and scaling them to the temperature and salt, as one binary image.
+ *
+ * Images are kept for the lifetime of the process, so every energy model built for the same
+ * conditions copies its tables from memory instead of parsing the files again. When a
+ * directory is given, images are also written there on first use and mapped from there by
+ * later processes (MergeSim children, repeated scripts). A file holds its key and a checksum
+ * of the tables, an image is used only if the key, the layout and the checksum match. */
+
+#ifndef __PARAMETERSNAPSHOT_H__
+#define __PARAMETERSNAPSHOT_H__
+
+#include <string>
+#include <vector>
+
+using std::string;
+
+class ParameterSnapshot {
+public:
+	// the tables an image covers, in order
+	struct Field {
+		void *data;
+		size_t size;
+	};
+	typedef std::vector<Field> Fields;
+
+	// Fills the fields from the image for key, false if there is none.
+	static bool restore(const string& key, const string& directory, const Fields& fields);
+
+	// Keeps the fields as the image for key, and writes it to the directory if one is given.
+	static void save(const string& key, const string& directory, const Fields& fields);
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* PassageTimeSolver header. Mean first passage times over a statespace collected by the
+ * Builder (builder.py), from its tables of states and transitions.
+ *
+ * Every transition is taken in both directions, at the rates of BuilderRate: Metropolis or
+ * Arrhenius, from the free energies of its states and the half contexts of the move. The
+ * rate matrix Q over the states that are not final is assembled in compressed rows, and
+ * Q t = -1 is solved with a preconditioned Krylov method. Transitions into a final state
+ * only leave the diagonal, so the times of final states are 0. */
+
+#ifndef __PASSAGETIME_H__
+#define __PASSAGETIME_H__
+
+#include <stdint.h>
+#include <vector>
+#include "moveutil.h"
+
+using std::vector;
+
+// the kind of a transition, as transitiontype.array in builder.py
+const int PASSAGE_UNIMOLECULAR = 0;
+const int PASSAGE_BIMOLECULAR_IN = 1;
+const int PASSAGE_BIMOLECULAR_OUT = 2;
+
+const int PASSAGE_BICGSTAB = 0;
+const int PASSAGE_GMRES = 1;
+
+const int PASSAGE_JACOBI = 0;
+const int PASSAGE_ILU0 = 1;
+
+// restart length of GMRES
+const int PASSAGE_GMRES_RESTART = 50;
+
+struct PassageRates {
+	double RT = 1.0;
+	double uniScale = 1.0;
+	double biScale = 1.0;
+	double concentration = 1.0;
+	double rateLimit = 1e-5; // rates at or below this are left out
+	bool arrhenius = false;
+	double lnA[MOVETYPE_SIZE] = { 0.0 };
+	double E[MOVETYPE_SIZE] = { 0.0 };
+};
+
+class PassageTimeSolver {
+public:
+	PassageTimeSolver(int threads);
+
+	// States have a free energy and are final or not, transitions have a kind and, for
+	// Arrhenius rates, the MoveType of either half context.
+	void build(const PassageRates& rates, long stateCount, const double *energy, const uint8_t *final, long transitionCount,
+			const uint32_t *source, const uint32_t *target, const int8_t *kind, const int8_t *left, const int8_t *right);
+
+	// Fills times for every state, true if the relative residual came below the tolerance.
+	bool solve(int method, int preconditioner, double tolerance, long maxIterations, double *times);
+
+	long rowCount(void);
+	long entryCount(void);
+
+	long iterations = 0;
+	double residual = 0.0;
+
+private:
+	void addRate(long from, long to, double rate);
+	void multiply(const double *x, double *y);
+	void factorize(void);
+	void precondition(const double *r, double *z);
+
+	bool solveBiCGStab(double tolerance, long maxIterations, double *x);
+	bool solveGMRES(double tolerance, long maxIterations, double *x);
+
+	double dot(const double *x, const double *y);
+	double norm(const double *x);
+
+	int threads;
+	int preconditioner = PASSAGE_JACOBI;
+
+	vector<long> row; // row of every state, -1 for final states
+	vector<long> stateOf; // state of every row
+
+	// the matrix in compressed rows, the columns of a row in order
+	vector<long> rowStart;
+	vector<long> column;
+	vector<double> value;
+	vector<long> diagonalAt;
+
+	vector<double> factor; // ILU(0) factors, on the entries of the matrix
+	vector<double> inverseDiagonal;
+
+	// triplets while the matrix is assembled
+	vector<long> entryRow, entryColumn;
+	vector<double> entryValue;
+	vector<double> diagonal;
+};
+
+#endif
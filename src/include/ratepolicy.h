@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* Rate policies. Each rate method is a policy that gives the rate of a unimolecular move from
+ * its energy change, and applies the prefactor of the move's local context. The kernels below
+ * are instantiated for every policy, and the energy model picks the set for its options once,
+ * so the rate of a move is computed without branching on the rate method. */
+
+#ifndef __RATEPOLICY_H__
+#define __RATEPOLICY_H__
+
+#include <math.h>
+#include <algorithm>
+#include "moveutil.h"
+
+struct RateConstants {
+	double scale = 1.0; // unimolecular scaling
+	double RT = 1.0;
+	const double *prefactors = NULL; // Arrhenius rates, MOVETYPE_SIZE by MOVETYPE_SIZE
+};
+
+struct MetropolisPolicy {
+	static inline double exponent(double dE, double RT) {
+		return (dE < 0) ? 0.0 : -dE / RT;
+	}
+	static inline double prefactor(const RateConstants&, double rate, int) {
+		return rate;
+	}
+};
+
+struct KawasakiPolicy {
+	static inline double exponent(double dE, double RT) {
+		return -0.5 * dE / RT;
+	}
+	static inline double prefactor(const RateConstants&, double rate, int) {
+		return rate;
+	}
+};
+
+// Metropolis acceptance, scaled by the rates of the contexts on either side of the pair
+struct ArrheniusPolicy {
+	static inline double exponent(double dE, double RT) {
+		return (dE < 0) ? 0.0 : -dE / RT;
+	}
+	static inline double prefactor(const RateConstants& c, double rate, int context) {
+		return rate * c.prefactors[context];
+	}
+};
+
+// every transition at rate 1.0, used to explore the statespace
+struct InspectionPolicy {
+	static const double value;
+	static inline double prefactor(const RateConstants&, double, int) {
+		return 1.0;
+	}
+};
+
+// an unknown rate method, rates are flagged as invalid
+struct InvalidPolicy {
+	static const double value;
+	static inline double prefactor(const RateConstants&, double rate, int) {
+		return rate;
+	}
+};
+
+template<class Policy>
+double policyRate(const RateConstants& c, double start, double end) {
+
+	return c.scale * exp(Policy::exponent(end - start, c.RT));
+
+}
+
+// The exponents first, then the exponentials over a contiguous array.
+template<class Policy>
+void policyRates(const RateConstants& c, double start, int count, const double *end, double *rates) {
+
+	for (int i = 0; i < count; i++)
+		rates[i] = Policy::exponent(end[i] - start, c.RT);
+
+	for (int i = 0; i < count; i++)
+		rates[i] = c.scale * exp(rates[i]);
+
+}
+
+// policies that do not depend on the energy
+template<class Policy>
+double fixedRate(const RateConstants&, double, double) {
+
+	return Policy::value;
+
+}
+
+template<class Policy>
+void fixedRates(const RateConstants&, double, int count, const double*, double *rates) {
+
+	std::fill(rates, rates + count, Policy::value);
+
+}
+
+template<class Policy>
+double policyPrefactor(const RateConstants& c, double rate, MoveType left, MoveType right) {
+
+	return Policy::prefactor(c, rate, left * MOVETYPE_SIZE + right);
+
+}
+
+struct RatePolicy {
+	double (*rate)(const RateConstants&, double start, double end);
+	void (*rates)(const RateConstants&, double start, int count, const double *end, double *rates);
+	double (*prefactor)(const RateConstants&, double rate, MoveType left, MoveType right);
+};
+
+template<class Policy>
+RatePolicy makeRatePolicy(void) {
+
+	RatePolicy policy = { &policyRate<Policy>, &policyRates<Policy>, &policyPrefactor<Policy> };
+	return policy;
+
+}
+
+template<class Policy>
+RatePolicy makeFixedRatePolicy(void) {
+
+	RatePolicy policy = { &fixedRate<Policy>, &fixedRates<Policy>, &policyPrefactor<Policy> };
+	return policy;
+
+}
+
+#endif
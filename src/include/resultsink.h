@@ -0,0 +1,46 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* ResultSink class header. With the native_results option, the outcome of every trajectory
+ * is kept here in columns, instead of being handed to Python as a tuple per trajectory.
+ * The columns go to Python in chunks, as bytes objects that the interface views as numpy
+ * arrays. Tags are stored as indices into a table of the tags seen so far. */
+
+#ifndef __RESULTSINK_H__
+#define __RESULTSINK_H__
+
+#include <Python.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// results are handed over once this many are kept
+const long RESULTSINK_CHUNK = 1 << 20;
+
+class ResultSink {
+public:
+	void add(long seed, int type, double time, double rate, const char *tag);
+	long size(void);
+
+	// A new tuple (seeds, types, times, rates, tags, tag names), the columns are cleared.
+	PyObject* take(void);
+
+private:
+	vector<int64_t> seeds;
+	vector<int32_t> types;
+	vector<double> times;
+	vector<double> rates; // NaN outside first step mode
+	vector<int32_t> tags;
+
+	vector<string> tagNames;
+	std::map<string, int32_t> tagIndex;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* RandomGenerator class header. Every SimulationSystem owns its own generator, so that
+ * trajectories do not share random state. Variates are produced in blocks. */
+
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stdint.h>
+
+const int RNG_BLOCK_SIZE = 64;
+
+// Buffered uniform and exponential variates on top of a 64-bit engine.
+class RandomGenerator {
+public:
+	RandomGenerator(void);
+	virtual ~RandomGenerator(void);
+
+	virtual void seed(uint64_t newSeed) = 0;
+	virtual uint64_t next(void) = 0;
+
+	// uniform on [0,1)
+	inline double uniform(void) {
+		if (uniformPos == RNG_BLOCK_SIZE)
+			fillUniform();
+		return uniforms[uniformPos++];
+	}
+
+	// exponential with mean 1
+	inline double exponential(void) {
+		if (exponentialPos == RNG_BLOCK_SIZE)
+			fillExponential();
+		return exponentials[exponentialPos++];
+	}
+
+protected:
+	void reset(void); // drops buffered variates, engines call this when seeded
+	virtual void fillBlock(uint64_t *output, int size);
+
+private:
+	void fillUniform(void);
+	void fillExponential(void);
+
+	double uniforms[RNG_BLOCK_SIZE];
+	double exponentials[RNG_BLOCK_SIZE];
+	int uniformPos;
+	int exponentialPos;
+};
+
+// xoshiro256**, seeded through splitmix64.
+class Xoshiro256: public RandomGenerator {
+public:
+	Xoshiro256(void);
+
+	void seed(uint64_t newSeed);
+	uint64_t next(void);
+
+protected:
+	void fillBlock(uint64_t *output, int size);
+
+private:
+	uint64_t state[4];
+};
+
+// The seed of trajectory 'index' in the run started with 'seed'. Index 0 is the seed itself,
+// so a reported trajectory seed reproduces that trajectory as the first of a new run.
+long trajectorySeed(long seed, long index);
+
+#endif
@@ -14,6 +14,8 @@
 #include "strandordering.h"
 #include "optionlists.h"
 #include "simtimer.h"
+#include "looptree.h"
+#include "flatcomplex.h"
 
 class StrandComplex {
 public:
@@ -23,6 +25,7 @@ public:
 	StrandComplex(StrandOrdering *newOrdering);
 	~StrandComplex(void);
 	void cleanup(void);
+	StrandComplex *copy(void); // the same state, with its own strands, loops and moves
 
 	// information retrieval functions
 	double getTotalFlux(void); // returns total flux for all moves within the complex
@@ -30,6 +33,7 @@ public:
 	int getStrandCount(void); // # of strands in the complex.
 	double getEnergy(void); // returns the energy of the complex
 	double getEnthalpy(void); // return the enthalpy of the complex
+	void activateNucleotide(void); // cotranscriptional mode, after the energy model activated another nucleotide
 	void generateMoves(void); // display function to output the dot-paren structure of all moves contained in this complex. Should be preceded by printing the sequence, possibly I should change it to just do that straight out. Used for testing purposes (comparing all moves adjacent and rates).
 	string& getSequence(void); // returns char representation of sequence
 	string& getStructure(void); // returns dot-paren notation structure for seq.
@@ -46,8 +50,10 @@ public:
 	Move *getChoice(SimTimer&); // get a move chosen stochastically from all possible moves within the complex. We'll then call perform choice on that move to generate the new setup.
 	StrandComplex *doChoice(Move *move, SimTimer&);
 	int generateLoops(void);
+	void useFlatEngine(void); // before generateLoops, for a single strand alone in the system
 
 	void printAllMoves(void);
+	void listMoves(std::vector<BasePairMove>& output); // ordered by base pair, after generateLoops
 	string toString(void);
 	OpenInfo& getOpenInfo(void);
 
@@ -57,6 +63,9 @@ public:
 	StrandOrdering* ordering;
 private:
 	Loop *beginLoop;
+	LoopTree loopTree; // indexes the rates of all loops in this complex
+	bool flatEngine = false;
+	FlatComplex *flat = NULL; // replaces the loops when the flat engine is used
 
 };
 
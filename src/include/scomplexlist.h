@@ -8,29 +8,37 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <vector>
 
 #include "scomplex.h"
 #include "energymodel.h"
 #include "optionlists.h"
 #include "simtimer.h"
 #include "strandordering.h"
+#include "complexindex.h"
+#include "utility.h"
 
 using std::cout;
 
 class SComplexListEntry;
 class JoinCriterea;
+class StopConditions;
+class StopTracker;
 
 class SComplexList {
 public:
 
 	SComplexList(EnergyModel *energyModel);
 	~SComplexList(void);
+	SComplexList *copy(void); // every complex copied, before initializeList
 
 	SComplexListEntry *addComplex(StrandComplex *newComplex);
+	void addCopy(SComplexListEntry *entry); // before initializeList
+	void initializeComplexes(void); // loops and moves only, initializeList does the rest
 	void initializeList(void);
-	void regenerateMoves(void);
+	void activateNucleotide(void); // cotranscriptional mode
 	double getTotalFlux(void);
-	double getJoinFlux(void);
+	double getJoinFlux(void); // recomputed from all complexes
 	uint16_t getMoveCount(void);
 
 	BaseCount getExposedBases();
@@ -50,6 +58,7 @@ public:
 	double doJoinChoice(SimTimer& choice);
 	void doJoinChoiceArr(double choice);
 	bool checkStopComplexList(class complexItem *stoplist);
+	void trackStopConditions(StopConditions *stops); // call once the complexes are added
 	string toString(void);
 	void updateOpenInfo(void);
 
@@ -59,14 +68,37 @@ private:
 	bool checkLooseStructure(const char *our_struc, const char *stop_struc, int count);
 	bool checkCountStructure(const char *our_struc, const char *stop_struc, int count);
 
-	int numOfComplexes = 0;
+	// incremental flux bookkeeping
+	void resetFlux(void);
+	void updateRate(SComplexListEntry *entry);
+	void addExposed(SComplexListEntry *entry);
+	void removeExposed(SComplexListEntry *entry);
+	void refreshExposed(SComplexListEntry *entry);
+	void crossExposed(SComplexListEntry *entry, long sign);
+	double getCountedJoinFlux(void);
+	void unlink(SComplexListEntry *entry);
+	SComplexListEntry *materialize(SComplexListEntry *species);
+	bool useIndex(void);
+
+	int numOfComplexes = 0; // counting every copy
+	int spareCopies = 0; // copies beyond the first of each entry
 	int idcounter = 0;
 
 	SComplexListEntry* first = NULL;
 	EnergyModel* eModel = NULL;
+	StopTracker* stopTracker = NULL;
 
 	double joinRate = 0.0;	// joinrate is the sum of collision rates in the state.
 
+	double uniFlux = 0.0; // sum of the entry rates, updated by differences
+	int fluxUpdates = 0; // since uniFlux was last summed exactly
+	BaseCount exposedBases; // summed over all complexes, without Arrhenius
+	OpenInfo exposedInfo; // summed over all complexes, with Arrhenius
+	std::vector<long> joinCounts; // base pairings between complexes, per (left, right) MoveType
+
+	// chooses the transitions once there are many complexes
+	ComplexIndex complexIndex;
+
 }
 ;
 
@@ -75,18 +107,33 @@ public:
 	SComplexListEntry(StrandComplex *newComplex, int newid);
 	~SComplexListEntry(void);
 	void initializeComplex(void);
-	void regenerateMoves(void);
-	void fillData(EnergyModel *em);
+	void fillData(void);
+	double getEnergy(EnergyModel *em);
 	string toString(EnergyModel *em);
-	void dumpComplexEntryToPython(ExportData& data);
+	void dumpComplexEntryToPython(ExportData& data, EnergyModel *em);
 
 	int id;
 	StrandComplex* thisComplex;
 	energyS ee_energy;
 	double energy;
 	double rate;
+	bool energyValid = false; // energy is computed when it is asked for
+	bool initialized = false; // the complex has its loops and moves
+
+	// the exposed bases this complex contributes to the join bookkeeping of SComplexList
+	BaseCount exposedBases;
+	OpenInfo exposedInfo;
+
+	int slot = -1; // in the ComplexIndex of the list
+	bool exported = false; // written in full to the trajectory file since its strands last changed
+
+	// identical copies of the complex that have not reacted yet, see SimOptions::speciesMultiplicity
+	int copies = 1;
+	vector<int> copyIds; // of the copies beyond the first
+	utility::complex_input *species = NULL; // owned, the start complex the copies are built from
 
 	SComplexListEntry *next;
+	SComplexListEntry *prev = NULL;
 };
 
 #endif
@@ -10,9 +10,11 @@ help@multistrand.org
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <array>
 
 using std::string;
 using std::vector;
+using std::array;
 
 
 // Vienna: 0 is invalid, then CG, GC, GU, UG, AU, UA, and Special are 1-7
@@ -49,9 +51,10 @@ struct BaseCount {
 
 	friend std::ostream& operator<<(std::ostream&, BaseCount&);
 
-	void increment(BaseCount& other);
-	void decrement(BaseCount& other);
+	void increment(BaseCount& other, int times = 1);
+	void decrement(BaseCount& other, int times = 1);
 	int multiCount(BaseCount& other);
+	bool operator==(const BaseCount& other) const;
 
 	int countFromChar(char c);
 
@@ -63,7 +66,7 @@ struct BaseCount {
 	int C(void);
 
 	// the actual data structure; rest is convienience
-	vector<int> count = { 0, 0, 0, 0, 0 }; // use baseType as access
+	array<int, BASES> count = { 0, 0, 0, 0, 0 }; // use baseType as access
 };
 
 #endif
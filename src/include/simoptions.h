@@ -22,6 +22,7 @@
 #include <iostream>
 
 #include "energyoptions.h"
+#include "resultsink.h"
 #include "utility.h"
 
 using std::vector;
@@ -29,6 +30,7 @@ using std::string;
 using namespace utility;
 
 class EnergyOptions;
+class StopConditions;
 
 // FD: SimOptions contains an EnergyOptions object.
 // Both simOptions and energyOptions are meant to contain static values.
@@ -64,7 +66,10 @@ public:
 
 	virtual PyObject* getPythonSettings(void) = 0;
 	virtual void generateComplexes(PyObject*, long) = 0;
-	virtual stopComplexes* getStopComplexes(int) = 0;
+	// The start state is fixed and copied, so it is not read again. Records the seed.
+	virtual void reuseComplexes(long);
+	// Converted once and owned by the SimOptions.
+	virtual StopConditions* getStopConditions(void) = 0;
 
 	// Exit signalling
 	virtual void stopResultError(long) = 0;
@@ -75,6 +80,12 @@ public:
 	// For a first step result, also report the collision rate.
 	virtual void stopResultFirstStep(long, double, double, const char*) = 0;
 
+	// A complex in the final state of a trajectory, reported before the stop result.
+	virtual void exportEndState(long, ExportData&) = 0;
+
+	// Hands over results that are still held natively, at the end of a run.
+	virtual void flushResults(void);
+
 
 // IO Methods
 	string toString(void);
@@ -83,11 +94,43 @@ public:
 	bool cotranscriptional = false;
 	double cotranscriptional_rate = 0.002; // delay between adding nucleotides (seconds)
 	const int initialActiveNT = 8;	// initial number of active nucleotides.
+	const int frozenNT = 200; // nucleotides this far behind the last active one no longer move.
+
+	// Which MoveContainer the loops use (0: MoveList, 1: IndexedMoveList).
+	long moveContainer = 0;
+
+	// Check structure stop conditions with a StopTracker instead of comparing dot-paren strings.
+	bool stopTracking = true;
+
+	// Updates of the summed complex rates between exact resummations, see SComplexList::updateRate.
+	long fluxResumInterval = 1024;
+
+	// How complexes hold their state (0: loop graph, 1: FlatComplex for a lone strand).
+	long stateEngine = 0;
+
+	// Entries of the loop energy cache, 0 disables it.
+	long energyCacheSize = 0;
+
+	// From this many complexes on, a ComplexIndex chooses the complex and the join partners.
+	long complexIndexThreshold = 16;
+
+	// Keep trajectory results in a ResultSink instead of passing each one to Python.
+	bool nativeResults = false;
+
+	// Merge identical start complexes into one SComplexList entry with copies.
+	bool speciesMultiplicity = false;
+
+	// No start complex is Boltzmann sampled, so every trajectory starts in the same state.
+	bool fixedStartState = false;
+
+	// Binary file that exported states are written to, instead of passing them to Python.
+	string trajectoryFile;
 
 	vector<complex_input>* myComplexes = NULL;
 	EnergyOptions* energyOptions = NULL;
 
 	bool statespaceActive = false;
+	bool statespaceBinary = false; // export the statespace as columns, see Builder::writeBinary
 	long verbosity = 1;
 	double ms_version = 0.0;
 
@@ -102,7 +145,7 @@ protected:
 	double max_sim_time = 0;
 	long seed = 0;
 	bool fixedRandomSeed = false;
-	stopComplexes* myStopComplexes = NULL;
+	StopConditions* myStopConditions = NULL;
 
 	bool printInitialFirstStep = false;
 
@@ -117,7 +160,8 @@ public:
 
 	PyObject* getPythonSettings(void);
 	void generateComplexes(PyObject *alternate_start, long current_seed);
-	stopComplexes* getStopComplexes(int);
+	void reuseComplexes(long current_seed);
+	StopConditions* getStopConditions(void);
 
 	// Error signaling
 	void stopResultError(long);
@@ -125,10 +169,15 @@ public:
 	void stopResultNormal(long, double, char*);
 	void stopResultTime(long, double);
 	void stopResultFirstStep(long, double, double, const char*);
+	void exportEndState(long, ExportData&);
+	void flushResults(void);
 
 protected:
+	void keepResult(long seed, int type, double time, double rate, const char* tag);
+
 	bool debug;
 	PyObject *python_settings;
+	ResultSink results;
 
 };
 
@@ -141,7 +190,7 @@ public:
 
 	PyObject* getPythonSettings(void);
 	void generateComplexes(PyObject *alternate_start, long current_seed);
-	stopComplexes* getStopComplexes(int);
+	StopConditions* getStopConditions(void);
 
 	// Error signaling
 	void stopResultError(long);
@@ -149,6 +198,7 @@ public:
 	void stopResultNormal(long, double, char*);
 	void stopResultTime(long, double);
 	void stopResultFirstStep(long, double, double, const char*);
+	void exportEndState(long, ExportData&);
 
 protected:
 	bool debug;
@@ -156,5 +206,48 @@ protected:
 
 };
 
+// The outcome of a single trajectory, as recorded by BufferedSimOptions.
+struct TrialResult {
+
+	int type = 0; // one of the STOPRESULT_ flags in options.h
+	long seed = 0;
+	double time = 0.0;
+	double rate = 0.0; // first step mode only
+	bool firstStep = false;
+	string tag;
+	vector<ExportData> endStates;
+
+	// hands the result to options that can talk to Python
+	void replay(SimOptions* target);
+
+};
+
+// FD: Worker threads run without the GIL, so they use a copy of the settings
+// that stores results natively. The controlling thread replays them afterwards.
+class BufferedSimOptions: public SimOptions {
+public:
+	BufferedSimOptions(SimOptions* source);
+	~BufferedSimOptions(void);
+
+	PyObject* getPythonSettings(void);
+	void generateComplexes(PyObject *alternate_start, long current_seed);
+	StopConditions* getStopConditions(void);
+
+	// Error signaling
+	void stopResultError(long);
+	void stopResultNan(long);
+	void stopResultNormal(long, double, char*);
+	void stopResultTime(long, double);
+	void stopResultFirstStep(long, double, double, const char*);
+	void exportEndState(long, ExportData&);
+
+	TrialResult takeResult(void);
+
+protected:
+	StopConditions* sharedStopConditions = NULL; // owned by the source options
+	TrialResult result;
+
+};
+
 #endif
 
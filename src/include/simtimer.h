@@ -3,11 +3,12 @@
 #define __SIMTIMER_H__
 
 class SimOptions;
+class RandomGenerator;
 
 class SimTimer {
 
 public:
-	SimTimer(SimOptions& myOptions);
+	SimTimer(SimOptions& myOptions, RandomGenerator *rng);
 
 	void advanceTime(void);
 	bool wouldBeHit(const double);
@@ -33,6 +34,9 @@ public:
 
 	SimOptions* simOptions = NULL;
 
+	// owned by the SimulationSystem
+	RandomGenerator *rng = NULL;
+
 // private:
 };
 
@@ -13,15 +13,26 @@
 #include <unordered_map>
 #include <iostream>
 #include <string>
+#include <atomic>
 
 #include "energymodel.h"
 #include "scomplexlist.h"
 #include "statespace.h"
 #include "moveutil.h"
+#include "utility.h"
+#include "rng.h"
+#include "looppool.h"
+#include "energycache.h"
+#include "trajectorywriter.h"
+
+struct TrialResult;
 
 typedef std::vector<bool> boolvector;
 typedef std::vector<bool>::iterator boolvector_iterator;
 
+// trials whose start states and results are held at once by a threaded run
+const long THREADED_CHUNK_SIZE = 65536;
+
 namespace result_type {
 
 const static std::string STR_ERROR = "error";
@@ -43,13 +54,17 @@ public:
 	~SimulationSystem(void);
 
 	void StartSimulation(void);
+	void StartSimulation(long trials, int numThreads); // runs trajectories on worker threads when possible
 	void initialInfo(void);	// printing function
 	void localTransitions(void); // builds all transitions in local statespace
 
 	PyObject *calculateEnergy(PyObject *start_state, int typeflag);
+	PyObject *transitionRates(PyObject *start_state); // every base pair move of every complex
 	int isEnergymodelNull(void);
 
 private:
+	SimulationSystem(SimOptions* options, EnergyModel* model); // worker threads
+
 	void StartSimulation_Standard(void);
 	void StartSimulation_FirstStep(void);
 	void StartSimulation_Trajectory(void);
@@ -60,6 +75,10 @@ private:
 	void SimulationLoop_Trajectory(void);
 	void SimulationLoop_Transition(void);
 
+	bool supportsThreads(void);
+	void StartSimulation_Threaded(int numThreads);
+	void runWorker(std::atomic<long>& nextTrial, vector<long>& seeds, vector<vector<utility::complex_input>*>& starts, vector<TrialResult>& results);
+
 	int InitializeSystem(PyObject *alternate_start = NULL);
 
 	void InitializeRNG(void);
@@ -82,11 +101,17 @@ private:
 	EnergyModel* energyModel = NULL;
 	StrandComplex *startState = NULL;
 	SComplexList *complexList = NULL;
+	SComplexList *startTemplate = NULL; // a fixed start state with its loops and moves, copied for every trajectory
 	SimOptions *simOptions = NULL;
 
 	PyObject *system_options = NULL;
 
 	long current_seed = NULL;
+	long initial_seed = 0; // trajectory seeds are derived from this one
+	long trajectory_index = 0;
+	Xoshiro256 rng;
+	LoopPool loopPool; // loops of complexList are allocated from here
+	EnergyCache energyCache;
 	long simulation_mode;
 	long simulation_count_remaining;
 
@@ -101,6 +126,9 @@ private:
 	// A builder object that is only used if export is toggled
 	Builder builder;
 
+	// Takes the exported states when the trajectory_file option is set
+	TrajectoryWriter trajectoryWriter;
+
 };
 
 #endif
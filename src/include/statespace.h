@@ -9,30 +9,43 @@
  *      Author: Frits Dannenberg
  *
  *      This class collects every visited state, and transitions between visited states.
- *      After the simulation is done, the set is exported to a text file.
+ *      After the simulation is done, the set is exported to text files, or with
+ *      statespace_binary to a single file of columns:
+ *
+ *      "MSSPACE1", then uint64 counts of states, transitions, initial states, final states
+ *      and bytes in the string pool, then the columns, each padded to 8 bytes:
+ *
+ *      	states:		names, sequence, structure (uint64 pool offsets), energy, enthalpy (double),
+ *      				complex_count (uint8)
+ *      	transitions:	from, to (uint32 state ids), arrType (double)
+ *      	initial:	state (uint32), observation count (int32), join rate (double)
+ *      	final:		state (uint32), observation count (int32), tag (uint64 pool offset)
+ *
+ *      and the pool of zero terminated strings.
  *
  */
 #ifndef __STATESPACE_H__
 #define __STATESPACE_H__
 
 #include <scomplexlist.h>
+#include <fingerprint.h>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 using std::unordered_map;
-using std::unordered_set;
+using std::vector;
 
 class SimOptions;
 
 /*
- * 		protoSpace : map with states as entries
+ * 		states : every visited state, once, under the fingerprint of its sequence and structure
  *
- *		protoTransitions: map with transitions as entries
+ *		transitions: pairs of state ids, with the arrType of the transition
  *
- *		key: states. Value: a initCountFlux object that tells how many times the state has been the initial state and the join flux (rate)
+ *		key: state id. Value: a initCountFlux object that tells how many times the state has been the initial state and the join flux (rate)
  *		self.protoInitialStates = dict()
  *
- *		key: states: Value: the result of this final state is typically SUCCES or FAILURE (tag)
+ *		key: state id: Value: the result of this final state is typically SUCCES or FAILURE (tag)
  *		self.protoFinalStates = dict()
  */
 class Builder {
@@ -44,22 +57,57 @@ public:
 
 	void addState(ExportData&, const double arrType);
 	void stopResultNormal(double, string);
+	void forgetLastState(void); // the next state starts a trajectory
 	void writeToFile(void);
 	string filename(string);
-
-	ExportData lastState;
+	string directory(void);
 
 	static const string the_dir;
 
 private:
 
+	// the strings of a state are offsets into the pool, names and sequences are shared
+	struct State {
+		size_t names, sequence, structure;
+		double energy, enthalpy;
+		uint8_t complex_count;
+	};
+
+	struct Transition {
+		uint32_t from, to;
+		double type;
+
+		bool operator<(const Transition& other) const {
+			return from < other.from || (from == other.from && (to < other.to || (to == other.to && type < other.type)));
+		}
+		bool operator==(const Transition& other) const {
+			return from == other.from && to == other.to && type == other.type;
+		}
+	};
+
+	uint32_t intern(ExportData& data);
+	size_t internString(const string& text);
+	size_t poolString(const string& text);
+	void compactTransitions(void);
+	void writeState(std::ostream& str, uint32_t id);
+	void writeText(void);
+	void writeBinary(void);
+
 	SimOptions* simOptions = NULL;
 
-	unordered_set<ExportData> protoSpace;
-	unordered_set<ExportTransition> protoTransitions;
+	string pool; // zero terminated strings
+	unordered_map<string, size_t> sharedStrings;
+
+	vector<State> states;
+	unordered_map<Fingerprint, uint32_t> stateIds;
+
+	vector<Transition> transitions;
+	size_t compacted = 0; // the transitions before this one are sorted and unique
+
+	unordered_map<uint32_t, ExportFinal> finalStates;
+	unordered_map<uint32_t, ExportInitial> initialStates;
 
-	unordered_map<ExportData, ExportFinal> protoFinalStates;
-	unordered_map<ExportData, ExportInitial> protoInitialStates;
+	long lastState = -1;
 
 };
 
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* StopConditions class header. The stop conditions of a simulation, converted from the
+ * Python objects once and then only read, so that it can be shared between worker threads.
+ *
+ * StopTracker keeps, for one simulation, the distance between the current structure and
+ * every structure condition. It is updated from the base pair that changed, so that the
+ * conditions can be checked without rebuilding the dot-paren structure. */
+
+#ifndef __STOPCONDITIONS_H__
+#define __STOPCONDITIONS_H__
+
+#include <vector>
+
+class stopComplexes;
+class complexItem;
+class SComplexList;
+class StrandOrdering;
+class orderingList;
+
+// partner values in a StructureTarget, paired positions hold the index of their partner
+const int STOP_UNPAIRED = -1;
+const int STOP_WILDCARD = -2;
+const int STOP_OUTSIDE = -3; // paired to a strand that is not part of the condition
+const int STOP_MISMATCH = -4; // a wildcard of a count condition, which differs from any base
+
+// The pairing asked for by an exact, loose or count structure condition.
+struct StructureTarget {
+	std::vector<char*> tags; // one per strand
+	std::vector<int> start; // position of the first base of each strand
+	std::vector<int> length;
+	std::vector<int> partner;
+};
+
+class StopConditions {
+public:
+	StopConditions(stopComplexes *list); // takes ownership of the list
+	~StopConditions(void);
+
+	int size(void) const;
+	char *getTag(int index) const;
+	bool isHalting(int index) const; // tagged "stop:", used by transition mode
+
+	bool check(SComplexList *complexList, int index) const;
+	int firstMatch(SComplexList *complexList) const; // -1 if no condition holds
+
+	int targetCount(void) const;
+	const StructureTarget& getTarget(int index) const;
+
+private:
+	void compileTarget(complexItem *item);
+
+	stopComplexes *head;
+	std::vector<stopComplexes*> conditions;
+	std::vector<bool> halting;
+	std::vector<StructureTarget> targets;
+};
+
+class StopTracker {
+public:
+	StopTracker(StopConditions *stops, std::vector<StrandOrdering*>& orderings);
+
+	// false if the strands of the condition are not each present exactly once
+	bool isTracked(complexItem *item) const;
+	// number of positions that differ from the condition, wildcards excluded
+	int getDistance(complexItem *item) const;
+
+	// called by StrandOrdering after base a of strand first and base b of strand second paired or unpaired
+	void pairChanged(orderingList *first, int a, orderingList *second, int b, bool paired);
+
+private:
+	struct Watch {
+		int target;
+		int base; // position of the strand's first base in the target
+	};
+
+	void update(orderingList *strand, int index, orderingList *other, int otherIndex, bool paired);
+	int findBase(orderingList *strand, int target) const;
+
+	StopConditions *stops;
+	std::vector<std::vector<Watch> > watches; // per watched strand
+	std::vector<bool> bound; // per target
+	std::vector<std::vector<char> > wrong;
+	std::vector<int> distance;
+};
+
+#endif
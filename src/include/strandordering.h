@@ -15,6 +15,8 @@
 // needed for the openloop components of a strand ordering
 
 class OpenLoop;
+class StopTracker;
+class TrajectoryWriter;
 
 class orderingList {
 public:
@@ -25,6 +27,9 @@ public:
 	OpenLoop *thisLoop; // corresponds to the OpenLoop to the 'left' of this strand
 	int size;
 	int uid;
+	StopTracker *stopTracker = NULL; // notified when a base pair of this strand changes
+	int stopWatch = -1;
+	TrajectoryWriter *trajectoryWriter = NULL; // notified as well, once the complex of this strand is in the trajectory file
 };
 
 class StrandOrdering {
@@ -36,6 +41,7 @@ public:
 	~StrandOrdering(void);
 	void cleanup(void);
 	static StrandOrdering * joinOrdering(StrandOrdering *first, StrandOrdering *second);
+	StrandOrdering *copy(LoopCopier& copier); // the strands, the copy's open loops are set by StrandComplex::copy
 	StrandOrdering *breakOrdering(Loop *firstOldBreak, Loop *secondOldBreak, Loop *firstNewBreak, Loop *secondNewBreak); // maybe id or openloop pointer
 	void reorder(OpenLoop *index); // reorder so that open loop passed is the available openloop
 	void addBasepair(char *first_bp, char *second_bp);
@@ -53,6 +59,7 @@ public:
 	// this function converts an index into a previously given sequence from generateFlatSequence into a char * pointer into the appropriate strand's sequence at the given location.
 	char *convertIndex(int index);
 	bool convertIndexCheckBounds(int index);
+	int flatIndex(char *base); // the inverse of convertIndex
 
 	// addOpenLoop links up the appropriate strand with the open loop involving the nick immediately before that strand in the ordering.
 	void addOpenLoop(OpenLoop *newLoop, int index);
@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+/* TrajectoryWriter class header. With the trajectory_file option, exported states go to a
+ * binary file instead of the Python lists of the options object. The first state of a
+ * trajectory is written in full, every later state only as the changes to the one before:
+ * per complex the base pairs that were broken and formed, and the complexes that joins and
+ * splits removed and added. multistrand.trajectory reads the file back.
+ *
+ * The changes are recorded as they happen: StrandOrdering reports every base pair it opens
+ * or closes on the strands of a written complex, and SComplexList marks the entries that a
+ * join or a split gave new strands, which are written again in full.
+ *
+ * The file starts with the magic "MSTRAJ01", followed by records: a kind byte, the uint32
+ * length of the payload and the payload, all in native byte order.
+ *
+ *   'T' trajectory: int64 seed
+ *   'F' frame: double time, double arrType,
+ *       uint32 n, int32 id * n                          removed complexes
+ *       uint32 n, complex * n                           added complexes
+ *       uint32 n, int32 id * n                          order of the complexes, n = 0 if unchanged
+ *       uint32 n, (int32 id, double energy, double enthalpy,
+ *                  uint32 k, (uint32 i, uint32 j) * k, broken pairs
+ *                  uint32 k, (uint32 i, uint32 j) * k) * n    formed pairs, of changed complexes
+ *
+ * An added complex is int32 id, double energy, double enthalpy, and the strand names, sequence
+ * and structure, each a uint32 length and the characters. Pairs are positions in the structure. */
+
+#ifndef __TRAJECTORYWRITER_H__
+#define __TRAJECTORYWRITER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "moveutil.h"
+
+using std::string;
+using std::vector;
+
+class SComplexList;
+class EnergyModel;
+class StrandOrdering;
+class orderingList;
+
+class TrajectoryWriter {
+public:
+	~TrajectoryWriter(void);
+
+	bool open(const string& path);
+	bool isOpen(void);
+	void flush(void);
+
+	void begin(long seed); // the next frame starts a trajectory
+	void writeFrame(double time, double arrType, SComplexList *complexes, EnergyModel *model);
+
+	// a base pair between positions of the structure of the ordering was formed or broken
+	void pairChanged(StrandOrdering *ordering, int first, int second, bool paired);
+
+private:
+	typedef std::map<std::pair<uint32_t, uint32_t>, bool> PairChanges; // pair, formed
+
+	struct Written {
+		double energy;
+		double enthalpy;
+		orderingList *strands; // the first strand, a reordering writes the complex again
+		bool kept;
+	};
+
+	void writeRecord(char kind);
+	void writeComplex(ExportData& data);
+
+	template<class T>
+	inline void put(T value) {
+		payload.append((const char*) &value, sizeof(T));
+	}
+	void put(const string& text);
+
+	FILE *file = NULL;
+	string payload;
+
+	long seed = 0;
+	bool pending = false; // begin was called, but no frame written since
+
+	std::unordered_map<int, Written> last; // the complexes of the last frame, by id
+	vector<int> lastOrder;
+	std::unordered_map<StrandOrdering*, PairChanges> changes; // since the last frame
+};
+
+#endif
@@ -1,9 +1,12 @@
 from .strand import Strand
 from functools import reduce
+import random
+import weakref
 
 class Complex(object):
 
     MAX_SAMPLES_AT_ONCE = 200
+    NATIVE_SAMPLES_AT_ONCE = 10000
     """
     A representation of a single connected complex of strands.
     """
@@ -58,6 +61,7 @@ class Complex(object):
         self._temperature = None
         self._sodium = None
         self._magnesium = None
+        self._boltzmann_options = None
         # Taken to be 1, unless it is EXPLICITLY stated otherwise!
         self.boltzmann_supersample = 1
         Complex.unique_id += 1
@@ -201,18 +205,21 @@ class Complex(object):
         """ The calculated 'flat' sequence for this complex. """
         return "+".join([strand.sequence for strand in self.strand_list])
     
-    def set_boltzmann_parameters(self, dangles, substrate_type, temperature, sodium, magnesium):
+    def set_boltzmann_parameters(self, dangles, substrate_type, temperature, sodium, magnesium, options=None):
         """
         Sets the parameters to be passed on to NUPACK for Boltzmann sampling of this complex.
         Uses the private properties which are then read by generate_boltzmann_structure.
         
         Called by the start_state setter in an Options object, and the setters for dangles, substrate_type and temperature properties in an Options object.
+        Those pass themselves as options, so that the structures are sampled in process, with the energy model of the options.
         """
         self._dangles = dangles
         self._substrate_type = substrate_type
         self._temperature = temperature
         self._sodium = sodium
         self._magnesium = magnesium
+        # a weak reference, so that copies of this complex do not copy the options
+        self._boltzmann_options = weakref.ref(options) if options is not None else None
     
     def generate_boltzmann_structure(self):
         """
@@ -228,6 +235,27 @@ class Complex(object):
             self._pop_boltzmann()
             return
         
+        options = self._boltzmann_options() if self._boltzmann_options is not None else None
+        
+        if options is None:
+            self._nupack_sample()
+            return
+        
+        # The sampler sums over all structures once per call, drawing a structure after that
+        # is cheap, so ask for all the structures we expect to need.
+        from ..system import boltzmann_sample
+        
+        count = min(max(self._boltzmann_sizehint // self.boltzmann_supersample, 1), self.NATIVE_SAMPLES_AT_ONCE)
+        structures, free_energy = boltzmann_sample(options, self.sequence, count, random.getrandbits(63))
+        
+        self._boltzmann_queue = structures * self.boltzmann_supersample
+        if len(self._boltzmann_queue) < 1:
+            raise ValueError("The strands of complex {0} cannot form a connected complex, so there is no structure to sample.".format(self.name))
+        
+        self._pop_boltzmann()
+    
+    def _nupack_sample(self):
+        """ Fills the queue of sampled structures with NUPACK's sample binary, for complexes that are not part of an Options object. """
         import subprocess, tempfile, os
         
         tmp = tempfile.NamedTemporaryFile(delete=False, suffix=".sample")
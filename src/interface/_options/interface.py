@@ -1,3 +1,5 @@
+import numpy as np
+
 from .constants import OptionsConstants
 
 Constants = OptionsConstants()
@@ -49,6 +51,11 @@ class Interface(object):
 
         self._results = ResultList([])
         # hidden member that has a list of Result objects.
+
+        self.result_arrays = ResultArrays()
+        """ The results as numpy arrays, filled instead of results when
+        the native_results option is set.
+        """
         
     @property
     def results( self ):
@@ -199,3 +206,55 @@ class ResultList( list ):
                 ])
             res += "{0[0]:<10} | {0[1]} | {0[2]} [{0[3]}]\n".format( data )
         return res
+
+
+class ResultArrays( object ):
+    """ Holds the results of many trajectories as numpy arrays, one entry per
+    trajectory: seed, com_type, time and collision_rate as in Result and
+    FirstStepResult (collision_rate is NaN outside first step mode), and tag,
+    the index of the stop result tag in tags."""
+
+    def __init__(self):
+        self.seed = np.zeros(0, dtype=np.int64)
+        self.com_type = np.zeros(0, dtype=np.int32)
+        self.time = np.zeros(0, dtype=np.float64)
+        self.collision_rate = np.zeros(0, dtype=np.float64)
+        self.tag = np.zeros(0, dtype=np.int32)
+        self.tags = []
+
+    def __len__( self ):
+        return len(self.seed)
+
+    def append( self, seeds, com_types, times, collision_rates, tags, names ):
+        """ Adds a chunk of results. The columns are buffers of native values
+        (bytes from the simulator, or arrays), tags index into names. """
+        for name in names:
+            if name not in self.tags:
+                self.tags.append(name)
+        codes = np.array([self.tags.index(name) for name in names], dtype=np.int32)
+
+        self.seed = np.concatenate((self.seed, np.frombuffer(seeds, dtype=np.int64)))
+        self.com_type = np.concatenate((self.com_type, np.frombuffer(com_types, dtype=np.int32)))
+        self.time = np.concatenate((self.time, np.frombuffer(times, dtype=np.float64)))
+        self.collision_rate = np.concatenate((self.collision_rate, np.frombuffer(collision_rates, dtype=np.float64)))
+        self.tag = np.concatenate((self.tag, codes[np.frombuffer(tags, dtype=np.int32)]))
+
+    def extend( self, that ):
+        self.append(that.seed, that.com_type, that.time, that.collision_rate, that.tag, that.tags)
+
+    def has_tag( self, tag ):
+        """ A boolean mask of the trajectories that stopped with tag. """
+        if tag not in self.tags:
+            return np.zeros(len(self), dtype=bool)
+        return self.tag == self.tags.index(tag)
+
+    def take( self, indices ):
+        """ A new ResultArrays with the trajectories at indices. """
+        res = ResultArrays()
+        res.seed = self.seed[indices]
+        res.com_type = self.com_type[indices]
+        res.time = self.time[indices]
+        res.collision_rate = self.collision_rate[indices]
+        res.tag = self.tag[indices]
+        res.tags = list(self.tags)
+        return res
@@ -9,6 +9,7 @@ from ..objects import Strand, Complex, StopCondition
 from ..__init__ import __version__
 
 import copy
+import os
 import warnings
 
 """ Literals for Multistrand"""
@@ -37,6 +38,14 @@ class  Literals(object):
     kawasaki = 2
     arrhenius = 3
     
+    """ Move containers used by the loops """
+    movelist_linear = 0
+    movelist_indexed = 1
+    
+    """ State engines """
+    engine_loops = 0
+    engine_flat = 1
+    
     """ Nupack dangle options """
     dangles_none = 0
     dangles_some = 1
@@ -178,6 +187,89 @@ class Options(object):
         By default, the cotranscriptional mode adds one nucleotide every 1 millisecond.
         """
         
+        self.move_container = Literals.movelist_linear
+        """
+        How each loop stores its transitions.
+        Literals.movelist_linear (0): scan all moves of the chosen loop [default].
+        Literals.movelist_indexed (1): keep running sums and binary search them,
+                                       faster for large open loops and multiloops.
+        """
+        
+        self.stop_tracking = True
+        """
+        Check exact, loose and count structure stop conditions against a
+        pairing that is updated from the base pairs that change [default].
+        With False, the dot-paren structure of every complex is compared
+        instead, which is slower but gives the same results.
+        """
+        
+        self.flux_resum_interval = 1024
+        """
+        The total rate of the complexes is updated by differences, and summed
+        again over all complexes after this many updates [default 1024], to
+        bound the rounding errors. With 1, it is summed at every update, and
+        the join rate is recomputed at every step.
+        """
+        
+        self.state_engine = Literals.engine_loops
+        """
+        How the state of a complex is held.
+        Literals.engine_loops (0): a graph of loop objects [default].
+        Literals.engine_flat (1): flat arrays (pair table, loop index and side
+                                  descriptors). Used only when the system is a
+                                  single strand, outside of cotranscriptional and
+                                  statespace modes; anything else keeps the loops.
+        Both engines give the same energies and transition rates.
+        """
+        
+        self.energy_cache_size = 0
+        """
+        Number of loop energies that each simulation system memoizes, keyed by
+        the sequence context of the loop. 0 disables the cache [default].
+        After SimSystem.start(), energy_cache_hits and energy_cache_misses hold
+        the lookups of that run, to help size the cache.
+        """
+        
+        self.energy_cache_hits = 0
+        self.energy_cache_misses = 0
+        
+        self.complex_index_threshold = 16
+        """
+        From this many complexes on [default 16], the complex of the next
+        transition and the partners of the next join are found in an index
+        over the complexes, in logarithmic time. Smaller systems walk the
+        list of complexes.
+        """
+        
+        self.species_multiplicity = False
+        """
+        Hold identical start complexes (same strands, sequence and structure)
+        as one entry with a copy count. Its unimolecular rate and exposed bases
+        are scaled by the count, and a copy becomes a complex of its own only
+        when it reacts, so large populations of unreacted strands cost memory
+        and time per distinct complex rather than per molecule. Exported
+        states still list every copy. Not used for the statespace modes or
+        energy calculations.
+        """
+        
+        self.native_results = False
+        """
+        Keep the results of trajectories in native arrays, handed to Python
+        in chunks, instead of creating a Result object per trajectory.
+        After SimSystem.start(), interface.result_arrays holds the seeds, stop
+        result flags, times, collision rates and tags as numpy arrays, and
+        interface.results stays empty. End states and start structures are
+        not recorded. FirstStepRate and FirstPassageRate take the arrays as
+        their dataset.
+        """
+        
+        self.copy_start_state = True
+        """
+        Build the loops and moves of a fixed start state once, and copy them
+        for every trajectory [default]. With False, every trajectory builds
+        them again from the start complexes; both give the same trajectories.
+        """
+        
         #############################################
         #                                           #
         # Data Members: Energy Model                #
@@ -262,6 +354,19 @@ class Options(object):
         Multistrand if it gets used.
         """
 
+        self.parameter_snapshot_dir = None
+        """ Directory for binary snapshots of the parsed energy parameters.
+
+        Type         Default
+        str          None
+
+        Energy models built for the same parameter files, temperature and
+        salt share their tables within a process. If set to an existing
+        directory, the tables are also written there on first use and
+        mapped from there by later processes, such as MergeSim workers,
+        instead of parsing the parameter files again.
+        """
+
         ####################
         #
         # BEGIN simmode
@@ -372,6 +477,21 @@ class Options(object):
         means output every state, 2 means every other state, and so on.
         """
         
+        self._trajectory_file = None
+        
+        self.statespace_binary = False
+        """ Export the statespace of activestatespace as one binary file.
+        
+        Type         Default
+        bool         False
+        
+        If set, the visited states, transitions, initial and final states are
+        written to p_statespace/<seed>/statespace.bin as columns, instead of
+        the four text files. A Builder with binaryStatespace sets this, and
+        maps the columns with numpy instead of parsing the text files line by
+        line.
+        """
+        
         self.current_interval = 0
         """ Current value of output state counter.
         
@@ -508,7 +628,7 @@ class Options(object):
         if len(self._start_state) > 0:
                         
             for c, s in self._start_state:
-                c.set_boltzmann_parameters(self.dangleToString[self.dangles], self.substrateToString[self.substrate_type], self._temperature_celsius, self.sodium, self.magnesium)
+                c.set_boltzmann_parameters(self.dangleToString[self.dangles], self.substrateToString[self.substrate_type], self._temperature_celsius, self.sodium, self.magnesium, self)
     
                 if c.boltzmann_sample and not self.gt_enable:
                     raise Warning("Attempting to use Boltzmann sampling but GT pairing is disabled. Energy model of Multistrand will not match that of the NUPACK sampling method.")
@@ -653,7 +773,7 @@ class Options(object):
     def _add_start_complex(self, item):
         if isinstance(item, Complex):
             self._start_state.append((item, None))
-            item.set_boltzmann_parameters(self.dangleToString[self.dangles], self.substrateToString[self.substrate_type], self._temperature_celsius, self._sodium, self._magnesium)
+            item.set_boltzmann_parameters(self.dangleToString[self.dangles], self.substrateToString[self.substrate_type], self._temperature_celsius, self._sodium, self._magnesium, self)
             
             if not self.gt_enable and item.boltzmann_sample:
                 raise Warning("Attempting to use Boltzmann sampling but GT pairing is disabled. Energy model of Multistrand will not match that of the NUPACK sampling method.")
@@ -664,6 +784,39 @@ class Options(object):
     @property
     def initial_seed_flag(self):
         return self.initial_seed != None
+
+    @property
+    def fixed_start_state(self):
+        """ True if copy_start_state is set and no start complex is
+        Boltzmann sampled, so that every trajectory starts in the same state.
+        The simulator then builds the loops and moves of the start state
+        once, and copies them for every trajectory. """
+        return self.copy_start_state and all(rest_state is None and not cmplx.boltzmann_sample for cmplx, rest_state in self._start_state)
+    
+    @property
+    def trajectory_file(self):
+        """ Binary file that the output states are written to.
+        
+        Type         Default
+        str          None
+        
+        If set, the states selected by output_interval or output_time are
+        written to this file instead of full_trajectory: the first state of
+        each trajectory in full, later states as the base pairs that changed
+        and the complexes that joins and splits removed or added.
+        multistrand.trajectory.TrajectoryFile reads the states back.
+        
+        Any path, such as a pathlib.Path, is stored as a str.
+        """
+        return self._trajectory_file
+    
+    @trajectory_file.setter
+    def trajectory_file(self, val):
+        if val is None:
+            self._trajectory_file = None
+        else:
+            # raises a TypeError for anything that is not a path
+            self._trajectory_file = os.fsdecode(val)
     
     @property
     def stop_conditions(self):
@@ -858,6 +1011,20 @@ class Options(object):
             self.interface.end_states.append(self._current_end_state)
             self._current_end_state = []
             
+    @property
+    def add_result_arrays(self):
+        return None
+
+    @add_result_arrays.setter
+    def add_result_arrays(self, val):
+        """ Takes a 6-tuple as the only value type, it should be:
+            (random number seeds, stop result flags, completion times, collision rates, stop result tags, tag names)
+
+            The first five are buffers that hold a chunk of results, the tags index into the tag names."""
+        if not isinstance(val, tuple) or len(val) != 6:
+            raise ValueError("Result arrays need a 6-tuple of values.")
+        self.interface.result_arrays.append(*val)
+
     @property
     def add_complex_state_line(self):
         return None
@@ -946,6 +1113,9 @@ class Options(object):
             else:
                 return get_structure(rest_state.get_starting_complex())
         
+        if self.native_results:
+            return
+        
         structures = [process_state(s) for s in self._start_state]
         
         self.interface.start_structures[val] = structures
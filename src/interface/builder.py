@@ -14,7 +14,7 @@ Created on Oct 2, 2017
 
 import time, copy, os, sys
 
-from multistrand.system import SimSystem
+from multistrand.system import SimSystem, passage_times
 from multistrand.utils import uniqueStateID, seqComplement
 from multistrand.options import Options, Literals
 from multistrand.experiment import standardOptions, makeComplex
@@ -28,6 +28,40 @@ from functools import reduce
 floatT = np.longdouble
 
 
+STATESPACE_MAGIC = b"MSSPACE1"
+
+# the columns of the binary statespace, in file order (see statespace.h)
+STATESPACE_COLUMNS = [("names", np.uint64, 0), ("sequence", np.uint64, 0), ("structure", np.uint64, 0),
+                      ("energy", np.float64, 0), ("enthalpy", np.float64, 0), ("complex_count", np.uint8, 0),
+                      ("from", np.uint32, 1), ("to", np.uint32, 1), ("type", np.float64, 1),
+                      ("initial_state", np.uint32, 2), ("initial_count", np.int32, 2), ("join_rate", np.float64, 2),
+                      ("final_state", np.uint32, 3), ("final_count", np.int32, 3), ("final_tag", np.uint64, 3)]
+
+
+def loadStatespace(filename):
+    """ Maps the binary statespace that Multistrand writes with options.statespace_binary.
+        Returns a dict of numpy arrays, one per column, and the string pool as 'pool'. """
+
+    data = np.memmap(filename, dtype=np.uint8, mode="r")
+
+    if bytes(data[:len(STATESPACE_MAGIC)]) != STATESPACE_MAGIC:
+        raise ValueError("%s is not a Multistrand statespace file." % filename)
+
+    counts = [int(x) for x in data[8:48].view(np.uint64)]
+    columns = dict()
+    offset = 48
+
+    for name, dtype, table in STATESPACE_COLUMNS:
+
+        size = counts[table] * np.dtype(dtype).itemsize
+        columns[name] = data[offset:offset + size].view(dtype)
+        offset += size + (-size) % 8
+
+    columns["pool"] = data[offset:offset + counts[4]]
+
+    return columns
+
+
 """
     Constructs a surface of  N *  ( N -1 ) / 2 points along the reaction frontier.
     This method returns a list of starting states that should be used as initial states for the string method.
@@ -371,6 +405,7 @@ class Builder(object):
         self.options = self.optionsFunction(self.optionsArgs)
 
         self.the_dir = "p_statespace/"
+        self.binaryStatespace = False  # read the statespace from columns instead of the text files, which are then not kept
 
     def __str__(self):
 
@@ -435,7 +470,10 @@ class Builder(object):
 
     def parseState(self, line, simulatedTemperature, simulatedConc):
 
-        mywords = line.split()
+        return self.parseWords(line.split(), simulatedTemperature, simulatedConc)
+
+    # the words of a state line: n_complexes, the names, sequences and structures of the complexes, dG, dH
+    def parseWords(self, mywords, simulatedTemperature, simulatedConc):
 
         n_complexes = int(mywords[0])
         n_strands = 0
@@ -451,13 +489,7 @@ class Builder(object):
             structs.append(mywords[1 + 2 * n_complexes + i])
             n_strands += len(mywords[1 + 2 * n_complexes + i].split('+'))
 
-            uniqueID2 = uniqueStateID(ids, structs)
-            uniqueID = ""
-
-#             for iddd in uniqueID2 :
-#                 uniqueID += str(iddd)
-                
-            uniqueID =  tuple(uniqueID2)
+        uniqueID = tuple(uniqueStateID(ids, structs))
 
         dG = float(mywords[1 + 3 * n_complexes])
         dH = float(mywords[1 + 3 * n_complexes + 1])
@@ -466,6 +498,87 @@ class Builder(object):
 
         return uniqueID, energyvals, (sequences, ids, structs)
 
+    def loadStatespace(self, filename, simulatedTemperature, simulatedConc, arrhenius, space, transitions, initStates, finalStates, sequences):
+        """ Reads the binary export of options.statespace_binary into the dicts of genAndSavePathsFile.
+            Every state is parsed once, transitions and initial and final states refer to it by index. """
+
+        columns = loadStatespace(filename)
+        pool = bytes(columns["pool"])
+        shared = dict()
+
+        def string(offset):
+            return pool[offset:pool.index(b"\0", offset)].decode()
+
+        def sharedString(offset):
+            if not offset in shared:
+                shared[offset] = string(offset).split()
+            return shared[offset]
+
+        stateIDs = []
+
+        for names, sequence, structure, dG, dH, n_complexes in zip(columns["names"].tolist(), columns["sequence"].tolist(),
+                columns["structure"].tolist(), columns["energy"].tolist(), columns["enthalpy"].tolist(), columns["complex_count"].tolist()):
+
+            # the energies as the text files print them, so both give the same statespace
+            mywords = [n_complexes] + sharedString(names) + sharedString(sequence) + string(structure).split() + ["%f" % dG, "%f" % dH]
+            uniqueID, energyvals, seqs = self.parseWords(mywords, simulatedTemperature, simulatedConc)
+
+            stateIDs.append(uniqueID)
+
+            if not uniqueID in sequences:
+                sequences[uniqueID] = seqs
+
+            if not uniqueID in space:
+
+                space[uniqueID] = energyvals
+
+            elif not space[uniqueID] == energyvals:
+
+                print("My hashmap contains " + str(uniqueID) + " with Energy " + str(space[uniqueID]) + " but found: " + str(energyvals))
+                print("Line = " + " ".join(str(word) for word in mywords))
+
+        complexCount = columns["complex_count"]
+
+        for stateFrom, stateTo, arrType in zip(columns["from"].tolist(), columns["to"].tolist(), columns["type"].tolist()):
+
+            transitionPair = (stateIDs[stateFrom], stateIDs[stateTo])
+
+            if not transitionPair in transitions:
+
+                transitionList = list()
+
+                if complexCount[stateFrom] == complexCount[stateTo]:
+                    transitionList.append(transitiontype.unimolecular)
+
+                if complexCount[stateFrom] > complexCount[stateTo]:
+                    transitionList.append(transitiontype.bimolecularIn)
+
+                if complexCount[stateTo] > complexCount[stateFrom]:
+                    transitionList.append(transitiontype.bimolecularOut)
+
+                if arrhenius:
+                    transitionList.extend(codeToDesc(int(arrType)))
+
+                transitions[transitionPair] = transitionList
+
+        if len(columns["initial_state"]) == 0:
+            print("No initial states found!")
+
+        for state, count in zip(columns["initial_state"].tolist(), columns["initial_count"].tolist()):
+
+            if not stateIDs[state] in initStates:
+
+                newEntry = InitCountFlux()
+                newEntry.count = count
+                newEntry.flux = 777777  # arrType is the flux, and is unique to the initial state
+
+                initStates[stateIDs[state]] = newEntry
+
+        for state, tag in zip(columns["final_state"].tolist(), columns["final_tag"].tolist()):
+
+            if not stateIDs[state] in finalStates:
+                finalStates[stateIDs[state]] = string(tag)
+
     """ Runs genAndSavePathsFile until convergence is reached"""
 
     def genUntilConvergence(self, precision):
@@ -701,6 +814,7 @@ class Builder(object):
 
             myOptions = optionsF(optionsArgs)
             myOptions.activestatespace = True
+            myOptions.statespace_binary = self.binaryStatespace
             myOptions.output_interval = 1
 
             if not supplyInitialState == None:
@@ -723,6 +837,18 @@ class Builder(object):
             if self.verbosity:
                 print("Multistrand simulation is now done,      time = %.2f" % (time.time() - simTime))
 
+            directory = self.the_dir + str(myOptions.interface.current_seed)
+
+            if self.binaryStatespace:
+
+                self.loadStatespace(directory + "/statespace.bin", myOptions._temperature_kelvin, myOptions.join_concentration,
+                                    myOptions.rate_method == Literals.arrhenius, space, transitions, initStates, finalStates, sequences)
+
+                os.remove(directory + "/statespace.bin")
+                os.rmdir(directory)
+
+                return
+
             """ load the space """
             myFile = open(self.the_dir + str(myOptions.interface.current_seed) + "/protospace.txt", "r")
 
@@ -882,8 +1008,14 @@ class Builder(object):
 # starting in an initial state and reaching a final state.
 class BuilderRate(object):
 
+    # 1 - 10: scipy solvers on the rate matrix of setMatrix, without and with a Jacobi preconditioner
+    # 11 - 14: multistrand.system.passage_times, BiCGSTAB or GMRES with a Jacobi or ILU(0) preconditioner
     solveToggle = 2
 
+    nativeSolvers = {11: (0, 0), 12: (0, 1), 13: (1, 0), 14: (1, 1)}  # solveToggle: (solver, preconditioner)
+    nativeTolerance = 1e-10
+    nativeThreads = 1
+
     # input function returns the multistrand options object for which to build the statespace
     def __init__(self, builderIn):
 
@@ -894,7 +1026,11 @@ class BuilderRate(object):
             raise ValueError('No final states found.')
 
         self.processStates()  # prunes statespace and creates objects that can be used to create the rate matrx
-        self.setMatrix()  # generates the matrix for the current temperature
+
+        if self.solveToggle in self.nativeSolvers:
+            self.setTables()  # the rate matrix is assembled natively
+        else:
+            self.setMatrix()  # generates the matrix for the current temperature
 
     """ Generates the state space by traversing from the final states """
 
@@ -1210,6 +1346,64 @@ class BuilderRate(object):
         self.n_states = N
         self.n_transitions = len(rates)
 
+    """ The state and transition tables that passage_times assembles the rate matrix from.
+        Times are then indexed by every state in the statespace, final states included. """
+
+    def setTables(self):
+
+        states = list(self.statespace)
+        self.stateIndex = {state: i for i, state in enumerate(states)}
+
+        myT = self.build.options._temperature_kelvin
+        arrhenius = self.build.options.rate_method == Literals.arrhenius
+
+        self.energies = np.array([float(self.build.protoSpace[state].dG(myT)) for state in states], dtype=np.float64)
+        self.final = np.array([state in self.final_states for state in states], dtype=np.uint8)
+
+        source, target, kind, left, right = [], [], [], [], []
+
+        for state in states:
+
+            for neighbor in self.neighbors[state]:
+
+                transitionlist = self.build.protoTransitions[(state, neighbor)]
+
+                source.append(self.stateIndex[state])
+                target.append(self.stateIndex[neighbor])
+                kind.append(transitiontype.array.index(transitionlist[0]))
+
+                if arrhenius:
+                    left.append(localtype.array.index(transitionlist[1]))
+                    right.append(localtype.array.index(transitionlist[2]))
+                else:
+                    left.append(0)
+                    right.append(0)
+
+        self.source = np.array(source, dtype=np.uint32)
+        self.target = np.array(target, dtype=np.uint32)
+        self.kind = np.array(kind, dtype=np.int8)
+        self.left = np.array(left, dtype=np.int8)
+        self.right = np.array(right, dtype=np.int8)
+
+        self.n_states = len(states) - len(self.final_states)
+
+    def nativeTime(self, maxiter=None):
+
+        solver, preconditioner = self.nativeSolvers[self.solveToggle]
+
+        times, converged, iterations, residual, rows, entries = passage_times(self.build.options, self.energies, self.final,
+                self.source, self.target, self.kind, self.left, self.right, solver=solver, preconditioner=preconditioner,
+                tolerance=self.nativeTolerance, max_iterations=maxiter or 0, threads=self.nativeThreads, rate_limit=self.rateLimit,
+                gas_constant=float(Energy.GAS_CONSTANT))
+
+        if not converged:
+            print("The passage times did not converge, residual = %.2E after %d iterations" % (residual, iterations))
+
+        self.n_states = rows
+        self.n_transitions = entries
+
+        return np.frombuffer(times, dtype=np.float64)
+
     """ 
         Computes the first passage times
     """
@@ -1218,7 +1412,10 @@ class BuilderRate(object):
 
         startTime = time.time()
 
-        if self.solveToggle == 1:
+        if self.solveToggle in self.nativeSolvers:
+            firstpassagetimes = self.nativeTime(maxiter=maxiter)
+
+        elif self.solveToggle == 1:
             firstpassagetimes, info = bicg(self.rate_matrix_csr, self.b, x0=x0, maxiter=maxiter)
 
         elif self.solveToggle == 2:
@@ -1316,7 +1513,8 @@ class BuilderRate(object):
 
                 output += "s1 = " + str(state) + "  s2 = " + str(neighbor) + " for = " + "%.2E" % myRate + " back = " + "%.2E" % revRate + "   tlist = " + str(transitionlist) + "\n"
 
-        output += str(self.rate_matrix_csr.toarray())
+        if hasattr(self, "rate_matrix_csr"):
+            output += str(self.rate_matrix_csr.toarray())
 
         return output
 
@@ -22,7 +22,7 @@ import copy
 import sys
 import random
 
-from multistrand.options import Options, Literals
+from multistrand.options import Options, Literals, ResultArrays
 import multiprocessing
 import numpy as np
 
@@ -59,6 +59,13 @@ class MergeResult(object):
             
     def generateCounts(self):
 
+        if isinstance(self.dataset, ResultArrays):
+            self.nForward = int(np.count_nonzero(self.dataset.has_tag(Literals.success)))
+            self.nReverse = int(np.count_nonzero(self.dataset.has_tag(Literals.failure)))
+            self.nForwardAlt = int(np.count_nonzero(self.dataset.has_tag(Literals.alt_success)))
+            self.nTotal = len(self.dataset)
+            return
+
         # Pre-computing some metrics
         self.nForward = sum([i.tag == Literals.success for i in self.dataset])
         self.nReverse = sum([i.tag == Literals.failure for i in self.dataset])
@@ -68,8 +75,18 @@ class MergeResult(object):
         
     def merge(self, that, deepCopy=False):
 
+        # an empty result takes on the arrays of native results
+        if isinstance(that.dataset, ResultArrays) and len(self.dataset) == 0:
+            self.dataset = ResultArrays()
+
         # Now merge the existing datastructures with the ones from the new dataset
-        if deepCopy:
+        if isinstance(self.dataset, ResultArrays):
+
+            self.dataset.extend(that.dataset)
+            for state in that.endStates:
+                self.endStates.append(copy.deepcopy(state))
+
+        elif deepCopy:
             
             for data in that.dataset:
                 self.dataset.append(data)
@@ -82,6 +99,14 @@ class MergeResult(object):
         
         self.generateCounts()
         
+    def resampleDataset(self):
+        # draws len(dataset) results with replacement
+
+        N = len(self.dataset)
+        if isinstance(self.dataset, ResultArrays):
+            return self.dataset.take(np.random.randint(0, N, N))
+        return np.random.choice(self.dataset, N, True).tolist()
+
     """ Convenience methods  """
 
     def doBootstrap(self, NIn=1000):
@@ -104,65 +129,76 @@ class MergeResult(object):
 # # Migration rates for first step
 class FirstStepRate(MergeResult):
 
+    def sumCollision(self, tag):
+        if isinstance(self.dataset, ResultArrays):
+            return np.sum(self.dataset.collision_rate[self.dataset.has_tag(tag)])
+        return sum([float(i.collision_rate) for i in self.dataset if i.tag == tag])
+
+    def sumCollisionTime(self, tag):
+        if isinstance(self.dataset, ResultArrays):
+            mask = self.dataset.has_tag(tag)
+            return np.dot(self.dataset.collision_rate[mask], self.dataset.time[mask])
+        return sum([float(i.collision_rate) * float(i.time) for i in self.dataset if i.tag == tag])
+
     def sumCollisionForward(self):
-        return sum([np.float(i.collision_rate) for i in self.dataset if i.tag == Literals.success])
+        return self.sumCollision(Literals.success)
 
     def sumCollisionForwardAlt(self):
-        return sum([np.float(i.collision_rate) for i in self.dataset if i.tag == Literals.alt_success])
+        return self.sumCollision(Literals.alt_success)
 
     def sumCollisionReverse(self):
-        return sum([np.float(i.collision_rate) for i in self.dataset if i.tag == Literals.failure])
+        return self.sumCollision(Literals.failure)
 
     def weightedForwardUni(self):
 
-        mean_collision_forward = np.float(self.sumCollisionForward()) / np.float(self.nForward)
-        weightedForwardUni = sum([np.float(i.collision_rate) * np.float(i.time) for i in self.dataset if i.tag == Literals.success])
+        mean_collision_forward = float(self.sumCollisionForward()) / float(self.nForward)
+        weightedForwardUni = self.sumCollisionTime(Literals.success)
 
-        return weightedForwardUni / (mean_collision_forward * np.float(self.nForward))
+        return weightedForwardUni / (mean_collision_forward * float(self.nForward))
 
     def weightedReverseUni(self):
 
         if self.nReverse == 0:
-            return np.float(0)
+            return float(0)
 
-        mean_collision_reverse = np.float(self.sumCollisionReverse()) / np.float(self.nReverse)
-        weightedReverseUni = sum([np.float(i.collision_rate) * np.float(i.time) for i in self.dataset if i.tag == Literals.failure])
+        mean_collision_reverse = float(self.sumCollisionReverse()) / float(self.nReverse)
+        weightedReverseUni = self.sumCollisionTime(Literals.failure)
 
-        return weightedReverseUni / (mean_collision_reverse * np.float(self.nReverse))
+        return weightedReverseUni / (mean_collision_reverse * float(self.nReverse))
 
     def k1(self):
 
         if self.nForward == 0:
             return MINIMUM_RATE
         else:
-            return self.sumCollisionForward() / np.float(self.nTotal)
+            return self.sumCollisionForward() / float(self.nTotal)
 
     def k1Alt(self):
         if self.nForwardAlt == 0:
             return MINIMUM_RATE
         else:
-            return self.sumCollisionForwardAlt() / np.float(self.nTotal)
+            return self.sumCollisionForwardAlt() / float(self.nTotal)
 
     def k1Prime(self):
 
         if self.nReverse == 0:
             return MINIMUM_RATE
         else:
-            return self.sumCollisionReverse() / np.float(self.nTotal)
+            return self.sumCollisionReverse() / float(self.nTotal)
 
     def k2(self):
 
         if self.nForward == 0:
             return MINIMUM_RATE
         else:
-            return np.float(1.0) / self.weightedForwardUni()
+            return float(1.0) / self.weightedForwardUni()
 
     def k2Prime(self):
 
         if self.nReverse == 0:
             return MINIMUM_RATE
         else:
-            return np.float(1.0) / self.weightedReverseUni()
+            return float(1.0) / self.weightedReverseUni()
 
     def kEff(self, concentration=None):
 
@@ -170,7 +206,7 @@ class FirstStepRate(MergeResult):
             print("Cannot compute k_effective without concentration")
             return MINIMUM_RATE
 
-        concentration = np.float(concentration)
+        concentration = float(concentration)
 
         if self.nForward == 0:
             return MINIMUM_RATE
@@ -181,12 +217,12 @@ class FirstStepRate(MergeResult):
         # the expected rate for a collision
         collTime = self.k1() + self.k1Prime()
 
-        dTForward = np.float(1.0) / self.k2() + np.float(1.0) / (concentration * collTime)
-        dTReverse = np.float(1.0) / self.k2Prime() + np.float(1.0) / (concentration * collTime)
+        dTForward = float(1.0) / self.k2() + float(1.0) / (concentration * collTime)
+        dTReverse = float(1.0) / self.k2Prime() + float(1.0) / (concentration * collTime)
 
         dT = dTReverse * multiple + dTForward
 
-        return (np.float(1.0) / dT) * (np.float(1.0) / concentration)
+        return (float(1.0) / dT) * (float(1.0) / concentration)
 
     def testForTwoStateness(self, concentration=None):
 
@@ -195,8 +231,8 @@ class FirstStepRate(MergeResult):
             return True
 
         # Test if the failed trajectory and the success trajectory are dominated ( > 10% of total ) by the unimolecular phase
-        tau_bi_succ = np.float(1) / (self.k1() * concentration)
-        tau_bi_fail = np.float(1) / (self.k1Prime() * concentration)
+        tau_bi_succ = float(1) / (self.k1() * concentration)
+        tau_bi_fail = float(1) / (self.k1Prime() * concentration)
 
         testFail = (tau_bi_fail / self.weightedReverseUni()) < 9
         testSucces = (tau_bi_succ / self.weightedForwardUni()) < 9
@@ -210,9 +246,7 @@ class FirstStepRate(MergeResult):
     def resample(self):
         # returns a new rates object with resampled data
 
-        N = len(self.dataset)
-        newDataset = np.random.choice(self.dataset, N, True).tolist()
-        return FirstStepRate(newDataset)
+        return FirstStepRate(self.resampleDataset())
 
     def castToNumpyArray(self):
 
@@ -264,35 +298,38 @@ class FirstStepRate(MergeResult):
 class FirstStepLeakRate(MergeResult):
     
     def __init__(self, dataset=None, endStates=None):
+        if isinstance(dataset, ResultArrays):
+            raise ValueError("FirstStepLeakRate needs Result objects, run without native_results.")
+
         super(FirstStepLeakRate, self).__init__(dataset, endStates)
     
         """ Now discard all non-success data """
         self.dataset = [x for x in self.dataset if ((x.tag == Literals.success) or x.tag == Literals.alt_success)]
 
     def sumCollisionForward(self):
-        return sum([np.float(i.collision_rate) for i in self.dataset if i.tag == Literals.success])
+        return sum([float(i.collision_rate) for i in self.dataset if i.tag == Literals.success])
 
     def sumCollisionForwardAlt(self):
-        return sum([np.float(i.collision_rate) for i in self.dataset if i.tag == Literals.alt_success])
+        return sum([float(i.collision_rate) for i in self.dataset if i.tag == Literals.alt_success])
 
     def k1(self):
         if self.nForward == 0:
             return MINIMUM_RATE
         else:
-            return self.sumCollisionForward() / np.float(self.nTotal)
+            return self.sumCollisionForward() / float(self.nTotal)
 
     def k1Alt(self):
         if self.nForwardAlt == 0:
             return MINIMUM_RATE
         else:
-            return self.sumCollisionForwardAlt() / np.float(self.nTotal)
+            return self.sumCollisionForwardAlt() / float(self.nTotal)
 
     def resample(self):
 
         new_dataset = []
         time_outs = self.nTotal - self.nForward - self.nReverse - self.nForwardAlt
         successful_trials = len(self.dataset)
-        p = np.float(successful_trials) / self.nTotal
+        p = float(successful_trials) / self.nTotal
         # the number of succesful trials
         success = np.random.binomial(self.nTotal, p)
 
@@ -366,20 +403,22 @@ class FirstPassageRate(MergeResult):
 
     def resample(self):
 
-        N = len(self.dataset)
-        newDataset = np.random.choice(self.dataset, N, True).tolist()
+        return FirstPassageRate(self.resampleDataset())
 
-        return FirstPassageRate(newDataset)
+    def meanTime(self):
+        if isinstance(self.dataset, ResultArrays):
+            return np.mean(self.dataset.time)
+        return np.mean([i.time for i in self.dataset])
 
     def k1(self):
         
-        mean = np.mean([i.time for i in self.dataset])
-        return np.float(1.0) / (mean)
+        mean = self.meanTime()
+        return float(1.0) / (mean)
 
     def kEff(self, concentration):
 
-        mean = np.mean([i.time for i in self.dataset])
-        kEff = np.float(1.0) / (mean * concentration)
+        mean = self.meanTime()
+        kEff = float(1.0) / (mean * concentration)
 
         return kEff
 
@@ -509,7 +548,7 @@ class optionsFactory(object):
         if output == None:
             sys.exit("MergeSim error: Did not recieve Options object from the factory function.")
 
-        output.initial_seed = inputSeed
+        output.initial_seed = int(inputSeed)  # the simulator reads the seed as an integer
 
         return output
 
@@ -880,6 +919,11 @@ class MergeSim(object):
             if not myOptions.simulation_mode == Literals.first_step:
                 self.settings.rateFactory.first_passage_time = MergeSimSettings.RESULTTYPE3
 
+            if myOptions.native_results and self.settings.resultsType == MergeSimSettings.RESULTTYPE2:
+                print("MergeSim error: leak mode needs Result objects, run without native_results.")
+                self.exceptionFlag.value = False
+                return
+
             try:
                 s = SimSystem(myOptions)
                 s.start()
@@ -887,13 +931,22 @@ class MergeSim(object):
                 self.exceptionFlag.value = False
                 return
 
-            myFSR = self.settings.rateFactory(myOptions.interface.results)
+            if myOptions.native_results:
+                dataset = myOptions.interface.result_arrays
+            else:
+                dataset = myOptions.interface.results
+
+            myFSR = self.settings.rateFactory(dataset)
             nForwardIn.value += myFSR.nForward + myFSR.nForwardAlt
             nReverseIn.value += myFSR.nReverse
 
-            for result in myOptions.interface.results:
+            if myOptions.native_results:
+                # the arrays of all trials of this process go as one entry
+                list0.append(dataset)
+            else:
+                for result in dataset:
 
-                list0.append(result)
+                    list0.append(result)
 
             for endState in myOptions.interface.end_states:
 
@@ -932,7 +985,13 @@ class MergeSim(object):
             # Leak - the below is a leak rates object
             # NB: Initialize with a dataset, but we merge with
             # a differrent rates object.
-            myFSR = self.settings.rateFactory(self.managed_result, self.managed_endStates)
+            dataset = self.managed_result
+            if len(dataset) > 0 and isinstance(dataset[0], ResultArrays):
+                dataset = ResultArrays()
+                for arrays in self.managed_result:
+                    dataset.extend(arrays)
+
+            myFSR = self.settings.rateFactory(dataset, self.managed_endStates)
 
             self.results.merge(myFSR, deepCopy=True)
 
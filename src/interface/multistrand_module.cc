@@ -14,6 +14,9 @@
 #include "ssystem.h"
 #include "simoptions.h"
 #include "options.h"
+#include "passagetime.h"
+#include "boltzmannsampler.h"
+#include "rng.h"
 #include <string.h>
 /* for strcmp */
 
@@ -66,18 +69,37 @@ static int SimSystemObject_init(SimSystemObject *self, PyObject *args) {
 		PyErr_SetString(PyExc_MemoryError, "Could not create the SimulationSystem [C++] object, possibly memory issues?.");
 		return -1;
 	}
+	if (PyErr_Occurred()) /* an option could not be read */
+	{
+		delete self->ob_system;
+		self->ob_system = NULL;
+		Py_CLEAR(self->options);
+		return -1;
+	}
 	return 0;
 }
 
-static PyObject *SimSystemObject_start(SimSystemObject *self, PyObject *args) {
-	if (!PyArg_ParseTuple(args, ":start"))
+static PyObject *SimSystemObject_start(SimSystemObject *self, PyObject *args, PyObject *keywds) {
+	long trials = -1;
+	int threads = 1;
+
+	static char *kwlist[] = { "trials", "threads", NULL };
+
+	if (!PyArg_ParseTupleAndKeywords(args, keywds, "|li:start( [trials=None, threads=1])", kwlist, &trials, &threads))
 		return NULL;
 
 	if (self->ob_system == NULL) {
 		PyErr_SetString(PyExc_AttributeError, "The associated SimulationSystem [C++] object no longer exists, cannot start the system.");
 		return NULL;
 	}
-	self->ob_system->StartSimulation();
+
+	if (trials < 0 && threads <= 1)
+		self->ob_system->StartSimulation();
+	else {
+		if (trials < 0)
+			getLongAttr(self->options, num_simulations, &trials);
+		self->ob_system->StartSimulation(trials, threads);
+	}
 
 	Py_INCREF(Py_None);
 	return Py_None;
@@ -111,6 +133,17 @@ static PyObject *SimSystemObject_localTransitions(SimSystemObject *self, PyObjec
 	return Py_None;
 }
 
+static PyObject *SimSystemObject_transitionRates(SimSystemObject *self, PyObject *args) {
+	if (!PyArg_ParseTuple(args, ":transitionRates"))
+		return NULL;
+
+	if (self->ob_system == NULL) {
+		PyErr_SetString(PyExc_AttributeError, "The associated SimulationSystem [C++] object no longer exists, cannot query the system.");
+		return NULL;
+	}
+	return self->ob_system->transitionRates(NULL);
+}
+
 static int SimSystemObject_traverse(SimSystemObject *self, visitproc visit, void *arg) {
 	Py_VISIT(self->options);
 	return 0;
@@ -141,11 +174,18 @@ actually run the simulation. Otherwise fairly boring.\n";
 
 const char docstring_SimSystem_start[] =
 		"\
-SimSystem.start( self )\n\
+SimSystem.start( self, trials=None, threads=1 )\n\
 \n\
 Start the simulation; only returns when the simulation has been completed. \n\
 Information is only returned from the simulation via the Options object it \n\
-was created with.\n";
+was created with.\n\
+\n\
+trials = None [default]: run options.num_simulations trajectories.\n\
+threads = 1 [default]: with more threads, the trajectories run in parallel \n\
+without holding the GIL, and the results are handed back in trial order once \n\
+all of them have finished. Settings that export states during a run \n\
+(trajectory output, transition mode, statespace building, cotranscriptional \n\
+folding) always use a single thread.\n";
 
 const char docstring_SimSystem_initialInfo[] = "\
 SimSystem.initialInfo( self )\n\
@@ -158,6 +198,16 @@ SimSystem.localTransitions( self )\n\
 \n\
 Given the initial state, traverses into each transition once. \n";
 
+const char docstring_SimSystem_transitionRates[] =
+		"\
+SimSystem.transitionRates( self )\n\
+\n\
+Returns the transitions of the initial state, a list with an entry \n\
+(energy, moves) per complex. Each move is a tuple \n\
+(create, first, second, rate): whether the base pair is created or deleted, \n\
+the index of its bases in the sequence of the complex, with the strand \n\
+breaks counted, and its rate. Moves are ordered by base pair. \n";
+
 const char docstring_SimSystem_init[] =
 		"\
 :meth:`multistrand.system.SimSystem.__init__( self, *args )`\n\
@@ -171,9 +221,10 @@ options [type=:class:`multistrand.options.Options`]  -- The options to use for\n
 \n";
 
 static PyMethodDef SimSystemObject_methods[] = { { "__init__", (PyCFunction) SimSystemObject_init, METH_COEXIST | METH_VARARGS, PyDoc_STR(
-		docstring_SimSystem_init) }, { "start", (PyCFunction) SimSystemObject_start, METH_VARARGS, PyDoc_STR(docstring_SimSystem_start) }, { "initialInfo",
+		docstring_SimSystem_init) }, { "start", (PyCFunction)(void(*)(void)) SimSystemObject_start, METH_VARARGS | METH_KEYWORDS, PyDoc_STR(docstring_SimSystem_start) }, { "initialInfo",
 		(PyCFunction) SimSystemObject_initialInfo, METH_VARARGS, PyDoc_STR(docstring_SimSystem_initialInfo) }, { "localTransitions",
-		(PyCFunction) SimSystemObject_localTransitions, METH_VARARGS, PyDoc_STR(docstring_SimSystem_localTransitions) }, { NULL, NULL } /* Sentinel */
+		(PyCFunction) SimSystemObject_localTransitions, METH_VARARGS, PyDoc_STR(docstring_SimSystem_localTransitions) }, { "transitionRates",
+		(PyCFunction) SimSystemObject_transitionRates, METH_VARARGS, PyDoc_STR(docstring_SimSystem_transitionRates) }, { NULL, NULL } /* Sentinel */
 /* Note that the dealloc, etc methods are not
  defined here, they're in the type object's
  methods table, not the basic methods table. */
@@ -375,6 +426,146 @@ static PyObject *System_calculate_rate(PyObject *self, PyObject *args, PyObject
 	return rate;
 }
 
+static PyObject *System_passage_times(PyObject *self, PyObject *args, PyObject *keywds) {
+
+	PyObject *options_object = NULL;
+	Py_buffer energy, final, source, target, kind, left, right;
+	int method = PASSAGE_BICGSTAB;
+	int preconditioner = PASSAGE_JACOBI;
+	double tolerance = 1e-10;
+	long maxIterations = 0;
+	int threads = 1;
+	double gas = gasConstant;
+	PassageRates rates;
+
+	static char *kwlist[] = { "options", "energy", "final", "source", "target", "kind", "left", "right", "solver", "preconditioner", "tolerance",
+			"max_iterations", "threads", "rate_limit", "gas_constant", NULL };
+
+	if (!PyArg_ParseTupleAndKeywords(args, keywds, "Oy*y*y*y*y*y*y*|iidlidd:passage_times(options, energy, final, source, target, kind, left, right, ...)",
+			kwlist, &options_object, &energy, &final, &source, &target, &kind, &left, &right, &method, &preconditioner, &tolerance, &maxIterations,
+			&threads, &rates.rateLimit, &gas))
+		return NULL;
+
+	Py_buffer *buffers[] = { &energy, &final, &source, &target, &kind, &left, &right };
+
+	long stateCount = energy.len / sizeof(double);
+	long transitionCount = source.len / sizeof(uint32_t);
+
+	bool valid = final.len == stateCount && target.len == source.len && kind.len == transitionCount && left.len == transitionCount
+			&& right.len == transitionCount;
+
+	for (long i = 0; valid && i < transitionCount; i++) {
+		uint32_t from = ((uint32_t*) source.buf)[i], to = ((uint32_t*) target.buf)[i];
+		int8_t k = ((int8_t*) kind.buf)[i], l = ((int8_t*) left.buf)[i], r = ((int8_t*) right.buf)[i];
+		valid = from < stateCount && to < stateCount && k >= PASSAGE_UNIMOLECULAR && k <= PASSAGE_BIMOLECULAR_OUT && l >= 0 && l < MOVETYPE_SIZE
+				&& r >= 0 && r < MOVETYPE_SIZE;
+	}
+
+	if (!valid) {
+
+		for (Py_buffer *buffer : buffers)
+			PyBuffer_Release(buffer);
+
+		PyErr_SetString(PyExc_ValueError, "The state and transition tables do not match: energy (float64) and final (uint8) per state, "
+				"source and target (uint32), kind, left and right (int8) per transition.");
+		return NULL;
+
+	}
+
+	// the constants of the energy model for these options
+	PEnergyOptions energyOptions(options_object);
+
+	rates.RT = gas * energyOptions.getTemperature();
+	rates.uniScale = energyOptions.getUniScale();
+	rates.biScale = energyOptions.getBiScale();
+	rates.concentration = energyOptions.getJoinConcentration();
+	rates.arrhenius = energyOptions.usingArrhenius();
+
+	for (int i = 0; i < MOVETYPE_SIZE; i++) {
+		rates.lnA[i] = energyOptions.AValues[i];
+		rates.E[i] = energyOptions.EValues[i];
+	}
+
+	PyObject *times = PyBytes_FromStringAndSize(NULL, stateCount * sizeof(double));
+	PassageTimeSolver solver(threads);
+	bool converged;
+
+	Py_BEGIN_ALLOW_THREADS
+
+	solver.build(rates, stateCount, (double*) energy.buf, (uint8_t*) final.buf, transitionCount, (uint32_t*) source.buf, (uint32_t*) target.buf,
+			(int8_t*) kind.buf, (int8_t*) left.buf, (int8_t*) right.buf);
+	converged = solver.solve(method, preconditioner, tolerance, maxIterations, (double*) PyBytes_AS_STRING(times));
+
+	Py_END_ALLOW_THREADS
+
+	for (Py_buffer *buffer : buffers)
+		PyBuffer_Release(buffer);
+
+	return Py_BuildValue("(NOldll)", times, converged ? Py_True : Py_False, solver.iterations, solver.residual, solver.rowCount(), solver.entryCount());
+
+}
+
+static PyObject *System_boltzmann_sample(PyObject *self, PyObject *args, PyObject *keywds) {
+
+	PyObject *options_object = NULL;
+	const char *sequence = NULL;
+	long count = 1;
+	long seed = 0;
+
+	static char *kwlist[] = { "options", "sequence", "count", "seed", NULL };
+
+	if (!PyArg_ParseTupleAndKeywords(args, keywds, "Os|ll:boltzmann_sample(options, sequence, count=1, seed=0)", kwlist, &options_object, &sequence,
+			&count, &seed))
+		return NULL;
+
+	string strands = sequence;
+	bool valid = count >= 0 && !strands.empty() && strands.front() != '+' && strands.back() != '+' && strands.find("++") == string::npos;
+
+	for (char c : strands)
+		valid = valid && (c == '+' || baseLookup(c) > 0);
+
+	if (!valid) {
+
+		PyErr_SetString(PyExc_ValueError, "Expected a sequence of A, C, G, T or U strands separated by '+', and a count of at least 0.");
+		return NULL;
+
+	}
+
+	if (testLongAttr(options_object, parameter_type, =, 0))
+		throw std::invalid_argument("Attempting to load ViennaRNA parameters (depreciated)");
+
+	NupackEnergyModel *em = new NupackEnergyModel(options_object);
+	vector<string> structures(count);
+	double freeEnergy;
+
+	Py_BEGIN_ALLOW_THREADS
+
+	BoltzmannSampler sampler(em, strands);
+	Xoshiro256 rng;
+
+	rng.seed(seed);
+	freeEnergy = sampler.freeEnergy();
+
+	if (sampler.hasStructures()) {
+		for (string& structure : structures)
+			structure = sampler.sample(rng);
+	} else {
+		structures.clear();
+	}
+
+	Py_END_ALLOW_THREADS
+
+	delete em;
+
+	PyObject *output = PyList_New(structures.size());
+
+	for (size_t i = 0; i < structures.size(); i++)
+		PyList_SET_ITEM(output, i, PyUnicode_FromString(structures[i].c_str()));
+
+	return Py_BuildValue("(Nd)", output, freeEnergy);
+
+}
+
 static PyObject *System_run_system(PyObject *self, PyObject *args) {
 #ifdef PROFILING
 	HeapProfilerStart("ssystem_run_system.heap");
@@ -420,7 +611,7 @@ energy_type = 3 ('Tube energy'): include dG_volume + dG_assoc.  Summed over comp
 \n\
 options = None [default]: Use the already initialized energy model.\n\
 options = ...: If not none, should be a multistrand.options.Options object, which will be used for initializing the energy model ONLY if there is not one already present.\n") },
-				{ "calculate_rate", (PyCFunction) System_calculate_rate, METH_VARARGS | METH_KEYWORDS,
+				{ "calculate_rate", (PyCFunction)(void(*)(void)) System_calculate_rate, METH_VARARGS | METH_KEYWORDS,
 						PyDoc_STR(
 								" \
 calculate_rate(start_energy, end_energy, options=None, joinflag=0)\n\
@@ -441,6 +632,36 @@ joinflag = 2: bimolecular break, energies are relevant\n") },
 initialize_energy_model( options = None )\n\
 Initialize the Multistrand module's energy model using the options object given. If a model already exists, this will remove the old model and create a new one - useful for certain parameter changes, but should be avoided if possible. This function is NOT required to use other parts of the module - by default they will create the model if it's not found, or use the one already initialized; this adds control over exactly what model is being used.\n\n\
 options [default=None]: when no options object is passed, this removes the old energy model and does not create a new one.\n") },
+				{ "passage_times", (PyCFunction)(void(*)(void)) System_passage_times, METH_VARARGS | METH_KEYWORDS,
+						PyDoc_STR(
+								" \
+passage_times(options, energy, final, source, target, kind, left, right, solver=0, preconditioner=0, tolerance=1e-10, max_iterations=0, threads=1, rate_limit=1e-5, gas_constant)\n\
+Computes the mean first passage times into the final states of a statespace, as multistrand.builder.BuilderRate does.\n\
+\n\
+Parameters\n\
+options: the multistrand.options.Options object that gives the temperature, rate method and rate constants.\n\
+energy, final: per state, the free energy (float64) and whether it is final (uint8).\n\
+source, target, kind, left, right: per transition, the states (uint32), the index in transitiontype.array (int8) and the index of either half context in localtype.array (int8). Transitions are taken in both directions.\n\
+solver = 0 [default]: BiCGSTAB, 1: restarted GMRES.\n\
+preconditioner = 0 [default]: Jacobi, 1: ILU(0).\n\
+max_iterations = 0 [default]: ten times the number of states.\n\
+threads: the product with the rate matrix is split over this many threads.\n\
+rate_limit: rates at or below this are left out.\n\
+gas_constant: in kcal / K mol, the constant of the energy model by default. Pass the one the energies were computed with.\n\
+\n\
+Returns (times, converged, iterations, residual, rows, entries), times are float64 bytes per state, 0 for final states.\n") },
+				{ "boltzmann_sample", (PyCFunction)(void(*)(void)) System_boltzmann_sample, METH_VARARGS | METH_KEYWORDS,
+						PyDoc_STR(
+								" \
+boltzmann_sample(options, sequence, count=1, seed=0)\n\
+Draws structures of a complex from its Boltzmann distribution, with the energy model of the options object.\n\
+\n\
+Parameters\n\
+sequence: the strands of the complex in order, separated by '+'.\n\
+count: the number of structures to draw.\n\
+seed: the seed of the random generator.\n\
+\n\
+Returns (structures, free_energy): a list of dot paren structures, empty if the strands cannot form a connected complex, and the free energy of the ensemble in kcal/mol, without dG_assoc or dG_volume.\n") },
 				{ "run_system", (PyCFunction) System_run_system, METH_VARARGS, PyDoc_STR(
 						" \
 run_system( options )\n\
@@ -67,6 +67,12 @@ identList::identList(long newuid, char *newid, class identList *old) {
 	next = old;
 }
 
+identList *identList::copy(void) {
+
+	return new identList(uid, id, next == NULL ? NULL : next->copy());
+
+}
+
 std::string identList::toString() {
 
 	if (id != NULL) {
@@ -8,8 +8,9 @@
 #
 
 from multistrand._options.options   import Options, Literals
-from multistrand._options.interface import Result
+from multistrand._options.interface import Result, ResultArrays
 
 Options.__module__ = 'multistrand.options'
 Result.__module__ = 'multistrand.options'
+ResultArrays.__module__ = 'multistrand.options'
 
@@ -0,0 +1,163 @@
+"""
+    Reads the binary trajectory files that Multistrand writes when
+    options.trajectory_file is set (see trajectorywriter.h for the format).
+
+    A TrajectoryFile indexes the records of the file, but only decodes states
+    when they are asked for: frames() replays a trajectory state by state, and
+    frame(k) starts from the nearest state it has seen before.
+
+    A state is a Frame(time, arrType, complexes), the complexes are the same
+    tuples as in options.full_trajectory:
+    (seed, unique complex id, strand names, sequence, structure, energy, enthalpy)
+"""
+import mmap
+import struct
+from collections import namedtuple
+
+Frame = namedtuple("Frame", ["time", "arrType", "complexes"])
+
+MAGIC = b"MSTRAJ01"
+
+_record = struct.Struct("=cI")
+_seed = struct.Struct("=q")
+_frame = struct.Struct("=dd")
+_count = struct.Struct("=I")
+_id = struct.Struct("=i")
+_complex = struct.Struct("=idd")
+_pair = struct.Struct("=II")
+
+# every this many frames, a decoded state is kept for random access
+CHECKPOINT_INTERVAL = 256
+
+
+class _State(object):
+    """ The complexes of a trajectory while its frames are applied. """
+
+    def __init__(self, seed):
+        self.seed = seed
+        self.order = []
+        self.complexes = dict()  # id: [names, sequence, structure, energy, enthalpy]
+
+    def copy(self):
+        state = _State(self.seed)
+        state.order = list(self.order)
+        state.complexes = {k: [v[0], v[1], bytearray(v[2]), v[3], v[4]] for k, v in self.complexes.items()}
+        return state
+
+    def output(self):
+        return [(self.seed, i, c[0], c[1], c[2].decode(), c[3], c[4]) for i, c in ((i, self.complexes[i]) for i in self.order)]
+
+
+class TrajectoryFile(object):
+
+    def __init__(self, path):
+
+        self.path = path
+        self.seeds = []
+        self._frames = []  # per trajectory, the offsets of its frame records
+        self._checkpoints = []  # per trajectory, frame index: _State after that frame
+
+        with open(path, "rb") as f:
+            self._data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if self._data[:len(MAGIC)] != MAGIC:
+            raise ValueError("%s is not a Multistrand trajectory file." % path)
+
+        # a record that is not complete yet (the simulation is still running) is left out
+        offset = len(MAGIC)
+        while offset + _record.size <= len(self._data):
+            kind, length = _record.unpack_from(self._data, offset)
+            if offset + _record.size + length > len(self._data):
+                break
+            if kind == b"T":
+                self.seeds.append(_seed.unpack_from(self._data, offset + _record.size)[0])
+                self._frames.append([])
+                self._checkpoints.append(dict())
+            else:
+                self._frames[-1].append(offset + _record.size)
+            offset += _record.size + length
+
+    def __len__(self):
+        """ The number of trajectories in the file. """
+        return len(self.seeds)
+
+    def frameCount(self, trajectory=0):
+        return len(self._frames[trajectory])
+
+    def frames(self, trajectory=0):
+        """ Yields the states of a trajectory in order, one at a time. """
+        state = _State(self.seeds[trajectory])
+        for offset in self._frames[trajectory]:
+            time, arrType = self._apply(state, offset)
+            yield Frame(time, arrType, state.output())
+
+    def frame(self, index, trajectory=0):
+        """ The state after the frame at index, decoded from the closest earlier checkpoint. """
+        offsets = self._frames[trajectory]
+        if index < 0:
+            index += len(offsets)
+        if not 0 <= index < len(offsets):
+            raise IndexError("frame index out of range")
+
+        checkpoints = self._checkpoints[trajectory]
+        start = index - index % CHECKPOINT_INTERVAL
+        while start > 0 and start - 1 not in checkpoints:
+            start -= CHECKPOINT_INTERVAL
+        state = checkpoints[start - 1].copy() if start > 0 else _State(self.seeds[trajectory])
+
+        for k in range(start, index + 1):
+            time, arrType = self._apply(state, offsets[k])
+            if k % CHECKPOINT_INTERVAL == CHECKPOINT_INTERVAL - 1 and k not in checkpoints:
+                checkpoints[k] = state.copy()
+
+        return Frame(time, arrType, state.output())
+
+    def _apply(self, state, offset):
+        """ Updates the state with the frame record at offset. """
+        data = self._data
+        time, arrType = _frame.unpack_from(data, offset)
+        offset += _frame.size
+
+        count, = _count.unpack_from(data, offset)
+        offset += _count.size
+        for _ in range(count):
+            del state.complexes[_id.unpack_from(data, offset)[0]]
+            offset += _id.size
+
+        count, = _count.unpack_from(data, offset)
+        offset += _count.size
+        for _ in range(count):
+            cid, energy, enthalpy = _complex.unpack_from(data, offset)
+            offset += _complex.size
+            text = []
+            for _ in range(3):
+                length, = _count.unpack_from(data, offset)
+                offset += _count.size
+                text.append(data[offset:offset + length])
+                offset += length
+            state.complexes[cid] = [text[0].decode(), text[1].decode(), bytearray(text[2]), energy, enthalpy]
+            state.order.append(cid)
+
+        count, = _count.unpack_from(data, offset)
+        offset += _count.size
+        if count > 0:
+            state.order = list(struct.unpack_from("=%di" % count, data, offset))
+            offset += count * _id.size
+
+        count, = _count.unpack_from(data, offset)
+        offset += _count.size
+        for _ in range(count):
+            cid, energy, enthalpy = _complex.unpack_from(data, offset)
+            offset += _complex.size
+            entry = state.complexes[cid]
+            entry[3], entry[4] = energy, enthalpy
+            structure = entry[2]
+            for symbols in (b"..", b"()"):
+                pairs, = _count.unpack_from(data, offset)
+                offset += _count.size
+                for _ in range(pairs):
+                    i, j = _pair.unpack_from(data, offset)
+                    offset += _pair.size
+                    structure[i], structure[j] = symbols[0], symbols[1]
+
+        return time, arrType
@@ -150,7 +150,7 @@ def pairType(ids, structs):
     
     offsets = [0, ] * N  # the new offsets under the old ordering
     
-    for i in xrange(N):
+    for i in range(N):
         
         newPosition = ordering[i]
         
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include "loop.h"
 #include <typeinfo>
+#include <algorithm>
 
 #include "utility.h"
 #include "moveutil.h"
@@ -19,7 +20,7 @@
 
 using std::string;
 
-EnergyModel* Loop::energyModel = NULL;
+thread_local EnergyModel* Loop::energyModel = NULL;
 
 struct RateArr;
 
@@ -182,7 +183,7 @@ Loop::~Loop(void) {
 				adjacentLoops[counter] = NULL; // Hah, take that!
 			}
 		}
-		delete[] adjacentLoops;
+		poolFree(adjacentLoops);
 		adjacentLoops = NULL;
 	}
 	if (moves != NULL) {
@@ -227,6 +228,83 @@ EnergyModel *Loop::GetEnergyModel(void) {
 	return energyModel;
 }
 
+void *Loop::operator new(size_t size) {
+	return LoopPool::allocate(size);
+}
+
+void Loop::operator delete(void *block) {
+	LoopPool::release(block);
+}
+
+// Loops regenerate their moves after every neighbouring change, so the container and its storage are kept.
+void Loop::resetMoves(int initial_size) {
+	if (moves == NULL)
+		moves = newMoveContainer(initial_size);
+	else
+		moves->clear();
+}
+
+MoveContainer *Loop::newMoveContainer(int initial_size) {
+	if (energyModel->simOptions->moveContainer == MOVECONTAINER_INDEXED)
+		return new IndexedMoveList(initial_size);
+
+	return new MoveList(initial_size);
+}
+
+Loop *Loop::copyState(Loop *original) {
+	energy = original->energy;
+	enthalpy = original->enthalpy;
+	energyComputed = original->energyComputed;
+	enthalpyComputed = original->enthalpyComputed;
+	totalRate = original->totalRate;
+	add_index = original->add_index;
+	frozen = original->frozen;
+	return this;
+}
+
+// Called once every loop of the complex has its copy, so the links can be mapped.
+void Loop::linkCopy(LoopCopier& copier) {
+	Loop *copy = copier.loop(this);
+
+	assert(curAdjacent == numAdjacent); // only complexes with all their loops are copied
+
+	for (int loop = 0; loop < curAdjacent; loop++)
+		copy->adjacentLoops[loop] = copier.loop(adjacentLoops[loop]);
+	copy->curAdjacent = curAdjacent;
+
+	if (moves != NULL)
+		copy->moves = moves->copy(copier);
+}
+
+/* LoopCopier */
+
+void LoopCopier::addStrand(char *original, char *copy, int size) {
+	strands.push_back(Strand { original, copy, size });
+}
+
+// The initial open loop starts one before the first base, so that pointer belongs to the strand
+// as well. It can not be the last base of another strand, there is a terminator in between.
+char *LoopCopier::base(char *original) {
+	for (Strand& strand : strands)
+		if (original >= strand.original - 1 && original < strand.original + strand.size)
+			return strand.copy + (original - strand.original);
+
+	assert(0);
+	return NULL;
+}
+
+void LoopCopier::addLoop(Loop *original, Loop *copy) {
+	loops[original] = copy;
+}
+
+Loop *LoopCopier::loop(Loop *original) {
+	if (original == NULL)
+		return NULL;
+
+	assert(loops.count(original) > 0);
+	return loops[original];
+}
+
 void Loop::performComplexSplit(Move *move, Loop **firstOpen, Loop **secondOpen) {
 	//  return;
 
@@ -254,8 +332,8 @@ void Loop::performComplexSplit(Move *move, Loop **firstOpen, Loop **secondOpen)
 
 	for (flipflop = 0; flipflop < 2; flipflop++) {
 
-		sidelen = new int[sizes[flipflop] + 1];
-		seqs = new char *[sizes[flipflop] + 1];
+		sidelen = poolArray<int>(sizes[flipflop] + 1);
+		seqs = poolArray<char*>(sizes[flipflop] + 1);
 
 		for (loop = 0; loop < sizes[flipflop] + 1; loop++) {
 			if (loop < index[flipflop]) {
@@ -373,6 +451,16 @@ void Loop::printAllMoves(Loop* from) {
 
 }
 
+void Loop::listAllMoves(Loop* from, std::vector<Move*>& output) {
+
+	moves->listAllMoves(output);
+
+	for (int i = 0; i < numAdjacent; i++)
+		if (adjacentLoops[i] != from)
+			adjacentLoops[i]->listAllMoves(this, output);
+
+}
+
 void Loop::generateAndSaveDeleteMove(Loop* input, int position) {
 
 	RateArr tempRate = Loop::generateDeleteMoveRate(this, input);
@@ -386,7 +474,7 @@ void Loop::generateAndSaveDeleteMove(Loop* input, int position) {
 
 		RateEnv rateEnv = RateEnv(tempRate.rate, energyModel, tempRate.left, tempRate.right);
 
-		moves->addMove(new Move(MOVE_DELETE | MOVE_1, rateEnv, this, input, position));
+		moves->addMove(Move(MOVE_DELETE | MOVE_1, rateEnv, this, input, position));
 
 	}
 
@@ -528,8 +616,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		// FD: e_index is the index of the attached loop for multiloop end_
 		// FD: s_index is the index of the attached loop for stackloop start_
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -553,8 +641,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = stackMove;
 		right = energyModel->getPrefactorsMulti(e_index, end_->numAdjacent, end_->sidelen);
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 	}
@@ -578,8 +666,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -610,8 +698,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = energyModel->prefactorOpen(e_index, (end_->numAdjacent + 1), end_->sidelen);
 		right = stackMove;
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -710,8 +798,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -736,8 +824,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = energyModel->getPrefactorsMulti(e_index, end_->numAdjacent, end_->sidelen);
 		right = loopMove;
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -761,8 +849,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -790,8 +878,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 	}
@@ -863,8 +951,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -892,8 +980,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 		return RateArr(tempRate / 2.0, left, right);
 
 	}
@@ -916,8 +1004,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -944,8 +1032,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -1029,8 +1117,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		else if (end_->numAdjacent > 3)  // multiloop case
 				{
-			int *sidelens = new int[end_->numAdjacent - 1];
-			char **seqs = new char *[end_->numAdjacent - 1];
+			int *sidelens = poolArray<int>(end_->numAdjacent - 1);
+			char **seqs = poolArray<char*>(end_->numAdjacent - 1);
 
 			for (int loop = 0; loop < end_->numAdjacent; loop++) {
 				if (loop != e_index) {
@@ -1065,8 +1153,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 			}
 
-			delete[] sidelens;
-			delete[] seqs;
+			poolFree(sidelens);
+			poolFree(seqs);
 
 			return RateArr(tempRate / 2.0, left, right);
 
@@ -1087,8 +1175,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop < e_index) {
@@ -1117,8 +1205,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 		return RateArr(tempRate / 2.0, left, right);
 
 	}
@@ -1148,8 +1236,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 2];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 2];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 2);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 2);
 
 		index = 0;
 		for (int loop = 0; loop < start_->numAdjacent; loop++) {
@@ -1188,8 +1276,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -1215,8 +1303,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 1];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 1);
 
 		index = 0;
 		for (int loop = 0; loop <= start_->numAdjacent; loop++) {
@@ -1264,8 +1352,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		poolFree(sidelens);
+		poolFree(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -1303,8 +1391,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		for (flipflop = 0; flipflop < 2; flipflop++) {
 
-			sidelen = new int[sizes[flipflop] + 1];
-			seqs = new char *[sizes[flipflop] + 1];
+			sidelen = poolArray<int>(sizes[flipflop] + 1);
+			seqs = poolArray<char*>(sizes[flipflop] + 1);
 
 			for (loop = 0; loop < sizes[flipflop] + 1; loop++) {
 				if (loop < index[flipflop]) {
@@ -1325,8 +1413,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 			//initialize the new openloops, and connect them correctly, then initialize their moves, etc.
 			new_energies[flipflop] = energyModel->OpenloopEnergy(sizes[flipflop], sidelen, seqs);
 
-			delete[] sidelen;
-			delete[] seqs;
+			poolFree(sidelen);
+			poolFree(seqs);
 		}
 
 		old_energy = start->getEnergy() + end->getEnergy();
@@ -1588,8 +1676,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -1664,8 +1752,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		cout << "End is " << endl;
 //		cout << end_->typeInternalsToString() << endl;
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -1680,7 +1768,7 @@ Loop *Loop::performDeleteMove(Move *move) {
 			}
 		}
 
-//		cout << "new Pairtype is CUSTOM: " << pairtypes[0] << endl;
+//		cout << "new Pairtype is CUSTOM: " << pairtypes_mfold[0] << endl;
 
 		// resulting will be an open loop, same# of adjacent helices, two sides longer by one base, and one pairtype possibly changed.
 		newLoop = new OpenLoop(end_->numAdjacent, sidelens, seqs);
@@ -1865,8 +1953,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -1931,8 +2019,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -2083,8 +2171,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -2148,8 +2236,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -2294,8 +2382,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		else if (end_->numAdjacent > 3)              // multiloop case
 				{
-			int* sidelens = new int[end_->numAdjacent - 1];
-			char** seqs = new char*[end_->numAdjacent - 1];
+			int* sidelens = poolArray<int>(end_->numAdjacent - 1);
+			char** seqs = poolArray<char*>(end_->numAdjacent - 1);
 
 			if (utility::debugTraces) {
 
@@ -2364,8 +2452,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop < e_index) {
@@ -2428,8 +2516,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 2];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 2];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 2);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 2);
 
 		index = 0;
 		for (int loop = 0; loop < start_->numAdjacent; loop++) {
@@ -2505,8 +2593,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 1];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 1);
 
 		index = 0;
 		for (int loop = 0; loop <= start_->numAdjacent; loop++) {
@@ -2606,9 +2694,7 @@ void StackLoop::generateMoves(void) {
 
 void StackLoop::generateDeleteMoves(void) {
 	double temprate;
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(0); // always have 2 delete moves, no shift moves and no creation moves.
+	resetMoves(0); // always have 2 delete moves, no shift moves and no creation moves.
 
 	generateAndSaveDeleteMove(adjacentLoops[0], 0);
 	generateAndSaveDeleteMove(adjacentLoops[1], 1);
@@ -2659,6 +2745,10 @@ double StackLoop::doChoice(Move *move, Loop **returnLoop) {
 // currently no moves in stackloop, in the future will include deletion moves
 }
 
+char *StackLoop::getLastBase(void) {
+	return std::max(seqs[0] + 1, seqs[1] + 1);
+}
+
 char *StackLoop::getLocation(Move *move, int index) {
 	if (move->getType() & MOVE_CREATE) // then something's wrong!
 		assert(0);
@@ -2695,9 +2785,13 @@ char *StackLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 	return NULL;
 }
 
+Loop *StackLoop::copy(LoopCopier& copier) {
+	return (new StackLoop(copier.base(seqs[0]), copier.base(seqs[1])))->copyState(this);
+}
+
 StackLoop::StackLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	identity = 'S';
 }
 
@@ -2705,7 +2799,7 @@ StackLoop::StackLoop(char *seq1, char *seq2, Loop *left, Loop *right) // left an
 		{
 
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
 	curAdjacent = (left == NULL ? 0 : 1) + (right == NULL ? 0 : 1);
@@ -2737,7 +2831,7 @@ string StackLoop::typeInternalsToString(void) {
 
 HairpinLoop::HairpinLoop(void) {
 	numAdjacent = 1;
-	adjacentLoops = new Loop *[1];
+	adjacentLoops = poolArray<Loop*>(1);
 
 	hairpinsize = 0;
 	hairpin_seq = NULL;
@@ -2746,7 +2840,7 @@ HairpinLoop::HairpinLoop(void) {
 
 HairpinLoop::HairpinLoop(int size, char *hairpin_sequence, Loop *previous) {
 	numAdjacent = 1;
-	adjacentLoops = new Loop *[1];
+	adjacentLoops = poolArray<Loop*>(1);
 	adjacentLoops[0] = previous;
 	if (previous != NULL)
 		curAdjacent = 1;
@@ -2801,7 +2895,7 @@ double HairpinLoop::doChoice(Move *move, Loop **returnLoop) {
 	if (move->type & MOVE_CREATE) {
 		loop = move->index[0];
 		loop2 = move->index[1];
-		pt = pairtypes[hairpin_seq[loop]][hairpin_seq[loop2]];
+		pt = pairtypes_mfold[hairpin_seq[loop]][hairpin_seq[loop2]];
 		if (move->type & MOVE_1) // stack and hairpin
 				{
 			newLoop[0] = new StackLoop(hairpin_seq, &hairpin_seq[loop2]);
@@ -2858,29 +2952,23 @@ void HairpinLoop::generateMoves(void) {
 	double energies[2];
 	int pt = 0;
 	int loop, loop2;
-	double tempRate = 0;
-	RateEnv rateEnv;
+	MoveBatch& batch = MoveBatch::local();
 
 // Creation moves
 	if (hairpinsize <= 4) {
 		// We cannot form any creation moves in the hairpin unless it has at least 5 bases.
-		if (moves != NULL)
-			delete moves;
-
-		moves = new MoveList(0);
+		resetMoves(0);
 		totalRate = 0.0;
 		generateDeleteMoves();
 		return;
 	} else {
-		if (moves != NULL)
-			delete moves;
-		moves = new MoveList(1);
+		resetMoves(1);
 
 		// Indice 0 is the starting hairpin base. hairpinsize+1 is the ending hairpin base. Thus we want to start at hairpin indice 1, and go to hairpinsize - 3. (which could pair to indice hairpinsize)
 		for (loop = 1; loop <= hairpinsize - 4; loop++)
 			for (loop2 = loop + 4; loop2 <= hairpinsize; loop2++) {
 
-				pt = pairtypes[hairpin_seq[loop]][hairpin_seq[loop2]];
+				pt = pairtypes_mfold[hairpin_seq[loop]][hairpin_seq[loop2]];
 
 				if (pt != 0) { // the two could pair. Work out energies of the resulting pair of loops.
 
@@ -2894,11 +2982,9 @@ void HairpinLoop::generateMoves(void) {
 
 						energies[0] = energyModel->StackEnergy(hairpin_seq[0], hairpin_seq[hairpinsize + 1], hairpin_seq[loop], hairpin_seq[loop2]);
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[1], hairpinsize - 2);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 						// stack and hairpin, so this is loop and stack
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, stackMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2));
+						batch.add(Move(MOVE_CREATE | MOVE_1, RateEnv(), this, loop, loop2), energies[0] + energies[1], loopMove, stackMove);
 
 					}
 					// bulge + hairpin
@@ -2911,12 +2997,9 @@ void HairpinLoop::generateMoves(void) {
 
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[loop], loop2 - loop - 1);
 
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 						// new bulgeloop + hairpin: this is openMove and stackLoopMove
 
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, stackLoopMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2));
+						batch.add(Move(MOVE_CREATE | MOVE_2, RateEnv(), this, loop, loop2), energies[0] + energies[1], loopMove, stackLoopMove);
 
 					} else // interior loop + hairpin case.
 					{
@@ -2925,16 +3008,14 @@ void HairpinLoop::generateMoves(void) {
 
 						// loop2 - loop - 1 is the new hairpin size.
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[loop], loop2 - loop - 1);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 						// interiorLoop + hairpin, so this is open + open
 
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, loopMove);
-
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loop, loop2));
+						batch.add(Move(MOVE_CREATE | MOVE_3, RateEnv(), this, loop, loop2), energies[0] + energies[1], loopMove, loopMove);
 					}
 				}
 			}
+		batch.flush(energyModel, getEnergy(), moves);
 		totalRate = moves->getRate();
 	}
 
@@ -2965,6 +3046,10 @@ void HairpinLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
 	}
 }
 
+char *HairpinLoop::getLastBase(void) {
+	return hairpin_seq + hairpinsize + 1;
+}
+
 char *HairpinLoop::getLocation(Move *move, int index) {
 	if (move->getType() & MOVE_CREATE) {
 		if (index == 0)
@@ -2991,13 +3076,17 @@ char *HairpinLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 	return NULL;
 }
 
+Loop *HairpinLoop::copy(LoopCopier& copier) {
+	return (new HairpinLoop(hairpinsize, copier.base(hairpin_seq)))->copyState(this);
+}
+
 /*
  BulgeLoop Functions
  */
 
 BulgeLoop::BulgeLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	bulgesize[0] = 0;
 	bulgesize[1] = 0;
@@ -3009,7 +3098,7 @@ BulgeLoop::BulgeLoop(void) {
 BulgeLoop::BulgeLoop(int size1, int size2, char *bulge_sequence1, char *bulge_sequence2, Loop *left, Loop *right) {
 	numAdjacent = 2;
 	curAdjacent = 0;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
 	if (left != NULL)
@@ -3075,15 +3164,15 @@ double BulgeLoop::doChoice(Move *move, Loop **returnLoop) {
 	Loop *newLoop[2];
 	int pt, loop, loop2;
 
-	int *sidelen = new int[3];
-	char **seqs = new char *[3];
+	int *sidelen = poolArray<int>(3);
+	char **seqs = poolArray<char*>(3);
 	int bsize = bulgesize[0] + bulgesize[1];
 	int bside = (bulgesize[0] == 0) ? 1 : 0;
 
 	if (move->type & MOVE_CREATE) {
 		loop = move->index[0];
 		loop2 = move->index[1];
-		pt = pairtypes[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
+		pt = pairtypes_mfold[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
 		if (bside == 1) {
 			sidelen[0] = 0;
 			sidelen[1] = loop - 1;
@@ -3126,30 +3215,24 @@ double BulgeLoop::doChoice(Move *move, Loop **returnLoop) {
 void BulgeLoop::generateMoves(void) {
 	double energies[2];
 	int loop, loop2, pt;
-	double tempRate;
-	RateEnv rateEnv;
+	MoveBatch& batch = MoveBatch::local();
 	int bsize = bulgesize[0] + bulgesize[1];
 	int bside = (bulgesize[0] == 0) ? 1 : 0;
 
 // Creation moves
 	if (bsize <= 3) {
-		if (moves != NULL)
-			delete moves;
-
-		moves = new MoveList(0);
+		resetMoves(0);
 		totalRate = 0.0;
 		generateDeleteMoves();
 		return;
 	} else {
-		if (moves != NULL)
-			delete moves;
-		moves = new MoveList(bsize); // what's the optimal #?
+		resetMoves(bsize); // what's the optimal #?
 
 		// Indice 0 is the starting bulge base. bulgesize+1 is the ending hairpin base. Thus we want to start at hairpin indice 1, and go to hairpinsize - 4. (which could pair to indice hairpinsize)
 		for (loop = 1; loop <= bsize - 4; loop++)
 			for (loop2 = loop + 4; loop2 <= bsize; loop2++) {
 
-				pt = pairtypes[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
+				pt = pairtypes_mfold[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
 
 				if (pt != 0) { // the two could pair. Work out energies of the resulting pair of loops.
 
@@ -3186,8 +3269,6 @@ void BulgeLoop::generateMoves(void) {
 					// loop2 - loop + 1 is the new hairpin size.
 					energies[1] = energyModel->HairpinEnergy(&bulge_seq[bside][loop], loop2 - loop - 1);
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 					// hairpin and multiloop, so this is loopMove and something
 
 					MoveType multiMove = stackMove; // default init value;
@@ -3198,12 +3279,11 @@ void BulgeLoop::generateMoves(void) {
 						multiMove = energyModel->prefactorInternal(sidelen[1], sidelen[2]);
 					}
 
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, multiMove);
-
-					moves->addMove(new Move(MOVE_CREATE, rateEnv, this, loop, loop2));
+					batch.add(Move(MOVE_CREATE, RateEnv(), this, loop, loop2), energies[0] + energies[1], loopMove, multiMove);
 				}
 			}
 	}
+	batch.flush(energyModel, getEnergy(), moves);
 	totalRate = moves->getRate();
 
 	generateDeleteMoves();
@@ -3238,6 +3318,10 @@ void BulgeLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
 	}
 }
 
+char *BulgeLoop::getLastBase(void) {
+	return std::max(bulge_seq[0] + bulgesize[0] + 1, bulge_seq[1] + bulgesize[1] + 1);
+}
+
 char *BulgeLoop::getLocation(Move *move, int index) {
 	int bside = (bulgesize[0] == 0) ? 1 : 0;
 	if (move->getType() & MOVE_CREATE) {
@@ -3274,13 +3358,17 @@ char *BulgeLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 	return NULL;
 }
 
+Loop *BulgeLoop::copy(LoopCopier& copier) {
+	return (new BulgeLoop(bulgesize[0], bulgesize[1], copier.base(bulge_seq[0]), copier.base(bulge_seq[1])))->copyState(this);
+}
+
 /*
  InteriorLoop functions
  */
 
 InteriorLoop::InteriorLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	sizes[0] = sizes[1] = 0;
 	int_seq[0] = int_seq[1] = NULL;
@@ -3289,7 +3377,7 @@ InteriorLoop::InteriorLoop(void) {
 
 InteriorLoop::InteriorLoop(int size1, int size2, char *int_seq1, char *int_seq2, Loop *left, Loop *right) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
@@ -3360,8 +3448,8 @@ void InteriorLoop::calculateEnthalpy(void) {
 double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 	Loop *newLoop[2];
 	int loop, loop2;
-	int *sidelen = new int[3];
-	char **seqs = new char *[3];
+	int *sidelen = poolArray<int>(3);
+	char **seqs = poolArray<char*>(3);
 
 	if (move->type & MOVE_CREATE) {
 		if (move->type & MOVE_1) {
@@ -3467,16 +3555,16 @@ double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			*returnLoop = newLoop[0];
 
-			delete[] seqs;
-			delete[] sidelen;
+			poolFree(seqs);
+			poolFree(sidelen);
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		} else {
-			delete[] seqs;
-			delete[] sidelen;
+			poolFree(seqs);
+			poolFree(sidelen);
 		}
 	} else {
-		delete[] seqs;
-		delete[] sidelen;
+		poolFree(seqs);
+		poolFree(sidelen);
 	}
 	return -totalRate;
 }
@@ -3485,8 +3573,7 @@ void InteriorLoop::generateMoves(void) {
 	double energies[2];
 	int pt = 0;
 	int loop, loop2;
-	double tempRate = 0;
-	RateEnv rateEnv;
+	MoveBatch& batch = MoveBatch::local();
 
 	int nummoves = sizes[0] * sizes[1];
 	if (sizes[0] > 4)
@@ -3498,9 +3585,7 @@ void InteriorLoop::generateMoves(void) {
 	nummoves = (int) ((sizes[0] * sizes[1]) / 16 + 1);
 
 // Creation moves
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(nummoves);
+	resetMoves(nummoves);
 
 // three loops here, the first is only side 0's possible creation moves
 //                   the second is only side 1's possible creation moves
@@ -3511,7 +3596,7 @@ void InteriorLoop::generateMoves(void) {
 
 		for (loop2 = loop + 4; loop2 <= sizes[0]; loop2++) { // each possibility will always result in a new hairpin + multiloop.
 
-			pt = pairtypes[int_seq[0][loop]][int_seq[0][loop2]];
+			pt = pairtypes_mfold[int_seq[0][loop]][int_seq[0][loop2]];
 
 			if (pt != 0) {
 				energies[0] = energyModel->HairpinEnergy(&int_seq[0][loop], loop2 - loop - 1);
@@ -3521,14 +3606,11 @@ void InteriorLoop::generateMoves(void) {
 				char *sequences[3] = { &int_seq[0][0], &int_seq[0][loop2], &int_seq[1][0] };
 
 				energies[1] = energyModel->MultiloopEnergy(3, sidelen, sequences);
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 //				// hairpin and multiloop, so this is loopMove and something
 
 				MoveType multiMove = energyModel->prefactorInternal(sidelen[0], sidelen[1]);
-				rateEnv = RateEnv(tempRate, energyModel, multiMove, loopMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2));
+				batch.add(Move(MOVE_CREATE | MOVE_1, RateEnv(), this, loop, loop2), energies[0] + energies[1], multiMove, loopMove);
 			}
 		}
 	}
@@ -3536,7 +3618,7 @@ void InteriorLoop::generateMoves(void) {
 // Loop #2: Side 1 only Creation Moves
 	for (loop = 1; loop <= sizes[1] - 4; loop++)
 		for (loop2 = loop + 4; loop2 <= sizes[1]; loop2++) { // each possibility will always result in a new hairpin + multiloop.
-			pt = pairtypes[int_seq[1][loop]][int_seq[1][loop2]];
+			pt = pairtypes_mfold[int_seq[1][loop]][int_seq[1][loop2]];
 			if (pt != 0) {
 				energies[0] = energyModel->HairpinEnergy(&int_seq[1][loop], loop2 - loop - 1);
 
@@ -3545,14 +3627,11 @@ void InteriorLoop::generateMoves(void) {
 				char *sequences[3] = { &int_seq[0][0], &int_seq[1][0], &int_seq[1][loop2] };
 
 				energies[1] = energyModel->MultiloopEnergy(3, sidelen, sequences);
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 				// hairpin and multiloop, so this is loopMove and something
 
 				MoveType multiMove = energyModel->prefactorInternal(sidelen[1], sidelen[2]);
-				rateEnv = RateEnv(tempRate, energyModel, loopMove, multiMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2));
+				batch.add(Move(MOVE_CREATE | MOVE_2, RateEnv(), this, loop, loop2), energies[0] + energies[1], loopMove, multiMove);
 			}
 		}
 
@@ -3561,7 +3640,7 @@ void InteriorLoop::generateMoves(void) {
 	for (loop = 1; loop <= sizes[0]; loop++)
 		for (loop2 = 1; loop2 <= sizes[1]; loop2++) {
 
-			pt = pairtypes[int_seq[0][loop]][int_seq[1][loop2]];
+			pt = pairtypes_mfold[int_seq[0][loop]][int_seq[1][loop2]];
 			if (pt != 0) {
 				// Need to check conditions for each side in order to determine what the two new loops types would be.
 				// adjacent to first pair side:
@@ -3592,16 +3671,13 @@ void InteriorLoop::generateMoves(void) {
 					rightMove = loopMove;
 				}
 
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 				// interior loop is closing, so this could be anything.
-				rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loop, loop2));
+				batch.add(Move(MOVE_CREATE | MOVE_3, RateEnv(), this, loop, loop2), energies[0] + energies[1], leftMove, rightMove);
 			}
 		}
 
 // totaling the rate
+	batch.flush(energyModel, getEnergy(), moves);
 	totalRate = moves->getRate();
 
 // Shift moves
@@ -3623,6 +3699,10 @@ void InteriorLoop::generateDeleteMoves(void) {
 
 }
 
+char *InteriorLoop::getLastBase(void) {
+	return std::max(int_seq[0] + sizes[0] + 1, int_seq[1] + sizes[1] + 1);
+}
+
 char *InteriorLoop::getLocation(Move *move, int index) {
 
 	if (move->getType() & MOVE_CREATE) {
@@ -3664,6 +3744,10 @@ char *InteriorLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 	return NULL;
 }
 
+Loop *InteriorLoop::copy(LoopCopier& copier) {
+	return (new InteriorLoop(sizes[0], sizes[1], copier.base(int_seq[0]), copier.base(int_seq[1])))->copyState(this);
+}
+
 void InteriorLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
 	int loop;
 	int item = (int_seq[0] < int_seq[1]);
@@ -3693,7 +3777,7 @@ MultiLoop::MultiLoop(void) {
 
 MultiLoop::MultiLoop(int branches, int *sidelengths, char **sequences) {
 	numAdjacent = branches;
-	adjacentLoops = new Loop *[branches];
+	adjacentLoops = poolArray<Loop*>(branches);
 	for (int loop = 0; loop < branches; loop++) {
 		adjacentLoops[loop] = NULL;
 	}
@@ -3704,8 +3788,8 @@ MultiLoop::MultiLoop(int branches, int *sidelengths, char **sequences) {
 
 MultiLoop::~MultiLoop(void) {
 
-	delete[] sidelen;
-	delete[] seqs;
+	poolFree(sidelen);
+	poolFree(seqs);
 
 }
 
@@ -3773,10 +3857,10 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 
 		if (move->type & MOVE_1) {
 			//single side, hairpin + multi with 1 higher mag.
-			sidelengths = new int[numAdjacent + 1];
-			sequences = new char *[numAdjacent + 1];
+			sidelengths = poolArray<int>(numAdjacent + 1);
+			sequences = poolArray<char*>(numAdjacent + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop3][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < numAdjacent + 1; temploop++, tempindex++) {
 				if (temploop == loop3) {
@@ -3820,11 +3904,11 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 			//adjacent sides, one of: stack    + multi with same mag
 			//                        bulge    + multi with same mag
 			//                        interior + multi with same mag
-			sidelengths = new int[numAdjacent];
-			sequences = new char *[numAdjacent];
+			sidelengths = poolArray<int>(numAdjacent);
+			sequences = poolArray<char*>(numAdjacent);
 
 			loop4 = (loop3 + 1) % numAdjacent;
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 			for (temploop = 0; temploop < numAdjacent; temploop++) {
 				if (temploop == loop3) {
 					sidelengths[temploop] = loop - 1;
@@ -3895,10 +3979,10 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 		if (move->type & MOVE_3) {
 			//non-adjacent sides, multi + open loop
 
-			sidelengths = new int[loop4 - loop3 + 1];
-			sequences = new char *[loop4 - loop3 + 1];
+			sidelengths = poolArray<int>(loop4 - loop3 + 1);
+			sequences = poolArray<char*>(loop4 - loop3 + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
 					{
@@ -3921,8 +4005,8 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0] = new MultiLoop(loop4 - loop3 + 1, sidelengths, sequences);
 
-			sidelengths = new int[numAdjacent - (loop4 - loop3 - 1)];
-			sequences = new char *[numAdjacent - (loop4 - loop3 - 1)];
+			sidelengths = poolArray<int>(numAdjacent - (loop4 - loop3 - 1));
+			sequences = poolArray<char*>(numAdjacent - (loop4 - loop3 - 1));
 
 			for (temploop = 0, tempindex = 0; temploop < numAdjacent - (loop4 - loop3 - 1); tempindex++) {
 				if (tempindex == loop3) {
@@ -3984,13 +4068,10 @@ void MultiLoop::generateMoves(void) {
 
 	int loop, loop2, loop3, loop4, temploop, tempindex, loops[4];
 	int pt;
-	double tempRate;
-	RateEnv rateEnv;
+	MoveBatch& batch = MoveBatch::local();
 	double energies[2];
 
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(sidelen[0] + 1);
+	resetMoves(sidelen[0] + 1);
 // This is almost identical to OpenLoop::generateMoves, which was written first.
 //  Several options here:
 //     #1: creation move within a side this results in a hairpin and a multi loop with 1 greater magnitude.
@@ -4005,8 +4086,8 @@ void MultiLoop::generateMoves(void) {
 	char **sequences = NULL;
 
 // the most storage we'll need is for case #1, which will have a multiloop of 1 greater magnitude.
-	sideLengths = new int[numAdjacent + 1];
-	sequences = new char *[numAdjacent + 1];
+	sideLengths = poolArray<int>(numAdjacent + 1);
+	sequences = poolArray<char*>(numAdjacent + 1);
 
 // Case #1: Single Side only Creation Moves
 	for (loop3 = 0; loop3 < numAdjacent; loop3++) {
@@ -4018,7 +4099,7 @@ void MultiLoop::generateMoves(void) {
 				//FD: Loop2 - loop is at least 4, e.g. this is the hairpin length.
 				//FD: the length of the right-side remaining loop is sidelen[loop3]-loop2;
 
-				pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+				pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop3][loop2]];
 
 				if (pt != 0) {
 
@@ -4046,14 +4127,10 @@ void MultiLoop::generateMoves(void) {
 					}
 					energies[1] = energyModel->MultiloopEnergy(numAdjacent + 1, sideLengths, sequences);
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 					// multiLoop is closing, so this an loopMove and something else
 					MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop3]);
 
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, rightMove);
-
-					moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2, loop3));
+					batch.add(Move(MOVE_CREATE | MOVE_1, RateEnv(), this, loop, loop2, loop3), energies[0] + energies[1], loopMove, rightMove);
 				}
 			}
 		}
@@ -4065,7 +4142,7 @@ void MultiLoop::generateMoves(void) {
 			for (loop2 = 1; loop2 <= sidelen[(loop3 + 1) % numAdjacent]; loop2++) { // each possibility is a hairpin and open loop, see above.
 				loop4 = (loop3 + 1) % numAdjacent;
 
-				pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+				pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 
 				if (pt != 0) {
 
@@ -4115,13 +4192,11 @@ void MultiLoop::generateMoves(void) {
 						}
 					}
 					energies[1] = energyModel->MultiloopEnergy(numAdjacent, sideLengths, sequences);
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 					// multiLoop is forming an stack/bulge/interior, which is something and something else
 					MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
 
-					rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-					moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2, loop3));
+					batch.add(Move(MOVE_CREATE | MOVE_2, RateEnv(), this, loop, loop2, loop3), energies[0] + energies[1], leftMove, rightMove);
 				}
 			}
 		}
@@ -4143,7 +4218,7 @@ void MultiLoop::generateMoves(void) {
 
 				for (loop2 = 1; loop2 <= sidelen[loop4]; loop2++) {
 
-					pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+					pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 
 					if (pt != 0) { // result is a multiloop and multi loop.
 								   // Multiloop
@@ -4170,7 +4245,9 @@ void MultiLoop::generateMoves(void) {
 						}
 
 						energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
-						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+						// the new pair closes this multiloop, between its last and its first side
+						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop4 - loop3], sideLengths[0]);
 
 						// Multi loop
 						for (temploop = 0, tempindex = 0; temploop < numAdjacent - (loop4 - loop3 - 1); tempindex++) {
@@ -4190,7 +4267,6 @@ void MultiLoop::generateMoves(void) {
 
 						}
 						energies[1] = energyModel->MultiloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 						loops[0] = loop;
 						loops[1] = loop2;
 						loops[2] = loop3;
@@ -4198,10 +4274,9 @@ void MultiLoop::generateMoves(void) {
 
 						// multiLoop is splitting into two multiLoops. Which is something, and something else
 
-						MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+						MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop3 + 1]);
 
-						rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loops));
+						batch.add(Move(MOVE_CREATE | MOVE_3, RateEnv(), this, loops), energies[0] + energies[1], leftMove, rightMove);
 					}
 
 				}
@@ -4212,11 +4287,12 @@ void MultiLoop::generateMoves(void) {
 
 	}
 
+	batch.flush(energyModel, getEnergy(), moves);
 	totalRate = moves->getRate();
 	if (sideLengths != NULL)
-		delete[] sideLengths;
+		poolFree(sideLengths);
 	if (sequences != NULL)
-		delete[] sequences;
+		poolFree(sequences);
 
 	generateDeleteMoves();
 }
@@ -4252,6 +4328,17 @@ void MultiLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
 	}
 }
 
+char *MultiLoop::getLastBase(void) {
+
+	char *last = seqs[0] + sidelen[0] + 1;
+
+	for (int side = 1; side < numAdjacent; side++)
+		last = std::max(last, seqs[side] + sidelen[side] + 1);
+
+	return last;
+
+}
+
 char *MultiLoop::getLocation(Move *move, int index) {
 
 	if (move->getType() & MOVE_CREATE) {
@@ -4294,6 +4381,18 @@ char *MultiLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 	return seqs[call_adjacent] + sidelen[call_adjacent] + 1;
 }
 
+Loop *MultiLoop::copy(LoopCopier& copier) {
+	int *sidelens = poolArray<int>(numAdjacent);
+	char **sequences = poolArray<char*>(numAdjacent);
+
+	for (int side = 0; side < numAdjacent; side++) {
+		sidelens[side] = sidelen[side];
+		sequences[side] = copier.base(seqs[side]);
+	}
+
+	return (new MultiLoop(numAdjacent, sidelens, sequences))->copyState(this);
+}
+
 /* OpenLoop functions */
 OpenLoop::OpenLoop(void) {
 	numAdjacent = 0;
@@ -4306,8 +4405,8 @@ OpenLoop::OpenLoop(void) {
 }
 
 OpenLoop::~OpenLoop(void) {
-	delete[] sidelen;
-	delete[] seqs;
+	poolFree(sidelen);
+	poolFree(seqs);
 }
 
 OpenLoop::OpenLoop(int branches, int *sidelengths, char **sequences) {
@@ -4316,7 +4415,7 @@ OpenLoop::OpenLoop(int branches, int *sidelengths, char **sequences) {
 
 	if (branches > 0) {
 
-		adjacentLoops = new Loop *[branches];
+		adjacentLoops = poolArray<Loop*>(branches);
 		for (int loop = 0; loop < branches; loop++) {
 			adjacentLoops[loop] = NULL;
 		}
@@ -4395,10 +4494,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 
 		if (move->type & MOVE_1) {
 			//single side, hairpin + open with 1 higher mag.
-			sidelengths = new int[numAdjacent + 2];
-			sequences = new char *[numAdjacent + 2];
+			sidelengths = poolArray<int>(numAdjacent + 2);
+			sequences = poolArray<char*>(numAdjacent + 2);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop3][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop <= numAdjacent + 1; temploop++, tempindex++) {
 				if (temploop == loop3) {
@@ -4444,10 +4543,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 			//adjacent sides, one of: stack    + open with same mag
 			//                        bulge    + open with same mag
 			//                        interior + open with same mag
-			sidelengths = new int[numAdjacent + 1];
-			sequences = new char *[numAdjacent + 1];
+			sidelengths = poolArray<int>(numAdjacent + 1);
+			sequences = poolArray<char*>(numAdjacent + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
 
 			for (temploop = 0; temploop <= numAdjacent; temploop++) {
 				if (temploop == loop3) {
@@ -4508,10 +4607,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 		if (move->type & MOVE_3) {
 			//non-adjacent sides, multi + open loop
 
-			sidelengths = new int[loop4 - loop3 + 1];
-			sequences = new char *[loop4 - loop3 + 1];
+			sidelengths = poolArray<int>(loop4 - loop3 + 1);
+			sequences = poolArray<char*>(loop4 - loop3 + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
 					{
@@ -4534,8 +4633,8 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0] = new MultiLoop(loop4 - loop3 + 1, sidelengths, sequences);
 
-			sidelengths = new int[numAdjacent - (loop4 - loop3 - 1) + 1];
-			sequences = new char *[numAdjacent - (loop4 - loop3 - 1) + 1];
+			sidelengths = poolArray<int>(numAdjacent - (loop4 - loop3 - 1) + 1);
+			sequences = poolArray<char*>(numAdjacent - (loop4 - loop3 - 1) + 1);
 
 			for (temploop = 0, tempindex = 0; temploop <= numAdjacent - (loop4 - loop3 - 1); tempindex++) {
 				if (tempindex == loop3) {
@@ -4597,13 +4696,10 @@ void OpenLoop::generateMoves(void) {
 
 	int loop, loop2, loop3, loop4, temploop, tempindex, loops[4];
 	int pairType;
-	double tempRate;
-	RateEnv rateEnv;
+	MoveBatch& batch = MoveBatch::local();
 	double energies[2];
 
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(1);
+	resetMoves(1);
 
 //  Several options here:
 //     #1: creation move within a side this results in a hairpin and a open loop with 1 greater magnitude.
@@ -4630,8 +4726,8 @@ void OpenLoop::generateMoves(void) {
 	int *sideLengths = NULL;
 	char **sequences = NULL;
 
-	sideLengths = new int[numAdjacent + 2];
-	sequences = new char *[numAdjacent + 2];
+	sideLengths = poolArray<int>(numAdjacent + 2);
+	sequences = poolArray<char*>(numAdjacent + 2);
 
 // for cotranscriptional mode, assume a single sequence
 	const char* initialPointer = &seqs[0][0];
@@ -4645,7 +4741,7 @@ void OpenLoop::generateMoves(void) {
 
 			for (loop2 = loop + 4; loop2 <= sidelen[loop3]; loop2++) { // each possibility is a hairpin and open loop, see above.
 
-				pairType = pairtypes[mySequence[loop]][mySequence[loop2]];
+				pairType = pairtypes_mfold[mySequence[loop]][mySequence[loop2]];
 
 				// FD: Allowed combinations are non-zero.  G-T stacks are sometimes allowed. Hairpin loops are size 3 or more.
 				if (pairType != 0 && nucleotideIsActive(mySequence, initialPointer, loop, loop2)) {
@@ -4665,7 +4761,6 @@ void OpenLoop::generateMoves(void) {
 						}
 					}
 					energies[1] = energyModel->OpenloopEnergy(numAdjacent + 1, sideLengths, sequences);
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 					// if the new Arrhenius model is used, modify the existing rate based on the local context.
 					// to start, we need to learn what the local context is, AFTER the nucleotide is put in place.
@@ -4673,10 +4768,7 @@ void OpenLoop::generateMoves(void) {
 					// OpenLoop is splitting off an hairpin. Which is loopMove, and something else
 
 					MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 2, sideLengths);
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, rightMove);
-
-					Move *tmove = new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2, loop3);
-					moves->addMove(tmove);
+					batch.add(Move(MOVE_CREATE | MOVE_1, RateEnv(), this, loop, loop2, loop3), energies[0] + energies[1], loopMove, rightMove);
 				}
 			}
 		}
@@ -4687,7 +4779,7 @@ void OpenLoop::generateMoves(void) {
 		for (loop = 1; loop <= sidelen[loop3]; loop++)
 			for (loop2 = 1; loop2 <= sidelen[loop3 + 1]; loop2++) { // each possibility is a hairpin and open loop, see above.
 
-				pairType = pairtypes[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
+				pairType = pairtypes_mfold[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
 
 				if (pairType != 0 && this->nucleotideIsActive(seqs[loop3], initialPointer, loop)
 						&& this->nucleotideIsActive(seqs[loop3 + 1], initialPointer, loop2)) {
@@ -4739,8 +4831,6 @@ void OpenLoop::generateMoves(void) {
 					}
 					energies[1] = energyModel->OpenloopEnergy(numAdjacent, sideLengths, sequences);
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 					// openLoop is splitting off an stack/bulge/interior, and another openloop.
 					// Which is something, and something else
 
@@ -4748,8 +4838,7 @@ void OpenLoop::generateMoves(void) {
 					// the new Openloop:
 					MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 1, sideLengths);
 
-					rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-					moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2, loop3));
+					batch.add(Move(MOVE_CREATE | MOVE_2, RateEnv(), this, loop, loop2, loop3), energies[0] + energies[1], leftMove, rightMove);
 				}
 			}
 
@@ -4764,7 +4853,7 @@ void OpenLoop::generateMoves(void) {
 
 				for (loop2 = 1; loop2 <= sidelen[loop4]; loop2++) {
 
-					pairType = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+					pairType = pairtypes_mfold[seqs[loop3][loop]][seqs[loop4][loop2]];
 
 					if (pairType != 0 && this->nucleotideIsActive(seqs[loop3], initialPointer, loop)
 							&& this->nucleotideIsActive(seqs[loop4], initialPointer, loop2)) { // result is a multiloop and open loop.
@@ -4789,7 +4878,9 @@ void OpenLoop::generateMoves(void) {
 						}
 
 						energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
-						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+						// the new pair closes this multiloop, between its last and its first side
+						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop4 - loop3], sideLengths[0]);
 
 						// Open loop
 						for (temploop = 0, tempindex = 0; temploop <= numAdjacent - (loop4 - loop3 - 1); tempindex++) {
@@ -4808,7 +4899,6 @@ void OpenLoop::generateMoves(void) {
 							}
 						}
 						energies[1] = energyModel->OpenloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 						// openLoop is splitting off . Which is something, and something else
 
@@ -4819,21 +4909,20 @@ void OpenLoop::generateMoves(void) {
 						loops[2] = loop3;
 						loops[3] = loop4;
 
-						rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loops));
+						batch.add(Move(MOVE_CREATE | MOVE_3, RateEnv(), this, loops), energies[0] + energies[1], leftMove, rightMove);
 					}
 
 				}
 			}
 		}
 
+	batch.flush(energyModel, getEnergy(), moves);
 	totalRate = moves->getRate();
 
 	if (sideLengths != NULL)
-		delete[] sideLengths;
+		poolFree(sideLengths);
 	if (sequences != NULL)
-		delete[] sequences;
+		poolFree(sequences);
 
 	generateDeleteMoves();
 }
@@ -4871,6 +4960,18 @@ void OpenLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
 
 }
 
+// The last side ends with the strand, there is no closing base after it.
+char *OpenLoop::getLastBase(void) {
+
+	char *last = seqs[numAdjacent] + sidelen[numAdjacent];
+
+	for (int side = 0; side < numAdjacent; side++)
+		last = std::max(last, seqs[side] + sidelen[side] + 1);
+
+	return last;
+
+}
+
 char *OpenLoop::getLocation(Move *move, int index) {
 
 	if (move->getType() & MOVE_CREATE) {
@@ -5119,8 +5220,8 @@ void OpenLoop::performComplexJoin(OpenLoop **oldLoops, OpenLoop **newLoops, char
 	sizes[1] = seqnum[1] + 1 + (oldLoops[0]->numAdjacent - seqnum[0]);
 
 	for (toggle = 0; toggle <= 1; toggle++) {
-		sidelen = new int[sizes[toggle] + 1];
-		seqs = new char *[sizes[toggle] + 1];
+		sidelen = poolArray<int>(sizes[toggle] + 1);
+		seqs = poolArray<char*>(sizes[toggle] + 1);
 
 		for (loop = 0; loop < sizes[toggle] + 1; loop++) {
 			if (loop < seqnum[toggle]) {
@@ -5205,6 +5306,24 @@ char *OpenLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 		return NULL;
 }
 
+Loop *OpenLoop::copy(LoopCopier& copier) {
+	int *sidelens = poolArray<int>(numAdjacent + 1);
+	char **sequences = poolArray<char*>(numAdjacent + 1);
+
+	for (int side = 0; side < numAdjacent + 1; side++) {
+		sidelens[side] = sidelen[side];
+		sequences[side] = copier.base(seqs[side]);
+	}
+
+	OpenLoop *loop = new OpenLoop(numAdjacent, sidelens, sequences);
+	loop->exposedBases = exposedBases;
+	loop->updatedContext = updatedContext;
+	loop->openInfo = openInfo;
+	loop->initial = initial;
+
+	return loop->copyState(this);
+}
+
 OpenInfo& OpenLoop::getOpenInfo(void) {
 
 // do nothing if not required
@@ -5267,11 +5386,33 @@ bool OpenLoop::nucleotideIsActive(const char* sequence, const char* initial, con
 
 			return false;
 		}
+
+		// the initial pointer is one before the first nucleotide, see StrandComplex::doChoice
+		if (distance - 1 + energyModel->simOptions->frozenNT < energyModel->numActiveNT) {
+
+			return false;
+		}
 	}
 
 	return true;
 }
 
+// True if a side holds the nucleotide that became active last, the sides do not include the closing bases.
+bool OpenLoop::holdsNewestNucleotide(void) {
+
+	const char* initialPointer = &seqs[0][0];
+
+	for (int side = 0; side < numAdjacent + 1; side++) {
+
+		int index = initialPointer + energyModel->numActiveNT - seqs[side];
+
+		if (index >= 1 && index <= sidelen[side])
+			return true;
+	}
+
+	return false;
+}
+
 void OpenLoop::parseLocalContext(int index) {
 
 // FD: redoing this to save more information,
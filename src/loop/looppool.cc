@@ -0,0 +1,124 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the LoopPool found in looppool.h
+#include <stdlib.h>
+#include <stdio.h>
+#include "looppool.h"
+
+// the header is padded to one granule, so blocks keep the alignment of malloc
+static_assert(sizeof(void*) + sizeof(int) <= LOOPPOOL_GRANULE, "pool header does not fit a granule");
+
+thread_local LoopPool *LoopPool::current = NULL;
+
+LoopPool::LoopPool(void) {
+
+	for (int i = 0; i <= LOOPPOOL_CLASSES; i++)
+		freeBlocks[i] = NULL;
+
+	cursor = NULL;
+	chunkEnd = NULL;
+
+}
+
+LoopPool::~LoopPool(void) {
+
+	if (current == this)
+		current = NULL;
+
+	for (char *chunk : chunks)
+		free(chunk);
+
+}
+
+void LoopPool::use(LoopPool *pool) {
+
+	current = pool;
+
+}
+
+void *LoopPool::allocate(size_t size) {
+
+	int sizeClass = (size + LOOPPOOL_GRANULE - 1) / LOOPPOOL_GRANULE;
+
+	if (sizeClass == 0)
+		sizeClass = 1;
+
+	if (current != NULL && sizeClass <= LOOPPOOL_CLASSES)
+		return current->take(sizeClass);
+
+	Header *header = (Header *) malloc(LOOPPOOL_GRANULE + size);
+
+	if (header == NULL) {
+		fprintf(stderr, "LoopPool: out of memory.\n");
+		abort();
+	}
+
+	header->pool = NULL;
+	header->sizeClass = 0;
+
+	return (char *) header + LOOPPOOL_GRANULE;
+
+}
+
+void LoopPool::release(void *block) {
+
+	if (block == NULL)
+		return;
+
+	Header *header = (Header *) ((char *) block - LOOPPOOL_GRANULE);
+
+	if (header->pool == NULL)
+		free(header);
+	else
+		header->pool->give(header);
+
+}
+
+void *LoopPool::take(int sizeClass) {
+
+	Header *header = (Header *) freeBlocks[sizeClass];
+
+	if (header != NULL) {
+
+		freeBlocks[sizeClass] = *(void **) ((char *) header + LOOPPOOL_GRANULE);
+
+	} else {
+
+		int blockSize = (sizeClass + 1) * LOOPPOOL_GRANULE;
+
+		// the tail of the previous chunk is simply left unused
+		if (cursor == NULL || chunkEnd - cursor < blockSize) {
+
+			cursor = (char *) malloc(LOOPPOOL_CHUNK);
+
+			if (cursor == NULL) {
+				fprintf(stderr, "LoopPool: out of memory.\n");
+				abort();
+			}
+
+			chunkEnd = cursor + LOOPPOOL_CHUNK;
+			chunks.push_back(cursor);
+		}
+
+		header = (Header *) cursor;
+		cursor += blockSize;
+
+		header->pool = this;
+		header->sizeClass = sizeClass;
+	}
+
+	return (char *) header + LOOPPOOL_GRANULE;
+
+}
+
+// the free list is threaded through the first word of the block
+void LoopPool::give(Header *header) {
+
+	*(void **) ((char *) header + LOOPPOOL_GRANULE) = freeBlocks[header->sizeClass];
+	freeBlocks[header->sizeClass] = header;
+
+}
@@ -10,6 +10,7 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "move.h"
 #include "loop.h"
 #include "utility.h"
@@ -150,11 +151,11 @@ Move::~Move(void) {
 	affected[0] = affected[1] = NULL;
 }
 
-double Move::getRate(void) {
+double Move::getRate(void) const {
 	return rate.rate;
 }
 
-int Move::getType(void) {
+int Move::getType(void) const {
 	return type;
 }
 
@@ -181,6 +182,11 @@ Loop *Move::doChoice(void) {
 		return NULL;
 }
 
+void Move::relink(LoopCopier& copier) {
+	affected[0] = copier.loop(affected[0]);
+	affected[1] = copier.loop(affected[1]);
+}
+
 string Move::toString(bool useArr) {
 
 	std::stringstream ss;
@@ -222,17 +228,12 @@ string Move::toString(bool useArr) {
 MoveList::MoveList(int initial_size) {
 	totalrate = 0.0;
 	moves_size = initial_size;
+	moves_index = 0;
 	if (moves_size >= 1) {
-		moves = new Move *[moves_size];
-
-		for (moves_index = 0; moves_index < moves_size; moves_index++)
-			moves[moves_index] = NULL;
-
-		moves_index = 0;
+		moves = new Move[moves_size];
 	} else {
 		moves = NULL;
 		moves_size = 0;
-		moves_index = 0;
 	}
 
 	del_moves = NULL;
@@ -242,46 +243,23 @@ MoveList::MoveList(int initial_size) {
 }
 
 MoveList::~MoveList(void) {
-	int iter = 0;
-	// must remove all moves in the movelist.
-	while (iter < moves_index) {
-		if (moves[iter] != NULL) {
-			delete moves[iter];
-			moves[iter] = NULL;
-		}
-		iter++;
-	}
 	if (moves != NULL)
 		delete[] moves;
-
-	iter = 0;
-	while (iter < del_moves_index) {
-		if (del_moves[iter] != NULL) {
-			delete del_moves[iter];
-			del_moves[iter] = NULL;
-		}
-		iter++;
-	}
 	if (del_moves != NULL)
 		delete[] del_moves;
 }
 
+void MoveList::clear(void) {
+	totalrate = 0.0;
+	moves_index = 0;
+	del_moves_index = 0;
+	int_index = 0;
+}
+
 void MoveList::resetDeleteMoves(void) {
-	int iter = 0;
-	while (iter < del_moves_index) {
-		if (del_moves[iter] != NULL) {
-			delete del_moves[iter];
-			del_moves[iter] = NULL;
-		}
-		iter++;
-	}
-	if (del_moves != NULL)
-		delete[] del_moves;
+	for (int iter = 0; iter < del_moves_index; iter++)
+		totalrate -= del_moves[iter].getRate();
 
-	if (del_moves == NULL) {
-		del_moves = new Move *[2];
-		del_moves_size = 2;
-	}
 	del_moves_index = 0;
 }
 
@@ -290,62 +268,61 @@ void MoveList::printAllMoves(bool useArr) {
 	for (int i = 0; i < moves_index; i++) {
 
 		cout << "Move" << i << " ";
-		cout << moves[i]->toString(useArr);
+		cout << moves[i].toString(useArr);
 
 	}
 
 	for (int i = 0; i < del_moves_index; i++) {
 
 		cout << "Move" << i + moves_index << " ";
-		cout << del_moves[i]->toString(useArr);
+		cout << del_moves[i].toString(useArr);
 
 	}
 
 }
 
-void MoveList::addMove(Move *newmove) {
-	int type = newmove->getType();
+void MoveList::listAllMoves(std::vector<Move*>& output) {
+
+	for (int i = 0; i < moves_index; i++)
+		output.push_back(&moves[i]);
+
+	for (int i = 0; i < del_moves_index; i++)
+		output.push_back(&del_moves[i]);
+
+}
+
+// Moves are copied into the arrays, which double when full. The arrays are kept by clear().
+void MoveList::addMove(const Move& newmove) {
+	int type = newmove.getType();
+
+	totalrate += newmove.getRate();
 
 	if (!(type & MOVE_DELETE)) {
 
-		moves[moves_index] = newmove;
-		totalrate += newmove->getRate();
-		moves_index++;
-		// next add would be an overflow.
 		if (moves_index == moves_size) {
-			Move **temp = moves;
-			moves = new Move *[moves_size * 2];
-			for (int loop = 0; loop < moves_size * 2; loop++) {
-				if (loop < moves_size) {
-					moves[loop] = temp[loop];
-					temp[loop] = NULL;
-				} else
-					moves[loop] = NULL;
-			}
-			moves_size = moves_size * 2;
-			delete[] temp;
+			Move *temp = moves;
+			moves_size = (moves_size == 0) ? 2 : moves_size * 2;
+			moves = new Move[moves_size];
+			for (int loop = 0; loop < moves_index; loop++)
+				moves[loop] = temp[loop];
+			if (temp != NULL)
+				delete[] temp;
 		}
+
+		moves[moves_index] = newmove;
+		moves_index++;
+
 	} else // if type is delete move
 	{
-		totalrate += newmove->getRate();
-		if (del_moves == NULL) {
-			del_moves = new Move *[2];
-			del_moves_size = 2;
-			del_moves_index = 0;
-		}
-		// we do the bounds checking in the opposite order as before, as we want the size for deletion moves to default to 2 and not expand except when we are assured we need more, as opposed to creation moves where we pretty much always will need more. Though perhaps I should change it there also so as to remove an extra operation in the end position cases.
+		// the size for deletion moves defaults to 2, and only expands when we are assured we need more.
 		if (del_moves_index == del_moves_size) {
-			Move **temp = del_moves;
-			del_moves = new Move *[del_moves_size * 2];
-			for (int loop = 0; loop < del_moves_size * 2; loop++) {
-				if (loop < del_moves_size) {
-					del_moves[loop] = temp[loop];
-					temp[loop] = NULL;
-				} else
-					del_moves[loop] = NULL;
-			}
-			del_moves_size = del_moves_size * 2;
-			delete[] temp;
+			Move *temp = del_moves;
+			del_moves_size = (del_moves_size == 0) ? 2 : del_moves_size * 2;
+			del_moves = new Move[del_moves_size];
+			for (int loop = 0; loop < del_moves_index; loop++)
+				del_moves[loop] = temp[loop];
+			if (temp != NULL)
+				delete[] temp;
 		}
 
 		del_moves[del_moves_index] = newmove;
@@ -357,10 +334,10 @@ Move *MoveList::getMove(Move *iterator) {
 	if (iterator == NULL)
 		int_index = 0;
 
-	if (int_index == moves_size)
+	if (int_index == moves_index)
 		return NULL;
 
-	return moves[int_index++];
+	return &moves[int_index++];
 }
 
 Move *MoveList::getChoice(SimTimer& timer) {
@@ -371,19 +348,19 @@ Move *MoveList::getChoice(SimTimer& timer) {
 
 		if (index < moves_index) {
 
-			tmp = moves[index]->getRate();
+			tmp = moves[index].getRate();
 
 		} else {
-			tmp = del_moves[index - moves_index]->getRate();
+			tmp = del_moves[index - moves_index].getRate();
 
 		}
 		if (timer.wouldBeHit(tmp) && index < moves_index) {
 
-			return moves[index];
+			return &moves[index];
 
 		} else if (timer.wouldBeHit(tmp)) {
 
-			return del_moves[index - moves_index];
+			return &del_moves[index - moves_index];
 
 		} else {
 			timer.checkHit(tmp);
@@ -417,3 +394,216 @@ uint16_t MoveList::getCount(void) {
 
 }
 
+// The arrays are copied at their used size, they grow again when the copy regenerates.
+MoveContainer *MoveList::copy(LoopCopier& copier) {
+
+	MoveList *result = new MoveList(moves_index);
+
+	for (int i = 0; i < moves_index; i++) {
+		result->moves[i] = moves[i];
+		result->moves[i].relink(copier);
+	}
+
+	if (del_moves_index > 0) {
+		result->del_moves = new Move[del_moves_index];
+		result->del_moves_size = del_moves_index;
+	}
+
+	for (int i = 0; i < del_moves_index; i++) {
+		result->del_moves[i] = del_moves[i];
+		result->del_moves[i].relink(copier);
+	}
+
+	result->moves_index = moves_index;
+	result->del_moves_index = del_moves_index;
+	result->totalrate = totalrate;
+
+	return result;
+
+}
+
+
+/*
+
+ IndexedMoveList
+
+ */
+
+IndexedMoveList::IndexedMoveList(int initial_size) {
+	totalrate = 0.0;
+	int_index = 0;
+
+	if (initial_size > 0) {
+		moves.reserve(initial_size);
+		prefix.reserve(initial_size);
+	}
+}
+
+IndexedMoveList::~IndexedMoveList(void) {
+
+}
+
+void IndexedMoveList::addMove(const Move& newmove) {
+
+	totalrate += newmove.getRate();
+
+	if (newmove.getType() & MOVE_DELETE) {
+		del_moves.push_back(newmove);
+	} else {
+		moves.push_back(newmove);
+		prefix.push_back(newmove.getRate() + (prefix.empty() ? 0.0 : prefix.back()));
+	}
+
+}
+
+void IndexedMoveList::clear(void) {
+
+	totalrate = 0.0;
+	int_index = 0;
+	moves.clear();
+	prefix.clear();
+	del_moves.clear();
+
+}
+
+Move *IndexedMoveList::getChoice(SimTimer& timer) {
+
+	if (moves.size() > 0 && timer.wouldBeHit(prefix.back())) {
+
+		// first move whose running sum exceeds the choice, as a linear scan with wouldBeHit would find.
+		int index = std::upper_bound(prefix.begin(), prefix.end(), timer.rchoice) - prefix.begin();
+
+		if (index > 0)
+			timer.checkHit(prefix[index - 1]);
+
+		return &moves[index];
+	}
+
+	if (moves.size() > 0)
+		timer.checkHit(prefix.back());
+
+	for (unsigned int index = 0; index < del_moves.size(); index++) {
+
+		if (timer.wouldBeHit(del_moves[index].getRate()))
+			return &del_moves[index];
+
+		timer.checkHit(del_moves[index].getRate());
+	}
+
+	assert(0); // should never call for a move from a container unless it will get one.
+	return NULL;
+}
+
+Move *IndexedMoveList::getMove(Move *iterator) {
+	if (iterator == NULL)
+		int_index = 0;
+
+	if (int_index == moves.size())
+		return NULL;
+
+	return &moves[int_index++];
+}
+
+uint16_t IndexedMoveList::getCount(void) {
+
+	return moves.size() + del_moves.size();
+
+}
+
+void IndexedMoveList::resetDeleteMoves(void) {
+
+	del_moves.clear();
+	totalrate = prefix.empty() ? 0.0 : prefix.back();
+}
+
+MoveContainer *IndexedMoveList::copy(LoopCopier& copier) {
+
+	IndexedMoveList *result = new IndexedMoveList(*this);
+	result->int_index = 0;
+
+	for (Move& move : result->moves)
+		move.relink(copier);
+
+	for (Move& move : result->del_moves)
+		move.relink(copier);
+
+	return result;
+
+}
+
+void IndexedMoveList::printAllMoves(bool useArr) {
+
+	for (unsigned int i = 0; i < moves.size(); i++) {
+
+		cout << "Move" << i << " ";
+		cout << moves[i].toString(useArr);
+
+	}
+
+	for (unsigned int i = 0; i < del_moves.size(); i++) {
+
+		cout << "Move" << i + moves.size() << " ";
+		cout << del_moves[i].toString(useArr);
+
+	}
+
+}
+
+void IndexedMoveList::listAllMoves(std::vector<Move*>& output) {
+
+	for (Move& move : moves)
+		output.push_back(&move);
+
+	for (Move& move : del_moves)
+		output.push_back(&move);
+
+}
+
+/*
+
+ MoveBatch
+
+ */
+
+void MoveBatch::clear(void) {
+
+	moves.clear();
+	energies.clear();
+	left.clear();
+	right.clear();
+
+}
+
+void MoveBatch::add(const Move& move, double energy, MoveType leftType, MoveType rightType) {
+
+	moves.push_back(move);
+	energies.push_back(energy);
+	left.push_back(leftType);
+	right.push_back(rightType);
+
+}
+
+void MoveBatch::flush(EnergyModel *model, double startEnergy, MoveContainer *container) {
+
+	rates.resize(moves.size());
+
+	if (!moves.empty())
+		model->returnRates(startEnergy, moves.size(), energies.data(), rates.data());
+
+	for (unsigned int i = 0; i < moves.size(); i++) {
+
+		moves[i].rate = RateEnv(rates[i], model, left[i], right[i]);
+		container->addMove(moves[i]);
+
+	}
+
+	clear();
+
+}
+
+MoveBatch& MoveBatch::local(void) {
+
+	thread_local static MoveBatch batch;
+	return batch;
+
+}
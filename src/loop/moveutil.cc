@@ -78,11 +78,15 @@ string moveutil::primeToDesc(int input) {
 
 std::ostream& operator<<(std::ostream &ss, OpenInfo& m) {
 
-	for (std::pair<HalfContext, BaseCount> value : m.tally) {
+	for (int left = 0; left < HALFCONTEXT_SIZE; left++) {
+		for (int right = 0; right < HALFCONTEXT_SIZE; right++) {
 
-		ss << value.first << " ";
-		ss << value.second << "   --   ";
+			HalfContext con = HalfContext((QuartContext) left, (QuartContext) right);
 
+			ss << con << " ";
+			ss << m.tally[left][right] << "   --   ";
+
+		}
 	}
 
 	ss << "Intern / Total = " << m.numExposedInternal << " / ";
@@ -96,7 +100,12 @@ std::ostream& operator<<(std::ostream &ss, OpenInfo& m) {
 
 void OpenInfo::clear(void) {
 
-	tally.clear();
+	for (array<BaseCount, HALFCONTEXT_SIZE>& row : tally) {
+		for (BaseCount& count : row) {
+			count.clear();
+		}
+	}
+
 	numExposedInternal = 0;
 	numExposed = 0;
 
@@ -105,112 +114,79 @@ void OpenInfo::clear(void) {
 // simply store the vector of halfContext onto the list we already have
 void OpenInfo::increment(QuartContext left, char base, QuartContext right) {
 
-	HalfContext con = HalfContext(left, right);
-
-	if (tally.count(con)) { // if count > 0 then proceed
-
-		tally.find(con)->second.count[base]++;
-
-	} else {
-
-		BaseCount count = BaseCount();
-		count.count[base]++;
-		tally.insert(std::pair<HalfContext, BaseCount>(con, count));
-
-	}
+	tally[left][right].count[base]++;
 
 }
 
 void OpenInfo::increment(HalfContext con, BaseCount& count) {
 
-	if (tally.count(con)) {
-
-		// if found, increment from the reference
-
-		tally.find(con)->second.increment(count);
-
-	} else { // if not found, don't store the reference, make a new object.
-
-		BaseCount countNew = BaseCount();
-		countNew.increment(count);
-
-		tally.insert(std::pair<HalfContext, BaseCount>(con, countNew));
-
-	}
+	get(con).increment(count);
 
 }
 
 void OpenInfo::decrement(HalfContext con, BaseCount& count) {
 
-	assert(tally.count(con));
-
-	tally.find(con)->second.decrement(count);
+	get(con).decrement(count);
 
 }
 
-void OpenInfo::increment(OpenInfo& other) {
-
-	map<HalfContext, BaseCount> tally;
+void OpenInfo::increment(OpenInfo& other, int times) {
 
-	for (std::pair<HalfContext, BaseCount> myPair : other.tally) {
+	for (int left = 0; left < HALFCONTEXT_SIZE; left++) {
+		for (int right = 0; right < HALFCONTEXT_SIZE; right++) {
 
-		increment(myPair.first, myPair.second);
+			tally[left][right].increment(other.tally[left][right], times);
 
+		}
 	}
 
-	numExposedInternal += other.numExposedInternal;
-	numExposed += other.numExposed;
+	numExposedInternal += times * other.numExposedInternal;
+	numExposed += times * other.numExposed;
 
 }
 
-void OpenInfo::decrement(OpenInfo& other) {
-
-	map<HalfContext, BaseCount> tally;
+void OpenInfo::decrement(OpenInfo& other, int times) {
 
-	for (std::pair<HalfContext, BaseCount> myPair : other.tally) {
+	for (int left = 0; left < HALFCONTEXT_SIZE; left++) {
+		for (int right = 0; right < HALFCONTEXT_SIZE; right++) {
 
-		decrement(myPair.first, myPair.second);
+			tally[left][right].decrement(other.tally[left][right], times);
 
+		}
 	}
 
-	numExposedInternal -= other.numExposedInternal;
-	numExposed -= other.numExposed;
+	numExposedInternal -= times * other.numExposedInternal;
+	numExposed -= times * other.numExposed;
 
 }
 
 // simply compute the crossed-rate between these exposed nucleotides.
+// The top (a, b) meets the bottom (c, d) with MoveTypes (a, d) and (b, c).
 
 double OpenInfo::crossRate(OpenInfo& other, EnergyModel& eModel) {
 
 	double output = 0.0;
 
-	for (std::pair<HalfContext, BaseCount> here : tally) {
-
-		HalfContext& top = here.first;
-		BaseCount& countTop = here.second;
+	for (int a = 0; a < HALFCONTEXT_SIZE; a++) {
+		for (int b = 0; b < HALFCONTEXT_SIZE; b++) {
 
-		for (std::pair<HalfContext, BaseCount> there : other.tally) {
+			BaseCount& countTop = tally[a][b];
 
-			HalfContext& bot = there.first;
-			BaseCount& countBot = there.second;
+			for (int c = 0; c < HALFCONTEXT_SIZE; c++) {
+				for (int d = 0; d < HALFCONTEXT_SIZE; d++) {
 
-			int crossings = countTop.multiCount(countBot);
+					int crossings = countTop.multiCount(other.tally[c][d]);
 
-			if (crossings > 0) {
+					if (crossings > 0) {
 
-				MoveType left = moveutil::combineBi(top.left, bot.right);
-				MoveType right = moveutil::combineBi(top.right, bot.left);
+						output += crossings * eModel.joinRateFor((QuartContext) a, (QuartContext) b, (QuartContext) c, (QuartContext) d);
 
-				double joinRate = eModel.applyPrefactors(eModel.getJoinRate(), left, right);
-
-				double rate = crossings * joinRate;
-
-				output += rate;
+					}
 
+				}
 			}
 
 		}
-
 	}
 
 	return output;
@@ -377,15 +353,6 @@ std::ostream& operator<<(std::ostream& str, const ExportFinal& k) {
 
 }
 
-std::ostream& operator<<(std::ostream& str, const ExportTransition& k) {
-
-	str << std::to_string(k.type) << "\n";
-	str << k.state1;
-	str << k.state2 << "\n";
-
-	return str;
-}
-
 HalfContext::HalfContext() {
 
 }
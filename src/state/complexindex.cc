@@ -0,0 +1,362 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the ComplexIndex object found in complexindex.h
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "complexindex.h"
+#include "scomplexlist.h"
+#include "energymodel.h"
+#include "simtimer.h"
+
+const int COMPLEXINDEX_INITIAL_CAPACITY = 16;
+
+ComplexIndex::ComplexIndex(EnergyModel *energyModel) {
+
+	eModel = energyModel;
+	contexts = eModel->useArrhenius() ? HALFCONTEXT_SIZE * HALFCONTEXT_SIZE : 1;
+
+	capacity = COMPLEXINDEX_INITIAL_CAPACITY;
+	used = 0;
+	rates.assign(2 * capacity, 0.0);
+	baseCounts.assign(contexts * 4, vector<long>(2 * capacity, 0));
+	selfPairs.assign(contexts * contexts * 2, vector<long>(2 * capacity, 0));
+	entries.assign(capacity, NULL);
+
+}
+
+// Forgets every indexed entry without touching them.
+void ComplexIndex::clear(void) {
+
+	for (int slot = 0; slot < used; slot++)
+		entries[slot] = NULL;
+
+	rates.assign(2 * capacity, 0.0);
+
+	for (vector<long>& tree : baseCounts)
+		tree.assign(2 * capacity, 0);
+
+	for (vector<long>& tree : selfPairs)
+		tree.assign(2 * capacity, 0);
+
+	freeSlots.clear();
+	used = 0;
+
+}
+
+void ComplexIndex::insert(SComplexListEntry *entry) {
+
+	int slot;
+
+	if (freeSlots.size() > 0) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		if (used == capacity)
+			grow();
+		slot = used++;
+	}
+
+	entries[slot] = entry;
+	entry->slot = slot;
+
+	setRate(slot, entry->rate * entry->copies);
+	updateExposed(entry);
+
+}
+
+void ComplexIndex::remove(SComplexListEntry *entry) {
+
+	int slot = entry->slot;
+
+	assert(slot >= 0 && slot < used && entries[slot] == entry);
+
+	setRate(slot, 0.0);
+
+	for (vector<long>& tree : baseCounts)
+		setCount(tree, slot, 0);
+
+	for (vector<long>& tree : selfPairs)
+		setCount(tree, slot, 0);
+
+	entries[slot] = NULL;
+	entry->slot = -1;
+	freeSlots.push_back(slot);
+
+}
+
+void ComplexIndex::updateRate(SComplexListEntry *entry) {
+
+	assert(entry->slot >= 0 && entries[entry->slot] == entry);
+
+	setRate(entry->slot, entry->rate * entry->copies);
+
+}
+
+// Only the trees whose leaf changed are walked, most updates change a few bases at most.
+void ComplexIndex::updateExposed(SComplexListEntry *entry) {
+
+	int slot = entry->slot;
+
+	assert(slot >= 0 && entries[slot] == entry);
+
+	long copies = entry->copies;
+
+	for (int context = 0; context < contexts; context++)
+		for (int base : { baseA, baseC, baseG, baseT })
+			setCount(baseCounts[baseTree(context, base)], slot, copies * exposed(entry, context, base));
+
+	// a copy does not pair with itself, it does with the other copies
+	for (int top = 0; top < contexts; top++) {
+		for (int bottom = 0; bottom < contexts; bottom++) {
+			for (int base : { baseA, baseG }) {
+
+				long pairs = copies * exposed(entry, top, base) * exposed(entry, bottom, 5 - base);
+				setCount(selfPairs[joinClass(top, bottom, base)], slot, pairs);
+
+			}
+		}
+	}
+
+}
+
+SComplexListEntry *ComplexIndex::getChoice(SimTimer& timer) {
+
+	if (rates[1] <= 0.0)
+		return NULL;
+
+	int node = 1;
+
+	while (node < capacity) {
+
+		double left = rates[2 * node];
+
+		// only descend into subtrees with a positive rate, so we always end on an indexed entry.
+		if ((left > 0.0 && timer.wouldBeHit(left)) || rates[2 * node + 1] <= 0.0) {
+			node = 2 * node;
+		} else {
+			timer.checkHit(left);
+			node = 2 * node + 1;
+		}
+	}
+
+	SComplexListEntry *entry = entries[node - capacity];
+	assert(entry != NULL);
+
+	// the partial sums stored in the tree can differ from the entry's own rate in the last bit.
+	if (!timer.wouldBeHit(entry->rate * entry->copies))
+		timer.rchoice = entry->rate * entry->copies * (1.0 - 1e-12);
+
+	return entry;
+
+}
+
+// The class is found by walking the classes, the pairs within it are counted exactly. Pairs of
+// a class are ordered by top complex, then top nucleotide, then bottom complex and nucleotide.
+JoinCriteria ComplexIndex::getJoinChoice(SimTimer& timer, SComplexListEntry *partners[2]) {
+
+	JoinCriteria crit;
+
+	int picked = -1, top = 0, bottom = 0, base = baseA;
+	long pairs = 0;
+	double rate = 0.0;
+	double rchoice = timer.rchoice;
+
+	for (int joinType = 0; joinType < contexts * contexts * 2; joinType++) {
+
+		int classTop = joinType / (2 * contexts);
+		int classBottom = (joinType / 2) % contexts;
+		int classBase = (joinType % 2) ? baseG : baseA;
+
+		long classPairs = baseCounts[baseTree(classTop, classBase)][1] * baseCounts[baseTree(classBottom, 5 - classBase)][1] - selfPairs[joinType][1];
+
+		if (classPairs <= 0)
+			continue;
+
+		// the last non-empty class takes what remains, if the flux was summed in another order
+		picked = joinType;
+		top = classTop;
+		bottom = classBottom;
+		base = classBase;
+		pairs = classPairs;
+		rate = classRate(classTop, classBottom);
+
+		if (rchoice < rate * classPairs)
+			break;
+
+		rchoice -= rate * classPairs;
+
+	}
+
+	assert(picked >= 0);
+
+	long choice = (long) floor(rchoice / rate);
+	choice = std::max(0L, std::min(choice, pairs - 1));
+
+	// the top complex: its bases in the top context, with the bottom bases of all other complexes
+	vector<long>& tops = baseCounts[baseTree(top, base)];
+	vector<long>& bottoms = baseCounts[baseTree(bottom, 5 - base)];
+	vector<long>& self = selfPairs[picked];
+	long others = bottoms[1];
+
+	int node = 1;
+
+	while (node < capacity) {
+
+		long left = others * tops[2 * node] - self[2 * node];
+
+		if (choice < left) {
+			node = 2 * node;
+		} else {
+			choice -= left;
+			node = 2 * node + 1;
+		}
+	}
+
+	// with copies, the leaves hold the bases of all of them, and the nucleotide is that of a single copy
+	int topSlot = node - capacity;
+	long topCopies = entries[topSlot]->copies;
+	long own = bottoms[node] / topCopies;
+	long rest = others - own;
+
+	crit.index[0] = (int) ((choice / rest) % (tops[node] / topCopies));
+	choice = choice % rest;
+
+	// the bottom complex, skipping the bases of the top copy
+	long before = 0;
+
+	for (node = capacity + topSlot; node > 1; node = node / 2)
+		if (node & 1)
+			before += bottoms[node - 1];
+
+	if (choice >= before)
+		choice += own;
+
+	int bottomSlot = findCount(bottoms, choice);
+
+	partners[0] = entries[topSlot];
+	partners[1] = entries[bottomSlot];
+
+	assert(partners[0] != NULL && partners[1] != NULL && (partners[0] != partners[1] || partners[0]->copies > 1));
+
+	crit.index[1] = (int) (choice % (bottoms[capacity + bottomSlot] / partners[1]->copies));
+
+	crit.complexes[0] = partners[0]->thisComplex;
+	crit.complexes[1] = partners[1]->thisComplex;
+	crit.types[0] = base;
+	crit.types[1] = 5 - base;
+
+	if (contexts > 1) {
+
+		HalfContext topHalf = HalfContext((QuartContext) (top / HALFCONTEXT_SIZE), (QuartContext) (top % HALFCONTEXT_SIZE));
+		HalfContext bottomHalf = HalfContext((QuartContext) (bottom / HALFCONTEXT_SIZE), (QuartContext) (bottom % HALFCONTEXT_SIZE));
+
+		crit.half[0] = topHalf;
+		crit.half[1] = bottomHalf;
+		crit.arrType = moveutil::getPrimeCode(moveutil::combineBi(topHalf.left, bottomHalf.right), moveutil::combineBi(topHalf.right, bottomHalf.left));
+
+	}
+
+	return crit;
+
+}
+
+long ComplexIndex::exposed(SComplexListEntry *entry, int context, int base) {
+
+	if (contexts == 1)
+		return entry->exposedBases.count[base];
+
+	return entry->exposedInfo.tally[context / HALFCONTEXT_SIZE][context % HALFCONTEXT_SIZE].count[base];
+
+}
+
+double ComplexIndex::classRate(int top, int bottom) {
+
+	if (contexts == 1)
+		return eModel->joinRateFor(loopMove, loopMove);
+
+	return eModel->joinRateFor((QuartContext) (top / HALFCONTEXT_SIZE), (QuartContext) (top % HALFCONTEXT_SIZE), (QuartContext) (bottom / HALFCONTEXT_SIZE),
+			(QuartContext) (bottom % HALFCONTEXT_SIZE));
+
+}
+
+void ComplexIndex::grow(void) {
+
+	int oldCapacity = capacity;
+	capacity = 2 * capacity;
+	entries.resize(capacity, NULL);
+
+	std::vector<double> oldRates;
+	oldRates.swap(rates);
+	rates.assign(2 * capacity, 0.0);
+
+	for (int slot = 0; slot < oldCapacity; slot++)
+		rates[capacity + slot] = oldRates[oldCapacity + slot];
+
+	for (int node = capacity - 1; node > 0; node--)
+		rates[node] = rates[2 * node] + rates[2 * node + 1];
+
+	for (vector<vector<long> >* trees : { &baseCounts, &selfPairs }) {
+		for (vector<long>& tree : *trees) {
+
+			vector<long> oldTree;
+			oldTree.swap(tree);
+			tree.assign(2 * capacity, 0);
+
+			for (int slot = 0; slot < oldCapacity; slot++)
+				tree[capacity + slot] = oldTree[oldCapacity + slot];
+
+			for (int node = capacity - 1; node > 0; node--)
+				tree[node] = tree[2 * node] + tree[2 * node + 1];
+
+		}
+	}
+
+}
+
+void ComplexIndex::setRate(int slot, double rate) {
+
+	int node = capacity + slot;
+	rates[node] = rate;
+
+	for (node = node / 2; node > 0; node = node / 2)
+		rates[node] = rates[2 * node] + rates[2 * node + 1];
+
+}
+
+void ComplexIndex::setCount(vector<long>& tree, int slot, long value) {
+
+	int node = capacity + slot;
+
+	if (tree[node] == value)
+		return;
+
+	long change = value - tree[node];
+
+	for (; node > 0; node = node / 2)
+		tree[node] += change;
+
+}
+
+// The slot that holds the choice-th base of the tree, choice becomes the index within the slot.
+int ComplexIndex::findCount(vector<long>& tree, long& choice) {
+
+	int node = 1;
+
+	while (node < capacity) {
+
+		if (choice < tree[2 * node]) {
+			node = 2 * node;
+		} else {
+			choice -= tree[2 * node];
+			node = 2 * node + 1;
+		}
+	}
+
+	return node - capacity;
+
+}
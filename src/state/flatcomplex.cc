@@ -0,0 +1,572 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the FlatComplex object found in flatcomplex.h
+#include <assert.h>
+#include "flatcomplex.h"
+#include "strandordering.h"
+#include "energymodel.h"
+#include "simtimer.h"
+#include "loop.h"
+
+FlatComplex::FlatComplex(StrandOrdering *newOrdering) {
+
+	ordering = newOrdering;
+	energyModel = Loop::GetEnergyModel();
+	assert(ordering->getStrandCount() == 1);
+
+	orderingList *strand = ordering->first;
+	length = strand->size;
+
+	code.assign(length + 2, 0);
+	pairs.assign(length, -1);
+	loopOf.assign(length, length);
+
+	std::vector<int> open;
+
+	for (int k = 0; k < length; k++) {
+
+		code[k + 1] = strand->thisCodeSeq[k];
+
+		if (strand->thisStruct[k] == '(') {
+			open.push_back(k);
+		} else if (strand->thisStruct[k] == ')') {
+			assert(!open.empty());
+			pairs[k] = open.back();
+			pairs[open.back()] = k;
+			open.pop_back();
+		}
+	}
+
+	assert(open.empty());
+
+	energy.assign(length + 1, 0.0);
+	sideLength.resize(length + 1);
+	sideSeq.resize(length + 1);
+	branches.resize(length + 1);
+	creations.resize(length + 1);
+	creationRate.assign(length + 1, 0.0);
+	deletion.assign(length + 1, RateEnv());
+
+	for (capacity = 1; capacity < length + 1; capacity <<= 1)
+		;
+	tree.assign(2 * capacity, 0.0);
+
+	relabel(length, -1, length);
+	refreshLoop(length);
+
+	for (int k = 0; k < length; k++)
+		if (pairs[k] > k) {
+			relabel(k, k, pairs[k]);
+			refreshLoop(k);
+		}
+
+}
+
+// The sides point into our code sequence, so they are moved to that of the copy.
+FlatComplex::FlatComplex(const FlatComplex& original, StrandOrdering *newOrdering) :
+		FlatComplex(original) {
+
+	ordering = newOrdering;
+
+	for (std::vector<char*>& sides : sideSeq)
+		for (char*& side : sides)
+			side = &code[0] + (side - &original.code[0]);
+
+}
+
+// Records the sides of a loop from the pair table, in the layout of the loop graph:
+// a closed loop starts with the side after its closing pair's 5' base, an open loop
+// with the 5' end of the strand. Side i is preceded by pair i, the 5' base of which
+// is branches[loop][i] (-1 for the 5' end).
+void FlatComplex::describe(int loop) {
+
+	int start = isOpen(loop) ? -1 : loop;
+	int end = isOpen(loop) ? length : pairs[loop];
+	int sidelen = 0;
+
+	sideLength[loop].clear();
+	sideSeq[loop].clear();
+	branches[loop].clear();
+
+	branches[loop].push_back(start);
+	sideSeq[loop].push_back(base(start));
+
+	for (int k = start + 1; k < end; k++) {
+
+		if (pairs[k] < 0) {
+			sidelen++;
+			continue;
+		}
+
+		sideLength[loop].push_back(sidelen);
+		sidelen = 0;
+
+		branches[loop].push_back(k);
+		k = pairs[k];
+		sideSeq[loop].push_back(base(k));
+	}
+
+	sideLength[loop].push_back(sidelen);
+
+}
+
+double FlatComplex::loopEnergy(bool open, int count, int *sidelen, char **seqs, bool enthalpy) {
+
+	if (open) {
+
+		if (enthalpy)
+			return energyModel->OpenloopEnthalpy(count - 1, sidelen, seqs);
+		return energyModel->OpenloopEnergy(count - 1, sidelen, seqs);
+
+	}
+
+	if (count == 1) {
+
+		if (enthalpy)
+			return energyModel->HairpinEnthalpy(seqs[0], sidelen[0]);
+		return energyModel->HairpinEnergy(seqs[0], sidelen[0]);
+
+	}
+
+	if (count == 2) {
+
+		if (sidelen[0] == 0 && sidelen[1] == 0) {
+
+			if (enthalpy)
+				return energyModel->StackEnthalpy(seqs[0][0], seqs[1][1], seqs[0][1], seqs[1][0]);
+			return energyModel->StackEnergy(seqs[0][0], seqs[1][1], seqs[0][1], seqs[1][0]);
+
+		}
+
+		if (sidelen[0] == 0 || sidelen[1] == 0) {
+
+			if (enthalpy)
+				return energyModel->BulgeEnthalpy(seqs[0][0], seqs[1][sidelen[1] + 1], seqs[0][sidelen[0] + 1], seqs[1][0], sidelen[0] + sidelen[1]);
+			return energyModel->BulgeEnergy(seqs[0][0], seqs[1][sidelen[1] + 1], seqs[0][sidelen[0] + 1], seqs[1][0], sidelen[0] + sidelen[1]);
+
+		}
+
+		if (enthalpy)
+			return energyModel->InteriorEnthalpy(seqs[0], seqs[1], sidelen[0], sidelen[1]);
+		return energyModel->InteriorEnergy(seqs[0], seqs[1], sidelen[0], sidelen[1]);
+
+	}
+
+	if (enthalpy)
+		return energyModel->MultiloopEnthalpy(count, sidelen, seqs);
+	return energyModel->MultiloopEnergy(count, sidelen, seqs);
+
+}
+
+// The Arrhenius context of pair i of a loop, from the sides on either side of it.
+MoveType FlatComplex::context(bool open, int count, int *sidelen, int pair) {
+
+	if (open)
+		return energyModel->prefactorOpen(pair - 1, count, sidelen);
+
+	if (count == 2 && sidelen[0] == 0 && sidelen[1] == 0)
+		return stackMove;
+
+	int before = (pair == 0) ? count - 1 : pair - 1;
+
+	return energyModel->prefactorInternal(sidelen[before], sidelen[pair]);
+
+}
+
+// Every pair of unpaired bases a < b of the loop that can pair, at least three bases
+// apart if they are on the same side. The new pair closes the inner loop, and is pair
+// s + 1 of the outer loop, between what is left of sides s and t.
+void FlatComplex::generateCreations(int loop) {
+
+	bool open = isOpen(loop);
+	int count = sideLength[loop].size();
+	int *sidelen = sideLength[loop].data();
+	char **seqs = sideSeq[loop].data();
+	double total = 0.0;
+
+	creations[loop].clear();
+	endEnergy.clear();
+	leftContext.clear();
+	rightContext.clear();
+
+	for (int s = 0; s < count; s++)
+		for (int t = s; t < count; t++) {
+
+			int innerCount = t - s + 1;
+			int outerCount = count - (t - s) + 1;
+
+			innerLength.assign(sidelen + s, sidelen + t + 1);
+			innerSeq.assign(seqs + s, seqs + t + 1);
+
+			mergedLength.assign(sidelen, sidelen + s + 1);
+			mergedSeq.assign(seqs, seqs + s + 1);
+			mergedLength.push_back(0);
+			mergedSeq.push_back(NULL);
+			mergedLength.insert(mergedLength.end(), sidelen + t + 1, sidelen + count);
+			mergedSeq.insert(mergedSeq.end(), seqs + t + 1, seqs + count);
+
+			for (int x = 1; x <= sidelen[s]; x++)
+				for (int y = (s == t) ? x + 4 : 1; y <= sidelen[t]; y++) {
+
+					int first = indexOf(seqs[s] + x);
+					int second = indexOf(seqs[t] + y);
+
+					if (pairtypes_mfold[(int) code[first + 1]][(int) code[second + 1]] == 0)
+						continue;
+
+					innerSeq[0] = seqs[s] + x;
+					if (s == t) {
+						innerLength[0] = y - x - 1;
+					} else {
+						innerLength[0] = sidelen[s] - x;
+						innerLength[innerCount - 1] = y - 1;
+					}
+
+					mergedLength[s] = x - 1;
+					mergedLength[s + 1] = sidelen[t] - y;
+					mergedSeq[s + 1] = seqs[t] + y;
+
+					double energies[2];
+					energies[0] = loopEnergy(open, outerCount, mergedLength.data(), mergedSeq.data());
+					energies[1] = loopEnergy(false, innerCount, innerLength.data(), innerSeq.data());
+
+					Creation creation = { first, second, RateEnv() };
+					creations[loop].push_back(creation);
+					endEnergy.push_back(energies[0] + energies[1]);
+					leftContext.push_back(context(false, innerCount, innerLength.data(), 0));
+
+					// a hairpin closed in a multiloop takes the context of what is left before it, twice
+					if (!open && count > 2 && s == t)
+						rightContext.push_back(energyModel->prefactorInternal(x - 1, x - 1));
+					else
+						rightContext.push_back(context(open, outerCount, mergedLength.data(), s + 1));
+				}
+		}
+
+	std::vector<Creation>& found = creations[loop];
+	rates.resize(found.size());
+	if (!found.empty())
+		energyModel->returnRates(energy[loop], found.size(), endEnergy.data(), rates.data());
+
+	for (unsigned int i = 0; i < found.size(); i++) {
+		found[i].rate = RateEnv(rates[i], energyModel, leftContext[i], rightContext[i]);
+		total += found[i].rate.rate;
+	}
+
+	creationRate[loop] = total;
+	setLeaf(loop);
+
+}
+
+// Deleting pair first merges its inner loop into the outer one. The loop graph keeps this
+// move in both loops at half the rate, which is reproduced here by halving and doubling.
+void FlatComplex::generateDeletion(int first) {
+
+	int outer = loopOf[first];
+	int pair = 1;
+
+	while (branches[outer][pair] != first)
+		pair++;
+
+	int outerCount = sideLength[outer].size();
+	int *outerLength = sideLength[outer].data();
+	char **outerSeq = sideSeq[outer].data();
+
+	int innerCount = sideLength[first].size();
+	int *sidelen = sideLength[first].data();
+	char **seqs = sideSeq[first].data();
+
+	mergedLength.assign(outerLength, outerLength + pair - 1);
+	mergedSeq.assign(outerSeq, outerSeq + pair - 1);
+
+	if (innerCount == 1) {
+		mergedLength.push_back(outerLength[pair - 1] + sidelen[0] + outerLength[pair] + 2);
+		mergedSeq.push_back(outerSeq[pair - 1]);
+	} else {
+		mergedLength.push_back(outerLength[pair - 1] + 1 + sidelen[0]);
+		mergedSeq.push_back(outerSeq[pair - 1]);
+		mergedLength.insert(mergedLength.end(), sidelen + 1, sidelen + innerCount - 1);
+		mergedSeq.insert(mergedSeq.end(), seqs + 1, seqs + innerCount - 1);
+		mergedLength.push_back(sidelen[innerCount - 1] + 1 + outerLength[pair]);
+		mergedSeq.push_back(seqs[innerCount - 1]);
+	}
+
+	mergedLength.insert(mergedLength.end(), outerLength + pair + 1, outerLength + outerCount);
+	mergedSeq.insert(mergedSeq.end(), outerSeq + pair + 1, outerSeq + outerCount);
+
+	double newEnergy = loopEnergy(isOpen(outer), mergedLength.size(), mergedLength.data(), mergedSeq.data());
+	double tempRate = energyModel->returnRate(energy[first] + energy[outer], newEnergy, 0);
+
+	MoveType left = context(false, innerCount, sidelen, 0);
+	MoveType right = context(isOpen(outer), outerCount, outerLength, pair);
+
+	// The loop graph reads a multiloop from the side after the pair and the one after the
+	// next pair, and an open loop the same way when the other loop is a bulge or a multiloop.
+	// A hairpin in a multiloop is a stack and a loop, unless it leaves an interior loop.
+	bool bulge = innerCount == 2 && ((sidelen[0] == 0) != (sidelen[1] == 0));
+
+	if (innerCount > 2)
+		left = energyModel->getPrefactorsMulti(0, innerCount, sidelen);
+
+	if (isOpen(outer) && (bulge || innerCount > 2))
+		right = energyModel->getPrefactorsMulti(pair - 1, outerCount - 1, outerLength);
+	else if (!isOpen(outer) && outerCount > 2)
+		right = energyModel->getPrefactorsMulti(pair, outerCount, outerLength);
+
+	if (innerCount == 1 && !isOpen(outer) && outerCount > 2 && (outerCount > 3 || outerLength[(pair + 1) % 3] == 0))
+		right = stackStackMove;
+
+	deletion[first] = RateEnv(tempRate / 2.0, energyModel, left, right);
+	deletion[first].rate *= 2.0;
+
+	setLeaf(first);
+
+}
+
+// Assigns the bases between from and to, at the level just inside them, to the loop.
+void FlatComplex::relabel(int loop, int from, int to) {
+
+	for (int k = from + 1; k < to; k++) {
+
+		loopOf[k] = loop;
+
+		if (pairs[k] >= 0) {
+			k = pairs[k];
+			loopOf[k] = loop;
+		}
+	}
+
+}
+
+void FlatComplex::refreshLoop(int loop) {
+
+	describe(loop);
+	energy[loop] = loopEnergy(isOpen(loop), sideLength[loop].size(), sideLength[loop].data(), sideSeq[loop].data());
+
+	if (isOpen(loop))
+		exteriorCounted = false;
+
+}
+
+void FlatComplex::setLeaf(int slot) {
+
+	int node = capacity + slot;
+	tree[node] = creationRate[slot] + deletion[slot].rate;
+
+	for (node = node / 2; node > 0; node = node / 2)
+		tree[node] = tree[2 * node] + tree[2 * node + 1];
+
+}
+
+void FlatComplex::generateMoves(void) {
+
+	generateCreations(length);
+
+	for (int k = 0; k < length; k++)
+		if (pairs[k] > k) {
+			generateCreations(k);
+			generateDeletion(k);
+		}
+
+}
+
+double FlatComplex::getTotalFlux(void) {
+
+	return tree[1];
+
+}
+
+uint16_t FlatComplex::getMoveCount(void) {
+
+	int count = 0;
+
+	for (int k = 0; k <= length; k++) {
+
+		count += creations[k].size();
+
+		if (deletion[k].rate > 0.0)
+			count++;
+	}
+
+	return count;
+
+}
+
+double FlatComplex::getEnergy(void) {
+
+	double total = energy[length];
+
+	for (int k = 0; k < length; k++)
+		if (pairs[k] > k)
+			total += energy[k];
+
+	return total;
+
+}
+
+double FlatComplex::getEnthalpy(void) {
+
+	double total = 0.0;
+
+	for (int k = 0; k <= length; k++)
+		if (isOpen(k) || pairs[k] > k)
+			total += loopEnergy(isOpen(k), sideLength[k].size(), sideLength[k].data(), sideSeq[k].data(), true);
+
+	return total;
+
+}
+
+// Counted again only after the exterior loop changed, see refreshLoop.
+BaseCount& FlatComplex::getExteriorBases(void) {
+
+	if (exteriorCounted)
+		return exteriorBases;
+
+	exteriorBases.clear();
+
+	for (int side = 0; side < (int) sideLength[length].size(); side++)
+		for (int k = 1; k <= sideLength[length][side]; k++)
+			exteriorBases.count[(int) sideSeq[length][side][k]]++;
+
+	exteriorCounted = true;
+	return exteriorBases;
+
+}
+
+// The strand is alone in the system, so there is nothing to join with.
+OpenInfo& FlatComplex::getOpenInfo(void) {
+
+	return openInfo;
+
+}
+
+Move *FlatComplex::getChoice(SimTimer& timer) {
+
+	int node = 1;
+
+	while (node < capacity) {
+
+		double left = tree[2 * node];
+
+		if ((left > 0.0 && timer.wouldBeHit(left)) || tree[2 * node + 1] <= 0.0) {
+			node = 2 * node;
+		} else {
+			timer.checkHit(left);
+			node = 2 * node + 1;
+		}
+	}
+
+	int slot = node - capacity;
+	double total = creationRate[slot] + deletion[slot].rate;
+
+	// the partial sums stored in the tree can differ from the leaf in the last bit.
+	if (!timer.wouldBeHit(total))
+		timer.rchoice = total * (1.0 - 1e-12);
+
+	if (deletion[slot].rate > 0.0) {
+
+		if (timer.wouldBeHit(deletion[slot].rate)) {
+			choice = Move(MOVE_DELETE | MOVE_1, deletion[slot], NULL, slot, pairs[slot]);
+			return &choice;
+		}
+
+		timer.checkHit(deletion[slot].rate);
+	}
+
+	Creation *picked = NULL;
+
+	for (Creation& creation : creations[slot]) {
+
+		if (creation.rate.rate <= 0.0)
+			continue;
+
+		picked = &creation;
+
+		if (timer.wouldBeHit(creation.rate.rate))
+			break;
+
+		timer.checkHit(creation.rate.rate);
+	}
+
+	assert(picked != NULL);
+
+	choice = Move(MOVE_CREATE | MOVE_1, picked->rate, NULL, picked->first, picked->second);
+	return &choice;
+
+}
+
+// The strand is alone in its complex, so the flat sequence is the strand.
+void FlatComplex::listMoves(std::vector<BasePairMove>& output) {
+
+	for (int k = 0; k <= length; k++) {
+
+		for (Creation& creation : creations[k])
+			output.push_back( { true, creation.first, creation.second, creation.rate.rate });
+
+		if (deletion[k].rate > 0.0)
+			output.push_back( { false, k, pairs[k], deletion[k].rate });
+	}
+
+}
+
+void FlatComplex::doChoice(Move *move) {
+
+	int first = move->index[0];
+	int second = move->index[1];
+	char *strand = ordering->first->thisCodeSeq;
+
+	if (move->type & MOVE_CREATE) {
+
+		int loop = loopOf[first];
+
+		ordering->addBasepair(strand + first, strand + second);
+
+		pairs[first] = second;
+		pairs[second] = first;
+		relabel(first, first, second);
+
+		refreshLoop(loop);
+		refreshLoop(first);
+		generateCreations(loop);
+		generateCreations(first);
+
+		for (int pair : branches[loop])
+			if (pair >= 0)
+				generateDeletion(pair);
+
+		for (int pair : branches[first])
+			if (pair != first)
+				generateDeletion(pair);
+
+	} else {
+
+		int loop = loopOf[first];
+
+		ordering->breakBasepair(strand + first, strand + second);
+
+		relabel(loop, first, second);
+		pairs[first] = -1;
+		pairs[second] = -1;
+
+		sideLength[first].clear();
+		sideSeq[first].clear();
+		branches[first].clear();
+		creations[first].clear();
+		creationRate[first] = 0.0;
+		deletion[first] = RateEnv();
+		energy[first] = 0.0;
+		setLeaf(first);
+
+		refreshLoop(loop);
+		generateCreations(loop);
+
+		for (int pair : branches[loop])
+			if (pair >= 0)
+				generateDeletion(pair);
+	}
+
+}
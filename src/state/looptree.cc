@@ -0,0 +1,203 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the LoopTree object found in looptree.h
+#include <assert.h>
+#include <utility>
+#include "looptree.h"
+#include "loop.h"
+#include "move.h"
+#include "simtimer.h"
+
+const int LOOPTREE_INITIAL_CAPACITY = 16;
+
+LoopTree::LoopTree(void) {
+
+	capacity = LOOPTREE_INITIAL_CAPACITY;
+	used = 0;
+	rates.assign(2 * capacity, 0.0);
+	loops.assign(capacity, NULL);
+
+}
+
+// Forgets every indexed loop without touching them, the loops may already be deleted.
+void LoopTree::clear(void) {
+
+	for (int slot = 0; slot < used; slot++)
+		loops[slot] = NULL;
+
+	rates.assign(2 * capacity, 0.0);
+	freeSlots.clear();
+	used = 0;
+
+}
+
+// Loops handed to rebuild may still carry indices from another complex (after a split or join),
+// so every reachable loop is assigned a fresh slot here regardless of its old index.
+void LoopTree::rebuild(Loop *beginLoop) {
+
+	clear();
+
+	if (beginLoop == NULL)
+		return;
+
+	std::vector<std::pair<Loop*, Loop*> > stack;
+	stack.push_back(std::make_pair(beginLoop, (Loop*) NULL));
+
+	while (stack.size() > 0) {
+
+		Loop *current = stack.back().first;
+		Loop *from = stack.back().second;
+		stack.pop_back();
+
+		current->treeIndex = -1;
+		insert(current);
+
+		for (int i = 0; i < current->curAdjacent; i++) {
+			Loop *next = current->adjacentLoops[i];
+			if (next != NULL && next != from)
+				stack.push_back(std::make_pair(next, current));
+		}
+	}
+
+}
+
+void LoopTree::insert(Loop *loop) {
+
+	assert(loop->treeIndex == -1);
+
+	int slot;
+
+	if (freeSlots.size() > 0) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		if (used == capacity)
+			grow();
+		slot = used++;
+	}
+
+	loops[slot] = loop;
+	loop->treeIndex = slot;
+	setLeaf(slot, loop->frozen ? 0.0 : loop->totalRate);
+
+}
+
+void LoopTree::remove(Loop *loop) {
+
+	int slot = loop->treeIndex;
+
+	assert(slot >= 0 && slot < used && loops[slot] == loop);
+
+	loops[slot] = NULL;
+	loop->treeIndex = -1;
+	setLeaf(slot, 0.0);
+	freeSlots.push_back(slot);
+
+}
+
+void LoopTree::update(Loop *loop) {
+
+	assert(loop->treeIndex >= 0 && loops[loop->treeIndex] == loop);
+
+	setLeaf(loop->treeIndex, loop->frozen ? 0.0 : loop->totalRate);
+
+}
+
+// After a move, the loops it created are connected to each other and are the only loops
+// without a slot. Their neighbours are the only other loops whose moves were regenerated.
+void LoopTree::updateRegion(Loop *newLoop) {
+
+	std::vector<Loop*> pending;
+
+	insert(newLoop);
+	pending.push_back(newLoop);
+
+	while (pending.size() > 0) {
+
+		Loop *current = pending.back();
+		pending.pop_back();
+
+		for (int i = 0; i < current->curAdjacent; i++) {
+
+			Loop *next = current->adjacentLoops[i];
+
+			if (next == NULL)
+				continue;
+
+			if (next->treeIndex == -1) {
+				insert(next);
+				pending.push_back(next);
+			} else {
+				update(next);
+			}
+		}
+	}
+
+}
+
+double LoopTree::getRate(void) {
+
+	return rates[1];
+
+}
+
+Move *LoopTree::getChoice(SimTimer& timer) {
+
+	int node = 1;
+
+	while (node < capacity) {
+
+		double left = rates[2 * node];
+
+		// only descend into subtrees with a positive rate, so we always end on an indexed loop.
+		if ((left > 0.0 && timer.wouldBeHit(left)) || rates[2 * node + 1] <= 0.0) {
+			node = 2 * node;
+		} else {
+			timer.checkHit(left);
+			node = 2 * node + 1;
+		}
+	}
+
+	Loop *loop = loops[node - capacity];
+	assert(loop != NULL);
+	assert(!loop->isFrozen());
+
+	// the partial sums stored in the tree can differ from the loop's own rate in the last bit.
+	if (!timer.wouldBeHit(loop->totalRate))
+		timer.rchoice = loop->totalRate * (1.0 - 1e-12);
+
+	return loop->moves->getChoice(timer);
+
+}
+
+void LoopTree::grow(void) {
+
+	int oldCapacity = capacity;
+	std::vector<double> oldRates;
+	oldRates.swap(rates);
+
+	capacity = 2 * capacity;
+	rates.assign(2 * capacity, 0.0);
+	loops.resize(capacity, NULL);
+
+	for (int slot = 0; slot < oldCapacity; slot++)
+		rates[capacity + slot] = oldRates[oldCapacity + slot];
+
+	for (int node = capacity - 1; node > 0; node--)
+		rates[node] = rates[2 * node] + rates[2 * node + 1];
+
+}
+
+void LoopTree::setLeaf(int slot, double rate) {
+
+	int node = capacity + slot;
+	rates[node] = rate;
+
+	for (node = node / 2; node > 0; node = node / 2)
+		rates[node] = rates[2 * node] + rates[2 * node + 1];
+
+}
@@ -8,6 +8,8 @@
 #include <string.h>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
+#include <tuple>
 #include <iostream>
 #include <sstream>
 #include "scomplex.h"
@@ -68,6 +70,7 @@ StrandComplex::StrandComplex(StrandOrdering *newOrdering)
 {
 	ordering = newOrdering;
 	beginLoop = ordering->getLoop();
+	loopTree.rebuild(beginLoop);
 }
 
 StrandComplex::~StrandComplex(void)
@@ -75,12 +78,69 @@ StrandComplex::~StrandComplex(void)
 	// we cannot delete this here now, as they could be associated with a strandordering that will live on when the complex dies.
 	if (ordering != NULL)
 		delete ordering;
+	if (flat != NULL)
+		delete flat;
 }
 
 typedef std::vector<Loop *> LoopVector;
 
+// Every loop is copied before the copies are linked, as their moves affect neighbouring loops.
+// The copy indexes its loops in the same order, so it makes the same choices as the original.
+StrandComplex *StrandComplex::copy(void)
+{
+	LoopCopier copier;
+	StrandComplex *result = new StrandComplex(ordering->copy(copier));
+	result->flatEngine = flatEngine;
+
+	if (flat != NULL)
+	{
+		result->flat = new FlatComplex(*flat, result->ordering);
+		return result;
+	}
+
+	if (beginLoop == NULL)
+		return result;
+
+	LoopVector loops;
+	std::vector<std::pair<Loop *, Loop *>> stack;
+	stack.push_back(std::make_pair(beginLoop, (Loop *)NULL));
+
+	while (stack.size() > 0)
+	{
+		Loop *current = stack.back().first;
+		Loop *from = stack.back().second;
+		stack.pop_back();
+
+		copier.addLoop(current, current->copy(copier));
+		loops.push_back(current);
+
+		for (int i = 0; i < current->getCurAdjacent(); i++)
+			if (current->getAdjacent(i) != from)
+				stack.push_back(std::make_pair(current->getAdjacent(i), current));
+	}
+
+	for (Loop *loop : loops)
+		loop->linkCopy(copier);
+
+	for (orderingList *strand = ordering->first, *strandCopy = result->ordering->first; strand != NULL; strand = strand->next, strandCopy = strandCopy->next)
+		strandCopy->thisLoop = (OpenLoop *)copier.loop(strand->thisLoop);
+
+	result->beginLoop = copier.loop(beginLoop);
+	result->loopTree.rebuild(result->beginLoop);
+
+	return result;
+}
+
 void StrandComplex::cleanup(void)
 {
+	if (flat != NULL)
+	{
+		delete flat;
+		flat = NULL;
+		ordering->cleanup();
+		return;
+	}
+
 	LoopVector loops;
 	loops.push_back(beginLoop);
 	while (loops.size() > 0)
@@ -93,6 +153,7 @@ void StrandComplex::cleanup(void)
 		delete current;
 	}
 	beginLoop = NULL;
+	loopTree.clear();
 	ordering->cleanup();
 }
 
@@ -106,6 +167,11 @@ void StrandComplex::cleanup(void)
 int StrandComplex::checkIDList(class identList *stoplist, int id_count)
 {
 	OpenLoop *temp;
+
+	// a single strand needs no reordering, and has no open loop object with the flat engine
+	if (flat != NULL)
+		return (id_count == 1 && strcmp(ordering->first->thisTag, stoplist->id) == 0);
+
 	temp = ordering->checkIDList(stoplist, id_count);
 	if (temp == NULL)
 		return 0;
@@ -180,6 +246,9 @@ StrandComplex *StrandComplex::performComplexJoin(JoinCriteria crit, bool useArr)
 	loops[1]->cleanupAdjacent();
 	delete loops[1];
 
+	complexes[0]->loopTree.rebuild(complexes[0]->beginLoop);
+	complexes[1]->loopTree.clear();
+
 	delete complexes[1]->ordering;
 	complexes[1]->ordering = NULL;
 	return complexes[1];
@@ -191,6 +260,12 @@ StrandComplex *StrandComplex::doChoice(Move *move, SimTimer &timer)
 	Loop *temp = NULL, *temp2 = NULL, *temp3 = NULL;
 	char id2, id3;
 
+	if (flat != NULL)
+	{
+		flat->doChoice(move);
+		return NULL;
+	}
+
 	temp2 = move->affected[0];
 	temp3 = move->affected[1];
 
@@ -232,6 +307,7 @@ StrandComplex *StrandComplex::doChoice(Move *move, SimTimer &timer)
 
 		newOrdering = ordering->breakOrdering(temp2, temp3, newLoop[0], newLoop[1]);
 		beginLoop = ordering->getLoop();
+		loopTree.rebuild(beginLoop);
 
 		if (utility::debugTraces)
 		{
@@ -259,10 +335,10 @@ StrandComplex *StrandComplex::doChoice(Move *move, SimTimer &timer)
 			}
 
 			// exit if one of the transitions are touching a frozen base
-			// right now, frozen if more than 100 nt from the most active one.
+			// the open loops and the loops that are frozen entirely have no such transitions, see activateNucleotide.
 			uint64_t actives= timer.nuclAdded + timer.simOptions->initialActiveNT;
 
-			constexpr uint64_t bound = 200;
+			const uint64_t bound = timer.simOptions->frozenNT;
 			if( dist_left_bp + bound < actives || dist_right_bp + bound < actives ){
 				return NULL;
 			}
@@ -275,7 +351,13 @@ StrandComplex *StrandComplex::doChoice(Move *move, SimTimer &timer)
 		else if (move->getType() & MOVE_DELETE) // FD: test if we have a delete-basepair move
 			ordering->breakBasepair(move->getAffected(0)->getLocation(move, 0), move->getAffected(1)->getLocation(move, 1));
 
+		// the affected loops are deleted by the move, the loops replacing them are indexed afterwards.
+		loopTree.remove(temp2);
+		if (temp3 != NULL)
+			loopTree.remove(temp3);
+
 		temp = move->doChoice();
+		loopTree.updateRegion(temp);
 
 		if (id2 == 'O')
 			ordering->replaceOpenLoop(temp2, temp);
@@ -289,7 +371,9 @@ StrandComplex *StrandComplex::doChoice(Move *move, SimTimer &timer)
 			else
 				assert(0);
 		}
+#ifdef DEBUG
 		beginLoop->verifyLoop(NULL, NULL);
+#endif
 	}
 	return NULL;
 }
@@ -320,6 +404,12 @@ int StrandComplex::generateLoops(void)
 	Loop *newLoop;
 	char *sequence, *structure, *charsequence;
 
+	if (flatEngine)
+	{
+		flat = new FlatComplex(ordering);
+		return 0;
+	}
+
 	// ZIFNAB: begin work here 8/2.
 	// ZIFNAB: done, completed change to convertIndex notation.
 	// ZIFNAB: more work 8/22: sequence, charsequence are used oddly, which one is actually the character sequence? do loops get the character sequence or the code sequence pointer?
@@ -499,8 +589,8 @@ int StrandComplex::generateLoops(void)
 
 			openloopcount = 0;
 			// listlength is at least one.
-			OL_sidelengths = (int *)new int[listlength + 1];
-			OL_sequences = (char **)new char *[listlength + 1];
+			OL_sidelengths = poolArray<int>(listlength + 1);
+			OL_sequences = poolArray<char*>(listlength + 1);
 			// deletion for these is handled in the OpenLoop destructor.
 			temp_intlist = templist;
 
@@ -583,8 +673,8 @@ int StrandComplex::generateLoops(void)
 			if (listlength != 0)
 			{
 
-				OL_sidelengths = (int *)new int[listlength + 1];
-				OL_sequences = (char **)new char *[listlength + 1];
+				OL_sidelengths = poolArray<int>(listlength + 1);
+				OL_sequences = poolArray<char*>(listlength + 1);
 				// deletion for these is handled in the OpenLoop destructor.
 				temp_intlist = templist;
 				/*	      OL_pairtypes[0] = stacklist->pairtype;
@@ -608,8 +698,8 @@ int StrandComplex::generateLoops(void)
 			else
 			{
 
-				OL_sidelengths = (int *)new int[listlength + 1];
-				OL_sequences = (char **)new char *[listlength + 1];
+				OL_sidelengths = poolArray<int>(listlength + 1);
+				OL_sequences = poolArray<char*>(listlength + 1);
 				OL_sidelengths[0] = seqlen;
 				OL_sequences[0] = ordering->convertIndex(-1);
 				newLoop = new OpenLoop(0, OL_sidelengths, OL_sequences); // open chain
@@ -620,8 +710,8 @@ int StrandComplex::generateLoops(void)
 		{
 			int *ML_sidelengths;
 			char **ML_sequences;
-			ML_sidelengths = (int *)new int[listlength];
-			ML_sequences = (char **)new char *[listlength];
+			ML_sidelengths = poolArray<int>(listlength);
+			ML_sequences = poolArray<char*>(listlength);
 			// deletion for these is handled in the OpenLoop destructor.
 			temp_intlist = templist;
 			// JS: Possibly a problem here, need to make sure sequences get paired correctly with lengths. FIXME
@@ -719,14 +809,63 @@ int StrandComplex::generateLoops(void)
 		delete[] structure;
 	if (charsequence != NULL)
 		delete[] charsequence;
+
+	return 0;
+}
+
+void StrandComplex::useFlatEngine(void)
+{
+	assert(ordering->getStrandCount() == 1);
+	flatEngine = true;
 }
 
 void StrandComplex::printAllMoves(void)
 {
+	if (flat != NULL)
+		return;
 
 	beginLoop->printAllMoves(NULL);
 }
 
+// The loop graph keeps a deletion move in both of its loops, at half the rate.
+void StrandComplex::listMoves(std::vector<BasePairMove>& output)
+{
+	std::vector<BasePairMove> found;
+
+	if (flat != NULL)
+	{
+		flat->listMoves(found);
+	}
+	else
+	{
+		std::vector<Move*> moves;
+		beginLoop->listAllMoves(NULL, moves);
+
+		for (Move *move : moves)
+		{
+			bool create = move->getType() & MOVE_CREATE;
+			Loop *second = create ? move->getAffected(0) : move->getAffected(1);
+			int one = ordering->flatIndex(move->getAffected(0)->getLocation(move, 0));
+			int two = ordering->flatIndex(second->getLocation(move, 1));
+
+			found.push_back({create, std::min(one, two), std::max(one, two), move->getRate()});
+		}
+	}
+
+	std::sort(found.begin(), found.end(), [](const BasePairMove& a, const BasePairMove& b)
+	{
+		return std::make_tuple(!a.create, a.first, a.second) < std::make_tuple(!b.create, b.first, b.second);
+	});
+
+	for (BasePairMove& move : found)
+	{
+		if (!output.empty() && output.back().create == move.create && output.back().first == move.first && output.back().second == move.second)
+			output.back().rate += move.rate;
+		else
+			output.push_back(move);
+	}
+}
+
 string StrandComplex::toString()
 {
 
@@ -754,6 +893,8 @@ string StrandComplex::toString()
 
 OpenInfo &StrandComplex::getOpenInfo()
 {
+	if (flat != NULL)
+		return flat->getOpenInfo();
 
 	return ordering->getOpenInfo();
 }
@@ -766,11 +907,15 @@ StrandOrdering *StrandComplex::getOrdering()
 
 double StrandComplex::getTotalFlux(void)
 {
-	return beginLoop->returnFlux(NULL);
+	if (flat != NULL)
+		return flat->getTotalFlux();
+	return loopTree.getRate();
 }
 
 uint16_t StrandComplex::getMoveCount(void)
 {
+	if (flat != NULL)
+		return flat->getMoveCount();
 	return beginLoop->getMoveCount(NULL);
 }
 
@@ -793,6 +938,8 @@ char *StrandComplex::getStrandNames(void)
 
 BaseCount &StrandComplex::getExteriorBases(HalfContext *lowerHalf)
 {
+	if (flat != NULL)
+		return (lowerHalf == NULL) ? flat->getExteriorBases() : emptyBaseCount;
 
 	if (lowerHalf == NULL)
 	{
@@ -802,41 +949,89 @@ BaseCount &StrandComplex::getExteriorBases(HalfContext *lowerHalf)
 	else
 	{
 
-		OpenInfo &info = ordering->getOpenInfo();
-
-		if (info.tally.count(*lowerHalf))
-		{
-
-			return info.tally.find(*lowerHalf)->second;
-		}
-		else
-		{
-
-			return emptyBaseCount;
-		}
+		return ordering->getOpenInfo().get(*lowerHalf);
 	}
 }
 
 double StrandComplex::getEnergy(void)
 {
+	if (flat != NULL)
+		return flat->getEnergy();
 
 	return beginLoop->returnEnergies(NULL);
 }
 
 double StrandComplex::getEnthalpy(void)
 {
+	if (flat != NULL)
+		return flat->getEnthalpy();
 
 	return beginLoop->returnEnthalpies(NULL);
 }
 
 void StrandComplex::generateMoves(void)
 {
+	if (flat != NULL)
+	{
+		flat->generateMoves();
+		return;
+	}
 	beginLoop->firstGen(NULL);
+	loopTree.rebuild(beginLoop);
+}
+
+// Only open loops have moves that depend on the active nucleotides, so only those holding the new
+// one are regenerated. The loops whose bases all fell behind the window are then frozen. A loop
+// ends before the loop around it, so the loops that are not frozen hang together from the open
+// loop, and the search stops at the frozen ones.
+void StrandComplex::activateNucleotide(void)
+{
+	EnergyModel *model = Loop::GetEnergyModel();
+	char *start = ordering->first->thisCodeSeq;
+	std::vector<std::pair<Loop *, Loop *>> stack;
+
+	for (orderingList *strand = ordering->first; strand != NULL; strand = strand->next)
+	{
+		if (strand->thisLoop->holdsNewestNucleotide())
+		{
+			strand->thisLoop->generateMoves();
+			loopTree.update(strand->thisLoop);
+		}
+
+		stack.push_back(std::make_pair((Loop *)strand->thisLoop, (Loop *)NULL));
+	}
+
+	while (stack.size() > 0)
+	{
+		Loop *current = stack.back().first;
+		Loop *from = stack.back().second;
+		stack.pop_back();
+
+		for (int i = 0; i < current->getCurAdjacent(); i++)
+		{
+			Loop *next = current->getAdjacent(i);
+
+			if (next == NULL || next == from || next->isFrozen() || next->getType() == 'O')
+				continue;
+
+			if (next->getLastBase() - start + model->simOptions->frozenNT < model->numActiveNT)
+			{
+				next->freeze();
+				loopTree.update(next);
+			}
+			else
+			{
+				stack.push_back(std::make_pair(next, current));
+			}
+		}
+	}
 }
 
 Move *StrandComplex::getChoice(SimTimer &timer)
 {
-	return beginLoop->getChoice(timer, NULL);
+	if (flat != NULL)
+		return flat->getChoice(timer);
+	return loopTree.getChoice(timer);
 }
 
 int StrandComplex::getStrandCount(void)
@@ -16,6 +16,7 @@
 #include <simoptions.h>
 #include <utility.h>
 #include <moveutil.h>
+#include "stopconditions.h"
 #include <assert.h>
 
 typedef std::vector<int> intvec;
@@ -39,6 +40,10 @@ SComplexListEntry::SComplexListEntry(StrandComplex *newComplex, int newid) {
 
 SComplexListEntry::~SComplexListEntry(void) {
 	delete thisComplex;
+	if (species != NULL) {
+		delete species->list;
+		delete species;
+	}
 	if (next != NULL)
 		delete next;
 }
@@ -51,6 +56,9 @@ SComplexListEntry::~SComplexListEntry(void) {
 
 void SComplexListEntry::initializeComplex(void) {
 
+	if (initialized)
+		return;
+
 	thisComplex->generateLoops();
 	if (utility::debugTraces) {
 		cout << "Done generating loops!" << endl;
@@ -62,16 +70,27 @@ void SComplexListEntry::initializeComplex(void) {
 		cout << "Done generating moves!" << endl;
 	}
 
-}
+	initialized = true;
 
-void SComplexListEntry::regenerateMoves(void) {
-	thisComplex->generateMoves();
 }
 
-void SComplexListEntry::fillData(EnergyModel *em) {
+// The rate comes from the loop tree of the complex. The energy walks every loop, so it
+// is only computed when it is asked for.
+void SComplexListEntry::fillData(void) {
 
-	energy = thisComplex->getEnergy() + (em->getVolumeEnergy() + em->getAssocEnergy()) * (thisComplex->getStrandCount() - 1);
 	rate = thisComplex->getTotalFlux();
+	energyValid = false;
+
+}
+
+double SComplexListEntry::getEnergy(EnergyModel *em) {
+
+	if (!energyValid) {
+		energy = thisComplex->getEnergy() + (em->getVolumeEnergy() + em->getAssocEnergy()) * (thisComplex->getStrandCount() - 1);
+		energyValid = true;
+	}
+
+	return energy;
 
 }
 
@@ -84,9 +103,14 @@ string SComplexListEntry::toString(EnergyModel *em) {
 	std::stringstream ss;
 
 	// more comparable to NUPACK  - - FD replace assoEnergy with 2.44
+	double energy = getEnergy(em);
 	double printEnergy = (energy - (em->getVolumeEnergy() + em->getAssocEnergy()) * (thisComplex->getStrandCount() - 1));
 
 	ss << "Complex         : " << id << " \n";
+
+	if (copies > 1)
+		ss << "copies          : " << copies << " \n";
+
 	ss << "seq, struc      : " << thisComplex->getSequence() << " - " << thisComplex->getStructure() << " \n";
 	ss << "energy-ms       : " << energy << endl;
 	ss << "energy-nu,rate  : " << printEnergy << " - " << rate << "     (T=" << em->simOptions->energyOptions->getTemperature() << ")";
@@ -103,13 +127,13 @@ string SComplexListEntry::toString(EnergyModel *em) {
 
 }
 
-void SComplexListEntry::dumpComplexEntryToPython(ExportData& data) {
+void SComplexListEntry::dumpComplexEntryToPython(ExportData& data, EnergyModel *em) {
 
 	data.id = id;
 	data.names = string(thisComplex->getStrandNames());
 	data.sequence = thisComplex->getSequence();
 	data.structure = thisComplex->getStructure();
-	data.energy = energy;
+	data.energy = getEnergy(em);
 	data.enthalpy = thisComplex->getEnthalpy();
 
 }
@@ -125,7 +149,8 @@ void SComplexListEntry::dumpComplexEntryToPython(ExportData& data) {
 
  */
 
-SComplexList::SComplexList(EnergyModel *energyModel) {
+SComplexList::SComplexList(EnergyModel *energyModel) :
+		complexIndex(energyModel) {
 
 	eModel = energyModel;
 
@@ -140,6 +165,42 @@ SComplexList::~SComplexList(void) {
 	}
 	if (first != NULL)
 		delete first;
+	if (stopTracker != NULL)
+		delete stopTracker;
+}
+
+// The entries keep their order and ids, the flux bookkeeping is left to initializeList.
+SComplexList *SComplexList::copy(void) {
+
+	SComplexList *result = new SComplexList(eModel);
+	vector<SComplexListEntry*> entries;
+
+	for (SComplexListEntry *temp = first; temp != NULL; temp = temp->next)
+		entries.push_back(temp);
+
+	// addComplex puts every entry in front
+	for (int i = (int) entries.size() - 1; i >= 0; i--) {
+
+		SComplexListEntry *original = entries[i];
+		SComplexListEntry *entry = result->addComplex(original->thisComplex->copy());
+
+		entry->id = original->id;
+		entry->initialized = original->initialized;
+		entry->copies = original->copies;
+		entry->copyIds = original->copyIds;
+
+		if (original->species != NULL) {
+			entry->species = new utility::complex_input(*original->species);
+			entry->species->list = original->species->list->copy();
+		}
+	}
+
+	result->numOfComplexes = numOfComplexes;
+	result->spareCopies = spareCopies;
+	result->idcounter = idcounter;
+
+	return result;
+
 }
 
 /* 
@@ -152,14 +213,80 @@ SComplexListEntry *SComplexList::addComplex(StrandComplex *newComplex) {
 	else {
 		SComplexListEntry *temp = new SComplexListEntry(newComplex, idcounter);
 		temp->next = first;
+		first->prev = temp;
 		first = temp;
 	}
 	numOfComplexes++;
 	idcounter++;
 
+	complexIndex.insert(first);
+
 	return first;
 }
 
+// Another copy of the start complex of the entry.
+void SComplexList::addCopy(SComplexListEntry *entry) {
+
+	entry->copies++;
+	entry->copyIds.push_back(idcounter);
+
+	numOfComplexes++;
+	spareCopies++;
+	idcounter++;
+
+}
+
+// A copy leaves its species as a complex of its own, built from the same start complex, with
+// the id it was exported with. The pairings between the copies carry over to the new complex.
+SComplexListEntry *SComplexList::materialize(SComplexListEntry *species) {
+
+	assert(species->copies > 1 && species->species != NULL);
+
+	removeExposed(species);
+	uniFlux -= species->rate;
+
+	species->copies--;
+	spareCopies--;
+	numOfComplexes--; // counted again by addComplex
+
+	complexIndex.updateRate(species);
+	addExposed(species);
+
+	char *sequence = utility::copyToCharArray(species->species->sequence);
+	char *structure = utility::copyToCharArray(species->species->structure);
+
+	SComplexListEntry *entry = addComplex(new StrandComplex(sequence, structure, species->species->list->copy()));
+
+	delete[] sequence;
+	delete[] structure;
+
+	entry->id = species->copyIds.back();
+	species->copyIds.pop_back();
+
+	entry->initializeComplex();
+	entry->fillData();
+	complexIndex.updateRate(entry);
+	uniFlux += entry->rate;
+	addExposed(entry);
+
+	return entry;
+
+}
+
+// The list walks assume one copy per entry.
+bool SComplexList::useIndex(void) {
+
+	return numOfComplexes >= eModel->simOptions->complexIndexThreshold || spareCopies > 0;
+
+}
+
+void SComplexList::initializeComplexes(void) {
+
+	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next)
+		temp->initializeComplex();
+
+}
+
 /*
  SComplexList::initializeList
  */
@@ -174,22 +301,25 @@ void SComplexList::initializeList(void) {
 			cout << "Done initializing a complex!" << endl;
 		}
 
-		temp->fillData(eModel);
+		temp->fillData();
 
 	}
 
+	resetFlux();
+
 	if (utility::debugTraces) {
 		cout << "Done initializing List!" << endl;
 	}
 
 }
 
-void SComplexList::regenerateMoves(void) {
+void SComplexList::activateNucleotide(void) {
 
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-		temp->regenerateMoves();
-		temp->fillData(eModel);
+		temp->thisComplex->activateNucleotide();
+		updateRate(temp);
+		refreshExposed(temp);
 
 	}
 
@@ -201,18 +331,196 @@ void SComplexList::regenerateMoves(void) {
 
 double SComplexList::getTotalFlux(void) {
 
-	double total = 0.0;
+	// the pair counts are kept by differences too, an interval of 1 recomputes them as well
+	if (eModel->inspection || eModel->simOptions->fluxResumInterval <= 1) {
+		joinRate = getJoinFlux();
+	} else {
+		joinRate = getCountedJoinFlux();
+	}
+
+	return uniFlux + joinRate;
+}
+
+/*
+ Incremental flux bookkeeping.
+
+ The unimolecular flux is the sum of the entry rates, and only the entries touched by a move
+ change their rate. The join flux is bilinear in the exposed bases of the complexes, so the
+ number of base pairings between different complexes is kept per pair of move types, and a
+ complex that changes only needs to be crossed with the summed exposed bases of the others.
+ Those counts are integers, so only the unimolecular sum needs an occasional exact resummation.
+ */
+
+void SComplexList::resetFlux(void) {
+
+	uniFlux = 0.0;
+	fluxUpdates = 0;
+
+	exposedBases.clear();
+	exposedInfo.clear();
+	joinCounts.assign(MOVETYPE_SIZE * MOVETYPE_SIZE, 0);
+	complexIndex.clear();
 
 	for (SComplexListEntry *temp = first; temp != NULL; temp = temp->next) {
 
-		total += temp->rate;
+		uniFlux += temp->rate * temp->copies;
+		complexIndex.insert(temp);
+		addExposed(temp);
+
+	}
+
+}
+
+void SComplexList::updateRate(SComplexListEntry *entry) {
+
+	double oldRate = entry->rate;
+	entry->fillData();
+	complexIndex.updateRate(entry);
+
+	fluxUpdates++;
+
+	if (fluxUpdates < eModel->simOptions->fluxResumInterval) {
+
+		uniFlux += (entry->rate - oldRate) * entry->copies;
+
+	} else {
+
+		uniFlux = 0.0;
+		fluxUpdates = 0;
+
+		for (SComplexListEntry *temp = first; temp != NULL; temp = temp->next)
+			uniFlux += temp->rate * temp->copies;
+	}
+
+}
+
+// Adds the complex to the summed exposed bases, after counting its pairings with the other complexes.
+void SComplexList::addExposed(SComplexListEntry *entry) {
+
+	if (eModel->useArrhenius()) {
+
+		entry->exposedInfo = entry->thisComplex->getOpenInfo();
+		crossExposed(entry, 1);
+		exposedInfo.increment(entry->exposedInfo, entry->copies);
+
+	} else {
+
+		entry->exposedBases = entry->thisComplex->getExteriorBases();
+		crossExposed(entry, 1);
+		exposedBases.increment(entry->exposedBases, entry->copies);
+
+	}
+
+	complexIndex.updateExposed(entry);
+
+}
+
+// Inverse of addExposed, using the exposed bases the complex had when it was added.
+void SComplexList::removeExposed(SComplexListEntry *entry) {
+
+	if (eModel->useArrhenius()) {
+		exposedInfo.decrement(entry->exposedInfo, entry->copies);
+	} else {
+		exposedBases.decrement(entry->exposedBases, entry->copies);
+	}
+
+	crossExposed(entry, -1);
+
+}
+
+// Most moves do not change the exterior loop of a complex.
+void SComplexList::refreshExposed(SComplexListEntry *entry) {
+
+	if (eModel->useArrhenius()) {
+
+		OpenInfo& current = entry->thisComplex->getOpenInfo();
+
+		if (current.tally == entry->exposedInfo.tally && current.numExposed == entry->exposedInfo.numExposed)
+			return;
+
+	} else {
+
+		if (entry->thisComplex->getExteriorBases() == entry->exposedBases)
+			return;
+	}
+
+	removeExposed(entry);
+	addExposed(entry);
+
+}
+
+// The copies of an entry pair with the other complexes, and with each other.
+void SComplexList::crossExposed(SComplexListEntry *entry, long sign) {
+
+	long copies = entry->copies;
+	long copyPairs = copies * (copies - 1) / 2;
+
+	if (!eModel->useArrhenius()) {
+
+		joinCounts[0] += sign * copies * entry->exposedBases.multiCount(exposedBases);
+
+		if (copyPairs > 0)
+			joinCounts[0] += sign * copyPairs * entry->exposedBases.multiCount(entry->exposedBases);
+
+		return;
 
 	}
 
-	joinRate = getJoinFlux();
-	total += joinRate;
+	for (QuartContext a : { endC, strandC, stackC }) {
+		for (QuartContext b : { endC, strandC, stackC }) {
+
+			BaseCount& top = entry->exposedInfo.tally[a][b];
+
+			for (QuartContext c : { endC, strandC, stackC }) {
+				for (QuartContext d : { endC, strandC, stackC }) {
+
+					long crossings = copies * top.multiCount(exposedInfo.tally[c][d]);
+
+					if (copyPairs > 0)
+						crossings += copyPairs * top.multiCount(entry->exposedInfo.tally[c][d]);
+
+					if (crossings > 0) {
+
+						MoveType left = moveutil::combineBi(a, d);
+						MoveType right = moveutil::combineBi(b, c);
+
+						// the prefactors are symmetric, and a pair counted from either side has to land in the same slot
+						if (left > right)
+							std::swap(left, right);
+
+						joinCounts[left * MOVETYPE_SIZE + right] += sign * crossings;
+
+					}
+				}
+			}
+		}
+	}
+
+}
+
+double SComplexList::getCountedJoinFlux(void) {
+
+	double output = 0.0;
+
+	if (!eModel->useArrhenius()) {
+
+		if (joinCounts[0] > 0) {
+			output = (double) joinCounts[0] * eModel->getJoinRate();
+			output = eModel->applyPrefactors(output, loopMove, loopMove);
+		}
+
+		return output;
+	}
+
+	for (int index = 0; index < MOVETYPE_SIZE * MOVETYPE_SIZE; index++) {
+
+		if (joinCounts[index] > 0) {
+			output += joinCounts[index] * eModel->joinRateFor((MoveType) (index / MOVETYPE_SIZE), (MoveType) (index % MOVETYPE_SIZE));
+		}
+	}
+
+	return output;
 
-	return total;
 }
 
 BaseCount SComplexList::getExposedBases() {
@@ -222,7 +530,7 @@ BaseCount SComplexList::getExposedBases() {
 	for (SComplexListEntry* it = first; it != NULL; it = it->next) {
 
 		BaseCount& ext_bases = it->thisComplex->getExteriorBases();
-		output.increment(ext_bases);
+		output.increment(ext_bases, it->copies);
 
 	}
 
@@ -235,8 +543,8 @@ OpenInfo SComplexList::getOpenInfo() {
 
 	for (SComplexListEntry* it = first; it != NULL; it = it->next) {
 
-		OpenInfo& ext_bases = it->thisComplex->ordering->getOpenInfo();
-		output.increment(ext_bases);
+		OpenInfo& ext_bases = it->thisComplex->getOpenInfo();
+		output.increment(ext_bases, it->copies);
 
 	}
 
@@ -269,16 +577,19 @@ double SComplexList::getJoinFlux(void) {
 	}
 
 	double output = 0.0;
-	int moveCount = 0;
+	long moveCount = 0;
 
 	BaseCount totalBases = getExposedBases();
 
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
 		BaseCount& ext_bases = temp->thisComplex->getExteriorBases();
-		totalBases.decrement(ext_bases);
+		long copies = temp->copies;
 
-		moveCount += totalBases.multiCount(ext_bases);
+		totalBases.decrement(ext_bases, copies);
+
+		moveCount += copies * totalBases.multiCount(ext_bases);
+		moveCount += copies * (copies - 1) / 2 * ext_bases.multiCount(ext_bases);
 
 	}
 
@@ -349,11 +660,17 @@ double SComplexList::computeArrBiRate(SComplexListEntry* input) {
 	while (temp != NULL) {
 
 		StrandOrdering* otherOrder = temp->thisComplex->getOrdering();
-		output += cycleCrossRateArr(orderIn, otherOrder);
+		output += temp->copies * cycleCrossRateArr(orderIn, otherOrder);
 
 		temp = temp->next;
 	}
 
+	double copies = input->copies;
+	output = copies * output;
+
+	if (copies > 1)
+		output += copies * (copies - 1) / 2 * cycleCrossRateArr(orderIn, orderIn);
+
 	return output;
 
 }
@@ -379,15 +696,18 @@ double *SComplexList::getEnergy(int volume_flag) {
 	double *energies = new double[numOfComplexes];
 	int index = 0;
 	while (temp != NULL) {
-		energies[index] = temp->energy;
+		energies[index] = temp->getEnergy(eModel);
 
 		if (!(volume_flag & 0x01))
 			energies[index] -= (eModel->getVolumeEnergy() * (temp->thisComplex->getStrandCount() - 1));
 		if (!(volume_flag & 0x02))
 			energies[index] -= (eModel->getAssocEnergy() * (temp->thisComplex->getStrandCount() - 1));
 
+		for (int copy = 1; copy < temp->copies; copy++)
+			energies[index + copy] = energies[index];
+
+		index = index + temp->copies;
 		temp = temp->next;
-		index = index + 1;
 	}
 	return energies;
 }
@@ -440,6 +760,25 @@ double SComplexList::doBasicChoice(SimTimer& myTimer) {
 
 	temp = first;
 	StrandComplex *pickedComplex = NULL;
+	SComplexListEntry *lastActive = NULL;
+
+	if (useIndex()) {
+
+		temp2 = complexIndex.getChoice(myTimer);
+
+		if (temp2 != NULL && temp2->copies > 1) {
+
+			// every copy has the same transitions, and one of them leaves the species
+			myTimer.rchoice = fmod(myTimer.rchoice, temp2->rate);
+			temp2 = materialize(temp2);
+
+		}
+
+		if (temp2 != NULL) {
+			pickedComplex = temp2->thisComplex;
+			temp = NULL;
+		}
+	}
 
 	while (temp != NULL) {
 		if (myTimer.wouldBeHit(temp->rate) && pickedComplex == NULL) {
@@ -451,11 +790,21 @@ double SComplexList::doBasicChoice(SimTimer& myTimer) {
 			myTimer.checkHit(temp->rate);
 
 		}
+		if (temp->rate > 0.0) {
+			lastActive = temp;
+		}
 		temp = temp->next;
 	}
 // POST: pickedComplex points to the complex that contains the executable move
 // For cotranscriptional, this is always the initial complex.
 
+	// uniFlux is kept by differences, and can exceed the sum of the rates in the last bits.
+	if (pickedComplex == NULL && lastActive != NULL) {
+		pickedComplex = lastActive->thisComplex;
+		temp2 = lastActive;
+		myTimer.rchoice = lastActive->rate * (1.0 - 1e-12);
+	}
+
 	assert(pickedComplex != NULL);
 
 	tempmove = pickedComplex->getChoice(myTimer);
@@ -463,18 +812,24 @@ double SComplexList::doBasicChoice(SimTimer& myTimer) {
 
 	newComplex = pickedComplex->doChoice(tempmove, myTimer);
 
+	// the picked complex first, so that a split off complex is crossed with what remains of it.
+	updateRate(temp2);
+	refreshExposed(temp2);
+
 	if (newComplex != NULL) {
 
+		temp2->exported = false;
 		temp = addComplex(newComplex);
-		temp->fillData(eModel);
+		temp->fillData();
+		complexIndex.updateRate(temp);
+		uniFlux += temp->rate;
+		addExposed(temp);
 
 	}
 
-	temp2->fillData(eModel);
-
 	// FD Oct 20, 2017.
 	// If co-transcriptional mode is activated, and the time indicates a new nucleotide has been added,
-	// then ask all  loops to regenerated their transitions -- taking the new time into account.
+	// then ask the loops that hold it to regenerate their transitions -- taking the new time into account.
 	if (myTimer.checkForNewNucleotide()) {
 
 		eModel->numActiveNT = eModel->simOptions->initialActiveNT + myTimer.nuclAdded;
@@ -482,7 +837,7 @@ double SComplexList::doBasicChoice(SimTimer& myTimer) {
 		if (eModel->numActiveNT % 25 == 0) {
 			cout << "Nucleotide count = " << eModel->numActiveNT << "   time = " << myTimer.stime << " sec" << endl;
 		}
-		regenerateMoves();
+		activateNucleotide();
 
 	}
 
@@ -501,6 +856,7 @@ double SComplexList::doJoinChoice(SimTimer& timer) {
 	assert(numOfComplexes > 1);
 
 	JoinCriteria crit;
+	SComplexListEntry *partners[2] = { NULL, NULL };
 
 	// before we do anything, print crit (this is for debugging!)
 	if (utility::debugTraces) {
@@ -508,7 +864,20 @@ double SComplexList::doJoinChoice(SimTimer& timer) {
 		cout << toString();
 	}
 
-	if (!eModel->useArrhenius()) {
+	if (useIndex()) {
+
+		crit = complexIndex.getJoinChoice(timer, partners);
+
+		// the reacting copies leave their species, a species of two copies can pair with itself
+		for (int side = 0; side < 2; side++) {
+
+			if (partners[side]->copies > 1) {
+				partners[side] = materialize(partners[side]);
+				crit.complexes[side] = partners[side]->thisComplex;
+			}
+		}
+
+	} else if (!eModel->useArrhenius()) {
 
 		crit = cycleForJoinChoice(timer);
 
@@ -528,42 +897,63 @@ double SComplexList::doJoinChoice(SimTimer& timer) {
 
 // here we actually perform the complex join, using criteria as input.
 
-	SComplexListEntry *temp2 = NULL;
+	SComplexListEntry *joined = partners[0], *removed = partners[1];
 	StrandComplex *deleted;
 
 	deleted = StrandComplex::performComplexJoin(crit, eModel->useArrhenius());
-	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-		if (temp->thisComplex == crit.complexes[0]) {
-			temp->fillData(eModel);
-		}
+	if (joined == NULL) {
 
-		if (temp->next != NULL) {
+		for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-			if (temp->next->thisComplex == deleted) {
-				temp2 = temp->next;
-				temp->next = temp2->next;
-				temp2->next = NULL;
-				delete temp2;
+			if (temp->thisComplex == crit.complexes[0]) {
+				joined = temp;
 			}
 
-		}
+			if (temp->thisComplex == deleted) {
+				removed = temp;
+			}
 
+		}
 	}
 
-	if (first->thisComplex == deleted) {
-		temp2 = first;
-		first = first->next;
-		temp2->next = NULL;
-		delete temp2;
+	assert(removed->thisComplex == deleted);
+	unlink(removed);
+
+	// the absorbed complex leaves the bookkeeping before the joined one is refreshed.
+	removeExposed(removed);
+	complexIndex.remove(removed);
+	uniFlux -= removed->rate;
+
+	updateRate(joined);
+	refreshExposed(joined);
+	joined->exported = false;
+
+	removed->next = NULL;
+	delete removed;
 
-	}
 	numOfComplexes--;
 
 	return crit.arrType;
 
 }
 
+void SComplexList::unlink(SComplexListEntry *entry) {
+
+	if (entry->prev == NULL) {
+		first = entry->next;
+	} else {
+		entry->prev->next = entry->next;
+	}
+
+	if (entry->next != NULL) {
+		entry->next->prev = entry->prev;
+	}
+
+	entry->prev = NULL;
+
+}
+
 JoinCriteria SComplexList::cycleForJoinChoice(SimTimer& timer) {
 
 	int choice = timer.checkHitBi(eModel->applyPrefactors(eModel->getJoinRate(), loopMove, loopMove));
@@ -640,65 +1030,73 @@ JoinCriteria SComplexList::cycleForJoinChoiceArr(SimTimer& timer) {
 
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-		OpenInfo& external = temp->thisComplex->ordering->getOpenInfo();
+		OpenInfo& external = temp->thisComplex->getOpenInfo();
 
 		baseSum.decrement(external);
 
 		if (baseSum.numExposed > 0) {
 
-			for (std::pair<HalfContext, BaseCount> con : baseSum.tally) {
+			// the half contexts of the other complexes, then of this one, in order
+			for (QuartContext a : { endC, strandC, stackC }) {
+				for (QuartContext b : { endC, strandC, stackC }) {
+
+					BaseCount& conCount = baseSum.tally[a][b];
+
+					for (QuartContext c : { endC, strandC, stackC }) {
+						for (QuartContext d : { endC, strandC, stackC }) {
 
-				for (std::pair<HalfContext, BaseCount> ton : external.tally) {
+							BaseCount& tonCount = external.tally[c][d];
 
-					int combinations = con.second.multiCount(ton.second);
+							int combinations = conCount.multiCount(tonCount);
 
-					if (combinations > 0) {
+							if (combinations > 0) {
 
-						MoveType left = moveutil::combineBi(con.first.left, ton.first.right);
-						MoveType right = moveutil::combineBi(con.first.right, ton.first.left);
+								double joinRate = eModel->joinRateFor(a, b, c, d);
 
-						double joinRate = eModel->applyPrefactors(eModel->getJoinRate(), left, right);
+								double rate = joinRate * combinations;
 
-						double rate = joinRate * combinations;
+								if (timer.wouldBeHit(rate)) {
 
-						if (timer.wouldBeHit(rate)) {
+									// we have determined the HalfContexts for the upper and lower strand.
+									int choice_int = timer.checkHitBi(joinRate);
 
-							// we have determined the HalfContexts for the upper and lower strand.
-							int choice_int = timer.checkHitBi(joinRate);
+									HalfContext con = HalfContext(a, b);
 
-							for (BaseType base : { baseA, baseT, baseG, baseC }) {
+									for (BaseType base : { baseA, baseT, baseG, baseC }) {
 
-								int combinations = con.second.count[base] * ton.second.count[5 - base];
+										int combinations = conCount.count[base] * tonCount.count[5 - base];
 
-								if (choice_int < combinations) {
+										if (choice_int < combinations) {
 
-									// return the joining criteria;
+											// return the joining criteria;
 
-									JoinCriteria crit = findJoinNucleotides(base, choice_int, ton.second, temp, &con.first);
+											JoinCriteria crit = findJoinNucleotides(base, choice_int, tonCount, temp, &con);
 
-									crit.half[0] = ton.first;
-									crit.half[1] = con.first;
+											crit.half[0] = HalfContext(c, d);
+											crit.half[1] = con;
 
-									crit.arrType = (double) moveutil::getPrimeCode(left, right);
+											crit.arrType = (double) moveutil::getPrimeCode(moveutil::combineBi(a, d), moveutil::combineBi(b, c));
 
-									return crit;
+											return crit;
+
+										} else {
+											choice_int -= combinations;
+										}
+
+									}
 
 								} else {
-									choice_int -= combinations;
-								}
 
-							}
+									timer.checkHit(rate);
 
-						} else {
+								}
 
-							timer.checkHit(rate);
+							}
 
 						}
-
 					}
 
 				}
-
 			}
 
 		}
@@ -728,6 +1126,26 @@ bool SComplexList::checkStopComplexList(class complexItem *stoplist) {
 
 }
 
+void SComplexList::trackStopConditions(StopConditions *stops) {
+
+	// without a tracker, every condition is compared as a string
+	if (!eModel->simOptions->stopTracking)
+		return;
+
+	std::vector<StrandOrdering*> orderings;
+
+	// the strands of an entry with copies appear more than once, and are not tracked
+	for (SComplexListEntry *temp = first; temp != NULL; temp = temp->next)
+		for (int copy = 0; copy < temp->copies; copy++)
+			orderings.push_back(temp->thisComplex->ordering);
+
+	if (stopTracker != NULL)
+		delete stopTracker;
+
+	stopTracker = new StopTracker(stops, orderings);
+
+}
+
 string SComplexList::toString() {
 
 	string output = "";
@@ -791,9 +1209,7 @@ bool SComplexList::checkStopComplexList_Bound(class complexItem *stoplist) {
 bool SComplexList::checkStopComplexList_Structure_Disassoc(class complexItem *stoplist) {
 	class SComplexListEntry *entry_traverse = first;
 	class complexItem *traverse = stoplist;
-	int id_count = 0;
 	bool successflag = false;
-	class identList *id_traverse = stoplist->strand_ids;
 
 	// We are checking each entry in the list of stop complexes, verifying that it exists within our list of complexes.
 	// So the outer iteration is over the stop complexes, and the inner iteration is over the complexes existant in our system.
@@ -803,22 +1219,19 @@ bool SComplexList::checkStopComplexList_Structure_Disassoc(class complexItem *st
 	traverse = stoplist;
 	while (traverse != NULL) {
 
-		// count how many strands are in the stop complex. This gets used as a fast check later.
-		id_count = 0;
-		id_traverse = traverse->strand_ids;
-
-		while (id_traverse != NULL) {
-			id_count++;
-			id_traverse = id_traverse->next;
-		}
-
 		entry_traverse = first;
 		successflag = false;
 		while (entry_traverse != NULL && successflag == 0) {
 			// iterate check for current stop complex (traverse) in our list of system complexes (entry_traverse)
-			if (entry_traverse->thisComplex->checkIDList(traverse->strand_ids, id_count) > 0) {
+			if (entry_traverse->thisComplex->checkIDList(traverse->strand_ids, traverse->id_count) > 0) {
 				// if the system complex being checked has the correct circular permutation of strand ids, continue with our checks, otherwise it doesn't match.
-				if (traverse->type == STOPTYPE_STRUCTURE) {
+				if (stopTracker != NULL && stopTracker->isTracked(traverse)) {
+					// the strands are in the right order, compare the pairing kept up to date by the tracker
+					if (traverse->type == STOPTYPE_STRUCTURE)
+						successflag = (stopTracker->getDistance(traverse) == 0);
+					else
+						successflag = (stopTracker->getDistance(traverse) <= traverse->count);
+				} else if (traverse->type == STOPTYPE_STRUCTURE) {
 					if (strcmp(entry_traverse->thisComplex->getStructure().c_str(), traverse->structure) == 0) {
 						// if the structures match exactly, we have a successful match.
 						successflag = true;
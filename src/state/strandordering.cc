@@ -15,6 +15,8 @@
 #include <assert.h>
 #include <iostream>
 #include <utility.h>
+#include "stopconditions.h"
+#include "trajectorywriter.h"
 
 using std::cout;
 
@@ -100,6 +102,34 @@ StrandOrdering::StrandOrdering(orderingList *beginning, orderingList *ending, in
 
 }
 
+StrandOrdering *StrandOrdering::copy(LoopCopier& copier) {
+
+	orderingList *head = NULL, *tail = NULL;
+
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next) {
+
+		orderingList *strand = new orderingList(traverse->size, traverse->uid, traverse->thisTag, traverse->thisSeq, traverse->thisCodeSeq, traverse->thisStruct);
+		copier.addStrand(traverse->thisCodeSeq, strand->thisCodeSeq, traverse->size);
+
+		strand->prev = tail;
+		if (tail == NULL)
+			head = strand;
+		else
+			tail->next = strand;
+		tail = strand;
+	}
+
+	StrandOrdering *result = new StrandOrdering(head, tail, count);
+
+	result->seq = seq;
+	result->struc = struc;
+	result->exteriorBases = exteriorBases;
+	result->openInfo = openInfo;
+
+	return result;
+
+}
+
 // Note that in_cseq is the code sequence (ie, not printable) and in_seq is the printable version.
 StrandOrdering::StrandOrdering(char *in_seq, char *in_structure, char *in_cseq) {
 	char def_tag[] = "default";
@@ -461,6 +491,24 @@ char* StrandOrdering::convertIndex(int index) {
 	return NULL;
 }
 
+// The index of a base of the code sequences in the flat sequence, '+' separators included.
+int StrandOrdering::flatIndex(char *base) {
+
+	int cpos, cstrand;
+	orderingList *traverse;
+
+	for (cpos = 0, cstrand = 0, traverse = first; cstrand < count; cstrand++, traverse = traverse->next) {
+
+		if (base >= traverse->thisCodeSeq && base < traverse->thisCodeSeq + traverse->size)
+			return cpos + (base - traverse->thisCodeSeq);
+
+		cpos += traverse->size + 1;
+	}
+
+	assert(0);
+	return -1;
+}
+
 // FD: repeat the computation and flag if the index is out of bounds.
 bool StrandOrdering::convertIndexCheckBounds(int index) {
 
@@ -528,7 +576,7 @@ OpenLoop* StrandOrdering::getIndex(JoinCriteria& crit, int site, char **location
 
 			assert(traverse->thisLoop != NULL);
 
-			map<HalfContext, BaseCount>& myTally = traverse->thisLoop->getOpenInfo().tally;
+			ContextTally& myTally = traverse->thisLoop->getOpenInfo().tally;
 
 //			if (!myTally.count(crit.half[site])) {
 //
@@ -570,27 +618,23 @@ OpenLoop* StrandOrdering::getIndex(JoinCriteria& crit, int site, char **location
 //
 //			}
 
-			if (myTally.count(crit.half[site])) { // FD: there is at least one of the correct type in this openLoop
-
-				BaseCount& baseCount = myTally.find(crit.half[site])->second;
-
-				if (*index < baseCount.count[type]) {
+			BaseCount& baseCount = myTally[crit.half[site].left][crit.half[site].right];
 
-					if (utility::debugTraces) {
+			if (*index < baseCount.count[type]) { // FD: there is at least one of the correct type in this openLoop
 
-						cout << traverse->thisLoop->toString() << endl;
+				if (utility::debugTraces) {
 
-					}
+					cout << traverse->thisLoop->toString() << endl;
 
-					*location = traverse->thisLoop->getBase(type, *index, crit.half[site]);
+				}
 
-					return traverse->thisLoop;
+				*location = traverse->thisLoop->getBase(type, *index, crit.half[site]);
 
-				} else {
+				return traverse->thisLoop;
 
-					*index = *index - baseCount.count[type];
+			} else {
 
-				}
+				*index = *index - baseCount.count[type];
 
 			}
 
@@ -772,7 +816,7 @@ void StrandOrdering::replaceOpenLoop(Loop *oldLoop, Loop *newLoop) {
 
 	orderingList *traverse = NULL;
 	for (traverse = first; traverse != NULL; traverse = traverse->next) {
-		if (traverse->thisLoop == (OpenLoop *) oldLoop) {
+		if (traverse->thisLoop == oldLoop) {
 			traverse->thisLoop = (OpenLoop *) newLoop;
 			return;
 		}
@@ -853,28 +897,34 @@ void StrandOrdering::addBasepair(char *first_bp, char *second_bp) {
 	char *id[2] = { NULL, NULL };
 	char *temp;
 	orderingList *traverse = NULL;
+	orderingList *strand[2] = { NULL, NULL };
 	int iflag = 0;
 
 	openInfo.upToDate = false;
 
 	for (traverse = first; traverse != NULL; traverse = traverse->next, iflag = 0) {
 		if (((first_bp - traverse->thisCodeSeq) < traverse->size) && ((first_bp - traverse->thisCodeSeq) >= 0)) {
-			if (id[0] == NULL)
+			if (id[0] == NULL) {
 				id[0] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
-			else
+				strand[0] = traverse;
+			} else {
 				id[1] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
+				strand[1] = traverse;
+			}
 			iflag = 1;
 		}
 		if (((second_bp - traverse->thisCodeSeq) < traverse->size) && ((second_bp - traverse->thisCodeSeq) >= 0)) {
-			if (id[0] == NULL)
+			if (id[0] == NULL) {
 				id[0] = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
-			else {
+				strand[0] = traverse;
+			} else {
 				temp = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
 				if (iflag == 1 && (temp < id[0])) {
 					id[1] = id[0];
 					id[0] = temp;
 				} else
 					id[1] = temp;
+				strand[1] = traverse;
 			}
 		}
 	}
@@ -882,6 +932,12 @@ void StrandOrdering::addBasepair(char *first_bp, char *second_bp) {
 	*id[0] = '(';
 	*id[1] = ')';
 
+	if (strand[0]->stopTracker != NULL)
+		strand[0]->stopTracker->pairChanged(strand[0], id[0] - strand[0]->thisStruct, strand[1], id[1] - strand[1]->thisStruct, true);
+
+	if (strand[0]->trajectoryWriter != NULL)
+		strand[0]->trajectoryWriter->pairChanged(this, flatIndex(first_bp), flatIndex(second_bp), true);
+
 	seq.clear();
 	struc.clear();
 
@@ -894,31 +950,38 @@ void StrandOrdering::breakBasepair(char *first_bp, char *second_bp) {
 	char *id[2] = { NULL, NULL };
 	char *temp = NULL;
 	orderingList *traverse = NULL;
+	orderingList *strand[2] = { NULL, NULL };
 	int iflag = 0;
 
 	openInfo.upToDate = false;
 
 	for (traverse = first; traverse != NULL; traverse = traverse->next, iflag = 0) {
 
-		traverse->thisLoop->openInfo.upToDate = false;
+		if (traverse->thisLoop != NULL)
+			traverse->thisLoop->openInfo.upToDate = false;
 
 		if (((first_bp - traverse->thisCodeSeq) < traverse->size) && ((first_bp - traverse->thisCodeSeq) >= 0)) {
-			if (id[0] == NULL)
+			if (id[0] == NULL) {
 				id[0] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
-			else
+				strand[0] = traverse;
+			} else {
 				id[1] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
+				strand[1] = traverse;
+			}
 			iflag = 1;
 		}
 		if (((second_bp - traverse->thisCodeSeq) < traverse->size) && ((second_bp - traverse->thisCodeSeq) >= 0)) {
-			if (id[0] == NULL)
+			if (id[0] == NULL) {
 				id[0] = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
-			else {
+				strand[0] = traverse;
+			} else {
 				temp = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
 				if (iflag == 1 && (temp < id[0])) {
 					id[1] = id[0];
 					id[0] = temp;
 				} else
 					id[1] = temp;
+				strand[1] = traverse;
 			}
 		}
 	}
@@ -928,6 +991,12 @@ void StrandOrdering::breakBasepair(char *first_bp, char *second_bp) {
 	*id[0] = '.';
 	*id[1] = '.';
 
+	if (strand[0]->stopTracker != NULL)
+		strand[0]->stopTracker->pairChanged(strand[0], id[0] - strand[0]->thisStruct, strand[1], id[1] - strand[1]->thisStruct, false);
+
+	if (strand[0]->trajectoryWriter != NULL)
+		strand[0]->trajectoryWriter->pairChanged(this, flatIndex(first_bp), flatIndex(second_bp), false);
+
 	seq.clear();
 	struc.clear();
 
@@ -221,6 +221,13 @@ PEnergyOptions::PEnergyOptions(PyObject* input) :
 
 	}
 
+	PyObject *snapshots = PyObject_GetAttrString(python_settings, "parameter_snapshot_dir");
+
+	if (snapshots != Py_None)
+		snapshotDirectory = PyUnicode_AsUTF8(snapshots);
+
+	Py_DECREF(snapshots);
+
 }
 
 bool PEnergyOptions::compareSubstrateType(long type) {
@@ -0,0 +1,549 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+#include <passagetime.h>
+
+#include <math.h>
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+// a product with the matrix is split over the threads only above this many entries per thread
+static const long PARALLEL_ENTRIES = 1 << 15;
+
+PassageTimeSolver::PassageTimeSolver(int threads) :
+		threads(std::max(threads, 1)) {
+
+}
+
+long PassageTimeSolver::rowCount(void) {
+
+	return stateOf.size();
+
+}
+
+long PassageTimeSolver::entryCount(void) {
+
+	return column.size();
+
+}
+
+// The rate from the first state of the transition into the second, and back.
+static void transitionRates(const PassageRates& c, double dG1, double dG2, int kind, int left, int right, double& forward, double& backward) {
+
+	double bimolecular = c.biScale * c.concentration;
+
+	if (!c.arrhenius) {
+
+		if (kind == PASSAGE_UNIMOLECULAR) {
+
+			if (dG1 > dG2) {
+				forward = c.uniScale;
+				backward = c.uniScale * exp(-(dG1 - dG2) / c.RT);
+			} else {
+				forward = c.uniScale * exp((dG1 - dG2) / c.RT);
+				backward = c.uniScale;
+			}
+
+		} else if (kind == PASSAGE_BIMOLECULAR_IN) {
+
+			forward = bimolecular;
+			backward = c.biScale * exp(-(dG1 - dG2) / c.RT);
+
+		} else {
+
+			forward = c.biScale * exp((dG1 - dG2) / c.RT);
+			backward = bimolecular;
+
+		}
+
+		return;
+
+	}
+
+	double lnA = c.lnA[left] + c.lnA[right];
+	double E = c.E[left] + c.E[right];
+	double dG = dG2 - dG1;
+
+	if (kind == PASSAGE_UNIMOLECULAR) {
+
+		if (dG > 0.0) {
+			forward = exp(lnA - (dG + E) / c.RT);
+			backward = exp(lnA - E / c.RT);
+		} else {
+			forward = exp(lnA - E / c.RT);
+			backward = exp(lnA - (-dG + E) / c.RT);
+		}
+
+	} else if (kind == PASSAGE_BIMOLECULAR_IN) {
+
+		forward = bimolecular * exp(lnA - E / c.RT);
+		backward = c.biScale * exp(lnA - (-dG + E) / c.RT);
+
+	} else {
+
+		forward = c.biScale * exp(lnA - (dG + E) / c.RT);
+		backward = bimolecular * exp(lnA - E / c.RT);
+
+	}
+
+}
+
+// The rate leaves the diagonal of a state that is not final, and is a transition if the target is not final either.
+void PassageTimeSolver::addRate(long from, long to, double rate) {
+
+	if (row[from] < 0)
+		return;
+
+	diagonal[row[from]] -= rate;
+
+	if (row[to] >= 0) {
+		entryRow.push_back(row[from]);
+		entryColumn.push_back(row[to]);
+		entryValue.push_back(rate);
+	}
+
+}
+
+void PassageTimeSolver::build(const PassageRates& rates, long stateCount, const double *energy, const uint8_t *final, long transitionCount,
+		const uint32_t *source, const uint32_t *target, const int8_t *kind, const int8_t *left, const int8_t *right) {
+
+	row.assign(stateCount, -1);
+	stateOf.clear();
+
+	for (long state = 0; state < stateCount; state++) {
+
+		if (!final[state]) {
+			row[state] = stateOf.size();
+			stateOf.push_back(state);
+		}
+
+	}
+
+	long n = stateOf.size();
+
+	diagonal.assign(n, 0.0);
+	entryRow.clear();
+	entryColumn.clear();
+	entryValue.clear();
+
+	for (long i = 0; i < transitionCount; i++) {
+
+		double forward, backward;
+		transitionRates(rates, energy[source[i]], energy[target[i]], kind[i], left[i], right[i], forward, backward);
+
+		if (forward > rates.rateLimit)
+			addRate(source[i], target[i], forward);
+		if (backward > rates.rateLimit)
+			addRate(target[i], source[i], backward);
+
+	}
+
+	// sort the entries by row, then order and merge the columns of every row
+	for (long i = 0; i < n; i++) {
+		entryRow.push_back(i);
+		entryColumn.push_back(i);
+		entryValue.push_back(diagonal[i]);
+	}
+
+	rowStart.assign(n + 1, 0);
+
+	for (long r : entryRow)
+		rowStart[r + 1]++;
+
+	for (long i = 0; i < n; i++)
+		rowStart[i + 1] += rowStart[i];
+
+	vector<long> next(rowStart.begin(), rowStart.end() - 1);
+	vector<std::pair<long, double>> entries(entryRow.size());
+
+	for (size_t k = 0; k < entryRow.size(); k++)
+		entries[next[entryRow[k]]++] = std::make_pair(entryColumn[k], entryValue[k]);
+
+	column.clear();
+	value.clear();
+	diagonalAt.assign(n, -1);
+
+	for (long i = 0; i < n; i++) {
+
+		auto begin = entries.begin() + rowStart[i];
+		auto end = entries.begin() + rowStart[i + 1];
+
+		std::sort(begin, end, [](const std::pair<long, double>& a, const std::pair<long, double>& b) {return a.first < b.first;});
+
+		rowStart[i] = column.size();
+
+		for (auto entry = begin; entry != end; entry++) {
+
+			if ((long) column.size() > rowStart[i] && column.back() == entry->first) {
+				value.back() += entry->second;
+			} else {
+				column.push_back(entry->first);
+				value.push_back(entry->second);
+			}
+
+			if (entry->first == i)
+				diagonalAt[i] = column.size() - 1;
+
+		}
+
+	}
+
+	rowStart[n] = column.size();
+
+	entryRow = vector<long>();
+	entryColumn = vector<long>();
+	entryValue = vector<double>();
+	diagonal = vector<double>();
+
+}
+
+void PassageTimeSolver::multiply(const double *x, double *y) {
+
+	long n = rowCount();
+
+	auto rows = [&](long begin, long end) {
+
+		for (long i = begin; i < end; i++) {
+
+			double sum = 0.0;
+
+			for (long p = rowStart[i]; p < rowStart[i + 1]; p++)
+				sum += value[p] * x[column[p]];
+
+			y[i] = sum;
+
+		}
+
+	};
+
+	int workers = std::min((long) threads, entryCount() / PARALLEL_ENTRIES);
+
+	if (workers <= 1) {
+		rows(0, n);
+		return;
+	}
+
+	// every worker takes an equal share of the entries
+	vector<std::thread> pool;
+	long begin = 0;
+
+	for (int w = 1; w <= workers; w++) {
+
+		long end = (w == workers) ? n : std::upper_bound(rowStart.begin(), rowStart.end(), entryCount() * w / workers) - rowStart.begin() - 1;
+
+		end = std::max(end, begin);
+		pool.emplace_back(rows, begin, end);
+		begin = end;
+
+	}
+
+	for (std::thread& worker : pool)
+		worker.join();
+
+}
+
+// ILU(0): the factors keep the pattern of the matrix, L has a unit diagonal.
+void PassageTimeSolver::factorize(void) {
+
+	long n = rowCount();
+
+	factor = value;
+	vector<long> position(n, -1);
+
+	for (long i = 0; i < n; i++) {
+
+		for (long p = rowStart[i]; p < rowStart[i + 1]; p++)
+			position[column[p]] = p;
+
+		for (long p = rowStart[i]; p < diagonalAt[i]; p++) {
+
+			long k = column[p];
+			factor[p] /= factor[diagonalAt[k]];
+
+			for (long q = diagonalAt[k] + 1; q < rowStart[k + 1]; q++) {
+				if (position[column[q]] >= 0)
+					factor[position[column[q]]] -= factor[p] * factor[q];
+			}
+
+		}
+
+		// a state without transitions out
+		if (factor[diagonalAt[i]] == 0.0)
+			factor[diagonalAt[i]] = 1.0;
+
+		for (long p = rowStart[i]; p < rowStart[i + 1]; p++)
+			position[column[p]] = -1;
+
+	}
+
+}
+
+void PassageTimeSolver::precondition(const double *r, double *z) {
+
+	long n = rowCount();
+
+	if (preconditioner == PASSAGE_JACOBI) {
+
+		for (long i = 0; i < n; i++)
+			z[i] = r[i] * inverseDiagonal[i];
+
+		return;
+
+	}
+
+	for (long i = 0; i < n; i++) {
+
+		double sum = r[i];
+
+		for (long p = rowStart[i]; p < diagonalAt[i]; p++)
+			sum -= factor[p] * z[column[p]];
+
+		z[i] = sum;
+
+	}
+
+	for (long i = n - 1; i >= 0; i--) {
+
+		double sum = z[i];
+
+		for (long p = diagonalAt[i] + 1; p < rowStart[i + 1]; p++)
+			sum -= factor[p] * z[column[p]];
+
+		z[i] = sum / factor[diagonalAt[i]];
+
+	}
+
+}
+
+double PassageTimeSolver::dot(const double *x, const double *y) {
+
+	double sum = 0.0;
+
+	for (long i = 0; i < rowCount(); i++)
+		sum += x[i] * y[i];
+
+	return sum;
+
+}
+
+double PassageTimeSolver::norm(const double *x) {
+
+	return sqrt(dot(x, x));
+
+}
+
+bool PassageTimeSolver::solve(int method, int preconditioner, double tolerance, long maxIterations, double *times) {
+
+	long n = rowCount();
+
+	this->preconditioner = preconditioner;
+	iterations = 0;
+	residual = 0.0;
+
+	if (preconditioner == PASSAGE_ILU0) {
+
+		factorize();
+
+	} else {
+
+		inverseDiagonal.resize(n);
+
+		for (long i = 0; i < n; i++)
+			inverseDiagonal[i] = (value[diagonalAt[i]] == 0.0) ? 1.0 : 1.0 / value[diagonalAt[i]];
+
+	}
+
+	if (maxIterations <= 0)
+		maxIterations = std::max(10 * n, 1000L);
+
+	vector<double> x(n, 0.0);
+	bool converged = (n == 0) || ((method == PASSAGE_GMRES) ? solveGMRES(tolerance, maxIterations, x.data()) : solveBiCGStab(tolerance, maxIterations, x.data()));
+
+	for (long state = 0; state < (long) row.size(); state++)
+		times[state] = (row[state] < 0) ? 0.0 : x[row[state]];
+
+	factor = vector<double>();
+	inverseDiagonal = vector<double>();
+
+	return converged;
+
+}
+
+// Right preconditioned BiCGSTAB for Q x = -1, from x = 0.
+bool PassageTimeSolver::solveBiCGStab(double tolerance, long maxIterations, double *x) {
+
+	long n = rowCount();
+
+	vector<double> r(n, -1.0), rhat(n, -1.0), p(n, 0.0), v(n, 0.0), s(n), t(n), phat(n), shat(n);
+
+	double bnorm = norm(r.data());
+	double rho = 1.0, alpha = 1.0, omega = 1.0;
+
+	while (iterations < maxIterations) {
+
+		iterations++;
+
+		double rhoNext = dot(rhat.data(), r.data());
+
+		if (rhoNext == 0.0)
+			break;
+
+		double beta = (rhoNext / rho) * (alpha / omega);
+
+		for (long i = 0; i < n; i++)
+			p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+		precondition(p.data(), phat.data());
+		multiply(phat.data(), v.data());
+		alpha = rhoNext / dot(rhat.data(), v.data());
+
+		for (long i = 0; i < n; i++)
+			s[i] = r[i] - alpha * v[i];
+
+		residual = norm(s.data()) / bnorm;
+
+		if (residual < tolerance) {
+
+			for (long i = 0; i < n; i++)
+				x[i] += alpha * phat[i];
+
+			return true;
+
+		}
+
+		precondition(s.data(), shat.data());
+		multiply(shat.data(), t.data());
+		omega = dot(t.data(), s.data()) / dot(t.data(), t.data());
+
+		for (long i = 0; i < n; i++) {
+			x[i] += alpha * phat[i] + omega * shat[i];
+			r[i] = s[i] - omega * t[i];
+		}
+
+		residual = norm(r.data()) / bnorm;
+
+		if (residual < tolerance)
+			return true;
+
+		if (omega == 0.0)
+			break;
+
+		rho = rhoNext;
+
+	}
+
+	return false;
+
+}
+
+// Right preconditioned GMRES, restarted every PASSAGE_GMRES_RESTART iterations.
+bool PassageTimeSolver::solveGMRES(double tolerance, long maxIterations, double *x) {
+
+	const int m = PASSAGE_GMRES_RESTART;
+	long n = rowCount();
+
+	vector<double> basis((m + 1) * n), preconditioned(m * n), H((m + 1) * m), cs(m), sn(m), g(m + 1), y(m), w(n);
+
+	double bnorm = sqrt((double) n);
+
+	while (iterations < maxIterations) {
+
+		// the residual of -1
+		multiply(x, w.data());
+
+		for (long i = 0; i < n; i++)
+			w[i] = -1.0 - w[i];
+
+		double beta = norm(w.data());
+		residual = beta / bnorm;
+
+		if (residual < tolerance)
+			return true;
+
+		for (long i = 0; i < n; i++)
+			basis[i] = w[i] / beta;
+
+		std::fill(g.begin(), g.end(), 0.0);
+		g[0] = beta;
+
+		int k = 0;
+
+		while (k < m && iterations < maxIterations) {
+
+			iterations++;
+
+			double *z = &preconditioned[k * n];
+			precondition(&basis[k * n], z);
+			multiply(z, w.data());
+
+			for (int j = 0; j <= k; j++) {
+
+				double h = dot(w.data(), &basis[j * n]);
+				H[j * m + k] = h;
+
+				for (long i = 0; i < n; i++)
+					w[i] -= h * basis[j * n + i];
+
+			}
+
+			double h = norm(w.data());
+			H[(k + 1) * m + k] = h;
+
+			if (h != 0.0) {
+				for (long i = 0; i < n; i++)
+					basis[(k + 1) * n + i] = w[i] / h;
+			}
+
+			for (int j = 0; j < k; j++) {
+
+				double upper = H[j * m + k], lower = H[(j + 1) * m + k];
+				H[j * m + k] = cs[j] * upper + sn[j] * lower;
+				H[(j + 1) * m + k] = -sn[j] * upper + cs[j] * lower;
+
+			}
+
+			double denominator = hypot(H[k * m + k], H[(k + 1) * m + k]);
+			cs[k] = H[k * m + k] / denominator;
+			sn[k] = H[(k + 1) * m + k] / denominator;
+			H[k * m + k] = denominator;
+			H[(k + 1) * m + k] = 0.0;
+
+			g[k + 1] = -sn[k] * g[k];
+			g[k] = cs[k] * g[k];
+
+			residual = fabs(g[k + 1]) / bnorm;
+			k++;
+
+			if (residual < tolerance || h == 0.0)
+				break;
+
+		}
+
+		for (int j = k - 1; j >= 0; j--) {
+
+			double sum = g[j];
+
+			for (int l = j + 1; l < k; l++)
+				sum -= H[j * m + l] * y[l];
+
+			y[j] = sum / H[j * m + j];
+
+		}
+
+		for (int j = 0; j < k; j++) {
+			for (long i = 0; i < n; i++)
+				x[i] += y[j] * preconditioned[j * n + i];
+		}
+
+		if (residual < tolerance)
+			return true;
+
+	}
+
+	return false;
+
+}
@@ -0,0 +1,53 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+#include "resultsink.h"
+
+void ResultSink::add(long seed, int type, double time, double rate, const char *tag) {
+
+	string name(tag);
+	std::map<string, int32_t>::iterator it = tagIndex.find(name);
+
+	if (it == tagIndex.end()) {
+		it = tagIndex.insert(std::make_pair(name, (int32_t) tagNames.size())).first;
+		tagNames.push_back(name);
+	}
+
+	seeds.push_back(seed);
+	types.push_back(type);
+	times.push_back(time);
+	rates.push_back(rate);
+	tags.push_back(it->second);
+
+}
+
+long ResultSink::size(void) {
+
+	return seeds.size();
+
+}
+
+template<class T>
+static PyObject* toBytes(vector<T>& column) {
+
+	PyObject *bytes = PyBytes_FromStringAndSize((const char*) column.data(), column.size() * sizeof(T));
+	column.clear();
+
+	return bytes;
+
+}
+
+PyObject* ResultSink::take(void) {
+
+	// the tag table is kept, so later chunks use the same indices
+	PyObject *names = PyList_New(tagNames.size());
+	for (size_t i = 0; i < tagNames.size(); i++) {
+		PyList_SET_ITEM(names, i, PyUnicode_FromString(tagNames[i].c_str()));
+	}
+
+	return Py_BuildValue("(NNNNNN)", toBytes(seeds), toBytes(types), toBytes(times), toBytes(rates), toBytes(tags), names);
+
+}
@@ -0,0 +1,146 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the random generators found in rng.h
+#include <math.h>
+#include "rng.h"
+
+const double RNG_DOUBLE_UNIT = 1.0 / 9007199254740992.0; // 2^-53
+
+static inline uint64_t splitmix64(uint64_t& x) {
+
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+
+}
+
+static inline uint64_t rotl(const uint64_t x, int k) {
+
+	return (x << k) | (x >> (64 - k));
+
+}
+
+RandomGenerator::RandomGenerator(void) {
+
+	reset();
+
+}
+
+RandomGenerator::~RandomGenerator(void) {
+
+}
+
+void RandomGenerator::reset(void) {
+
+	uniformPos = RNG_BLOCK_SIZE;
+	exponentialPos = RNG_BLOCK_SIZE;
+
+}
+
+void RandomGenerator::fillBlock(uint64_t *output, int size) {
+
+	for (int i = 0; i < size; i++)
+		output[i] = next();
+
+}
+
+// the top 53 bits give a double on [0,1)
+void RandomGenerator::fillUniform(void) {
+
+	uint64_t raw[RNG_BLOCK_SIZE];
+	fillBlock(raw, RNG_BLOCK_SIZE);
+
+	for (int i = 0; i < RNG_BLOCK_SIZE; i++)
+		uniforms[i] = (raw[i] >> 11) * RNG_DOUBLE_UNIT;
+
+	uniformPos = 0;
+
+}
+
+void RandomGenerator::fillExponential(void) {
+
+	uint64_t raw[RNG_BLOCK_SIZE];
+	fillBlock(raw, RNG_BLOCK_SIZE);
+
+	for (int i = 0; i < RNG_BLOCK_SIZE; i++)
+		exponentials[i] = -log(1.0 - (raw[i] >> 11) * RNG_DOUBLE_UNIT);
+
+	exponentialPos = 0;
+
+}
+
+Xoshiro256::Xoshiro256(void) {
+
+	seed(0);
+
+}
+
+void Xoshiro256::seed(uint64_t newSeed) {
+
+	uint64_t x = newSeed;
+
+	for (int i = 0; i < 4; i++)
+		state[i] = splitmix64(x);
+
+	reset();
+
+}
+
+uint64_t Xoshiro256::next(void) {
+
+	const uint64_t result = rotl(state[1] * 5, 7) * 9;
+	const uint64_t t = state[1] << 17;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 45);
+
+	return result;
+
+}
+
+// same as the base class, but without a virtual call per draw
+void Xoshiro256::fillBlock(uint64_t *output, int size) {
+
+	uint64_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+
+	for (int i = 0; i < size; i++) {
+
+		output[i] = rotl(s1 * 5, 7) * 9;
+		const uint64_t t = s1 << 17;
+
+		s2 ^= s0;
+		s3 ^= s1;
+		s1 ^= s2;
+		s0 ^= s3;
+		s2 ^= t;
+		s3 = rotl(s3, 45);
+	}
+
+	state[0] = s0;
+	state[1] = s1;
+	state[2] = s2;
+	state[3] = s3;
+
+}
+
+// Counter based: a hash of (seed, index), so any trajectory's seed is known without running
+// the ones before it. Seeds are kept positive, they are reported back to Python.
+long trajectorySeed(long seed, long index) {
+
+	if (index == 0)
+		return seed;
+
+	uint64_t x = (uint64_t) seed + (uint64_t) index * 0xD1B54A32D192ED03ULL;
+
+	return (long) (splitmix64(x) >> 1);
+
+}
@@ -51,24 +51,30 @@ std::ostream& operator<<(std::ostream& ss, BaseCount& input) {
 
 void BaseCount::clear(void) {
 
-	count = {0,0,0,0,0};
+	count.fill(0);
 
 }
 
-void BaseCount::increment(BaseCount& other) {
+void BaseCount::increment(BaseCount& other, int times) {
 
 	for (int i : { baseA, baseC, baseG, baseT }) {
-		count[i] += other.count[i];
+		count[i] += times * other.count[i];
 	}
 }
 
-void BaseCount::decrement(BaseCount& other) {
+void BaseCount::decrement(BaseCount& other, int times) {
 
 	for (int i : { baseA, baseC, baseG, baseT }) {
-		count[i] -= other.count[i];
+		count[i] -= times * other.count[i];
 	}
 }
 
+bool BaseCount::operator==(const BaseCount& other) const {
+
+	return count == other.count;
+
+}
+
 int BaseCount::multiCount(BaseCount& other) {
 
 	int output = count[baseA] * other.count[baseT];
@@ -15,6 +15,7 @@
 #include "simoptions.h"
 #include "energyoptions.h"
 #include "scomplex.h"
+#include "stopconditions.h"
 
 #include <time.h>
 #include <vector>
@@ -22,6 +23,8 @@
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <math.h>
+#include <assert.h>
 
 using std::vector;
 using std::string;
@@ -34,7 +37,9 @@ SimOptions::SimOptions(void) {
 
 SimOptions::~SimOptions(void) {
 
-// empty deconstructor
+	if (myStopConditions != NULL) {
+		delete myStopConditions;
+	}
 
 }
 
@@ -76,10 +81,35 @@ PSimOptions::PSimOptions(PyObject* input) :
 	getBoolAttr(python_settings, cotranscriptional, &cotranscriptional);
 	getDoubleAttr(python_settings, cotranscriptional_rate, &cotranscriptional_rate);
 
+	getLongAttr(python_settings, move_container, &moveContainer);
+	getBoolAttr(python_settings, stop_tracking, &stopTracking);
+	getLongAttr(python_settings, flux_resum_interval, &fluxResumInterval);
+	getLongAttr(python_settings, state_engine, &stateEngine);
+	getLongAttr(python_settings, energy_cache_size, &energyCacheSize);
+	getLongAttr(python_settings, complex_index_threshold, &complexIndexThreshold);
+	getBoolAttr(python_settings, native_results, &nativeResults);
+	getBoolAttr(python_settings, species_multiplicity, &speciesMultiplicity);
+	getBoolAttr(python_settings, fixed_start_state, &fixedStartState);
+
 	getLongAttr(python_settings, verbosity, &verbosity);
 	getBoolAttr(python_settings, activestatespace, &statespaceActive);
+	getBoolAttr(python_settings, statespace_binary, &statespaceBinary);
 	getDoubleAttr(python_settings, ms_version, &ms_version);
 
+	// Options stores any path as a str, other objects are decoded the same way here.
+	// Anything else leaves a TypeError set, so it is read last.
+	PyObject *trajectory = PyObject_GetAttrString(python_settings, "trajectory_file");
+	PyObject *path = NULL;
+
+	if (trajectory == NULL) {
+		PyErr_Clear();
+	} else if (trajectory != Py_None && PyUnicode_FSDecoder(trajectory, &path)) {
+		trajectoryFile = PyUnicode_AsUTF8(path);
+		Py_DECREF(path);
+	}
+
+	Py_XDECREF(trajectory);
+
 	debug = false;	// this is the main switch for simOptions debug, for now.
 
 }
@@ -96,6 +126,11 @@ string SimOptions::toString() {
 	ss << "stop_count = " << stop_count << " \n";
 	ss << "max_sim_time = " << max_sim_time << " \n";
 	ss << "seed = " << seed << " \n";
+	ss << "move_container = " << moveContainer << " \n";
+	ss << "state_engine = " << stateEngine << " \n";
+	ss << "energy_cache_size = " << energyCacheSize << " \n";
+	ss << "native_results = " << nativeResults << " \n";
+	ss << "trajectory_file = " << trajectoryFile << " \n";
 
 //	ss << "myComplexes = { ";
 //
@@ -286,17 +321,44 @@ void PSimOptions::generateComplexes(PyObject *alternate_start, long current_seed
 	return;
 }
 
-stopComplexes* PSimOptions::getStopComplexes(int) {
+// Only the seed is passed on, Python still records the start structures for it.
+void PSimOptions::reuseComplexes(long current_seed) {
+
+	if (python_settings != NULL) {
+		setLongAttr(python_settings, interface_current_seed, current_seed);
+	}
+	seed = current_seed;
+
+}
+
+StopConditions* PSimOptions::getStopConditions(void) {
+
+	if (myStopConditions == NULL) {
+		// the python list is only valid when it has entries
+		myStopConditions = new StopConditions(stop_count > 0 ? getStopComplexList(python_settings, 0) : NULL);
+	}
+
+	return myStopConditions;
+
+}
+
+void SimOptions::reuseComplexes(long current_seed) {
+
+	seed = current_seed;
+
+}
 
-	myStopComplexes = getStopComplexList(python_settings, 0);
+void SimOptions::flushResults(void) {
 
-	return myStopComplexes;
+// nothing is held by default
 
 }
 
 void PSimOptions::stopResultError(long seed) {
 
-	if (!statespaceActive) {
+	if (nativeResults) {
+		keepResult(seed, STOPRESULT_ERROR, 0.0, NAN, result_type::STR_ERROR.c_str());
+	} else if (!statespaceActive) {
 		printStatusLine(python_settings, seed, STOPRESULT_ERROR, 0.0, result_type::STR_ERROR.c_str());
 	}
 
@@ -304,7 +366,9 @@ void PSimOptions::stopResultError(long seed) {
 
 void PSimOptions::stopResultNan(long seed) {
 
-	if (!statespaceActive) {
+	if (nativeResults) {
+		keepResult(seed, STOPRESULT_NAN, 0.0, NAN, result_type::STR_NAN.c_str());
+	} else if (!statespaceActive) {
 		printStatusLine(python_settings, seed, STOPRESULT_NAN, 0.0, result_type::STR_NAN.c_str());
 	}
 
@@ -312,7 +376,9 @@ void PSimOptions::stopResultNan(long seed) {
 
 void PSimOptions::stopResultNormal(long seed, double time, char* message) {
 
-	if (!statespaceActive) {
+	if (nativeResults) {
+		keepResult(seed, STOPRESULT_NORMAL, time, NAN, message);
+	} else if (!statespaceActive) {
 		printStatusLine(python_settings, seed, STOPRESULT_NORMAL, time, message);
 	}
 
@@ -320,7 +386,9 @@ void PSimOptions::stopResultNormal(long seed, double time, char* message) {
 
 void PSimOptions::stopResultTime(long seed, double time) {
 
-	if (!statespaceActive) {
+	if (nativeResults) {
+		keepResult(seed, STOPRESULT_TIME, time, NAN, result_type::STR_TIMEOUT.c_str());
+	} else if (!statespaceActive) {
 		printStatusLine(python_settings, seed, STOPRESULT_TIME, time, result_type::STR_TIMEOUT.c_str());
 	}
 
@@ -328,11 +396,43 @@ void PSimOptions::stopResultTime(long seed, double time) {
 
 void PSimOptions::stopResultFirstStep(long seed, double stopTime, double rate, const char* message) {
 
-	if (!statespaceActive) {
+	if (nativeResults) {
+		keepResult(seed, STOPRESULT_NORMAL, stopTime, rate, message);
+	} else if (!statespaceActive) {
 		printStatusLine_First_Bimolecular(python_settings, seed, STOPRESULT_NORMAL, stopTime, rate, message);
 	}
 }
 
+// End states are not kept with native results, the point is to stay out of Python.
+void PSimOptions::exportEndState(long seed, ExportData& data) {
+
+	if (!nativeResults) {
+		printComplexStateLine(python_settings, seed, data);
+	}
+
+}
+
+void PSimOptions::keepResult(long seed, int type, double time, double rate, const char* tag) {
+
+	if (statespaceActive)
+		return;
+
+	results.add(seed, type, time, rate, tag);
+
+	if (results.size() >= RESULTSINK_CHUNK) {
+		flushResults();
+	}
+
+}
+
+void PSimOptions::flushResults(void) {
+
+	if (results.size() > 0) {
+		pushResultArrays(python_settings, results.take());
+	}
+
+}
+
 ///// CSIMOPTIONS
 CSimOptions::CSimOptions(void) {
 
@@ -364,7 +464,7 @@ PyObject* CSimOptions::getPythonSettings() {
 
 }
 
-void CSimOptions::generateComplexes(PyObject *alternate_start, long current_seed) {
+void CSimOptions::generateComplexes(PyObject *, long) {
 
 	myComplexes = new vector<complex_input>(0); // wipe the pointer to the previous object;
 
@@ -381,40 +481,169 @@ void CSimOptions::generateComplexes(PyObject *alternate_start, long current_seed
 
 }
 
-stopComplexes* CSimOptions::getStopComplexes(int) {
+StopConditions* CSimOptions::getStopConditions(void) {
 
-	cout << "getStopComplexes, cannot proceed \n";
+	cout << "getStopConditions, cannot proceed \n";
 	abort();
 	return NULL;
 }
 
-void CSimOptions::stopResultError(long seed) {
+void CSimOptions::stopResultError(long) {
 
 	cout << "stopResultError, cannot send to python \n";
 
 }
 
-void CSimOptions::stopResultNan(long seed) {
+void CSimOptions::stopResultNan(long) {
 
 	cout << "stopResultNan, cannot send to python \n";
 
 }
 
-void CSimOptions::stopResultNormal(long seed, double time, char* message) {
+void CSimOptions::stopResultNormal(long, double, char*) {
 
 	cout << "stopResultNormal, cannot send to python \n";
 
 }
 
-void CSimOptions::stopResultTime(long seed, double time) {
+void CSimOptions::stopResultTime(long, double) {
 
 	cout << "stopResultTime, cannot send to python \n";
 
 }
 
-void CSimOptions::stopResultFirstStep(long seed, double stopTime, double rate, const char* message) {
+void CSimOptions::stopResultFirstStep(long, double, double, const char*) {
 
 	cout << "stopResultBimolecular, cannot send to python \n";
 
 }
 
+void CSimOptions::exportEndState(long, ExportData&) {
+
+	cout << "exportEndState, cannot send to python \n";
+
+}
+
+///// TRIALRESULT
+void TrialResult::replay(SimOptions* target) {
+
+	for (ExportData& data : endStates) {
+		target->exportEndState(seed, data);
+	}
+
+	if (firstStep) {
+		target->stopResultFirstStep(seed, time, rate, tag.c_str());
+	} else if (type == STOPRESULT_NORMAL) {
+		target->stopResultNormal(seed, time, (char*) tag.c_str());
+	} else if (type == STOPRESULT_TIME) {
+		target->stopResultTime(seed, time);
+	} else if (type == STOPRESULT_NAN) {
+		target->stopResultNan(seed);
+	} else {
+		target->stopResultError(seed);
+	}
+
+}
+
+///// BUFFEREDSIMOPTIONS
+BufferedSimOptions::BufferedSimOptions(SimOptions* source) :
+		SimOptions(*source) {
+
+	// the start states are handed over per trajectory, the stop conditions are shared.
+	myComplexes = NULL;
+	myStopConditions = NULL;
+
+	if (stop_options && stop_count > 0) {
+		sharedStopConditions = source->getStopConditions();
+	}
+
+}
+
+BufferedSimOptions::~BufferedSimOptions(void) {
+
+	if (myComplexes != NULL) {
+		delete myComplexes;
+	}
+	myComplexes = NULL;
+
+}
+
+PyObject* BufferedSimOptions::getPythonSettings() {
+
+	cout << "getPythonSettings, not available on a worker thread \n";
+	abort();
+	return NULL;
+
+}
+
+void BufferedSimOptions::generateComplexes(PyObject *, long current_seed) {
+
+	// myComplexes was already set by the controlling thread.
+	assert(myComplexes != NULL);
+	seed = current_seed;
+
+}
+
+StopConditions* BufferedSimOptions::getStopConditions(void) {
+
+	return sharedStopConditions;
+
+}
+
+void BufferedSimOptions::stopResultError(long seed) {
+
+	result.type = STOPRESULT_ERROR;
+	result.seed = seed;
+
+}
+
+void BufferedSimOptions::stopResultNan(long seed) {
+
+	result.type = STOPRESULT_NAN;
+	result.seed = seed;
+
+}
+
+void BufferedSimOptions::stopResultNormal(long seed, double time, char* message) {
+
+	result.type = STOPRESULT_NORMAL;
+	result.seed = seed;
+	result.time = time;
+	result.tag = string(message);
+
+}
+
+void BufferedSimOptions::stopResultTime(long seed, double time) {
+
+	result.type = STOPRESULT_TIME;
+	result.seed = seed;
+	result.time = time;
+
+}
+
+void BufferedSimOptions::stopResultFirstStep(long seed, double stopTime, double rate, const char* message) {
+
+	result.type = STOPRESULT_NORMAL;
+	result.firstStep = true;
+	result.seed = seed;
+	result.time = stopTime;
+	result.rate = rate;
+	result.tag = string(message);
+
+}
+
+void BufferedSimOptions::exportEndState(long, ExportData& data) {
+
+	result.endStates.push_back(data);
+
+}
+
+TrialResult BufferedSimOptions::takeResult(void) {
+
+	TrialResult output = std::move(result);
+	result = TrialResult();
+
+	return output;
+
+}
+
@@ -1,8 +1,9 @@
 #include "simoptions.h"
 #include "simtimer.h"
+#include "rng.h"
 
 
-SimTimer::SimTimer(SimOptions& myOptions) {
+SimTimer::SimTimer(SimOptions& myOptions, RandomGenerator *myRng) {
 
 	maxsimtime = myOptions.getMaxSimTime();
 	stopcount = myOptions.getStopCount();
@@ -11,13 +12,15 @@ SimTimer::SimTimer(SimOptions& myOptions) {
 	// saving the pointer to enable access to cotranscriptional timing values
 	simOptions = &myOptions;
 
+	rng = myRng;
+
 }
 
 // advances the simulation time according to the set rate
 void SimTimer::advanceTime(void) {
 
-	rchoice = rate * drand48();
-	stime += (log(1. / (1.0 - drand48())) / rate);
+	rchoice = rate * rng->uniform();
+	stime += rng->exponential() / rate;
 
 }
 
@@ -8,18 +8,26 @@
 #include "ssystem.h"
 #include "simoptions.h"
 #include "statespace.h"
+#include "stopconditions.h"
 
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
 #include <vector>
+#include <algorithm>
+#include <map>
 #include <iostream>
+#include <thread>
 
 SimulationSystem::SimulationSystem(PyObject *system_o) {
 
 	system_options = system_o;
 	simOptions = new PSimOptions(system_o);
 
+	// the options could not be read, SimSystem raises the error
+	if (PyErr_Occurred())
+		return;
+
 	construct();
 	energyModel->writeConstantsToFile();
 
@@ -56,6 +64,27 @@ void SimulationSystem::construct(void) {
 	exportStatesTime = (simOptions->getOTime() >= 0);
 
 	builder = Builder(simOptions);
+	energyCache.resize(simOptions->energyCacheSize);
+
+	if (!simOptions->trajectoryFile.empty() && !simOptions->statespaceActive) {
+		trajectoryWriter.open(simOptions->trajectoryFile);
+	}
+
+}
+
+// Worker systems share the options and the energy model of the controlling system,
+// and report their results through a BufferedSimOptions.
+SimulationSystem::SimulationSystem(SimOptions* options, EnergyModel* model) {
+
+	system_options = NULL;
+	simOptions = options;
+	energyModel = model;
+
+	simulation_mode = simOptions->getSimulationMode();
+	simulation_count_remaining = 0;
+
+	builder = Builder(simOptions);
+	energyCache.resize(simOptions->energyCacheSize);
 
 }
 
@@ -85,6 +114,11 @@ SimulationSystem::~SimulationSystem(void) {
 	}
 	complexList = NULL;
 
+	if (startTemplate != NULL) {
+		delete startTemplate;
+	}
+	startTemplate = NULL;
+
 // the remaining members are not our responsibility, we null them out
 // just in case something thread-unsafe happens.
 
@@ -98,6 +132,7 @@ SimulationSystem::~SimulationSystem(void) {
 
 	if (simOptions->myComplexes != NULL) {
 		delete simOptions->myComplexes;
+		simOptions->myComplexes = NULL;
 	}
 
 	if (simOptions != NULL) {
@@ -112,6 +147,11 @@ SimulationSystem::~SimulationSystem(void) {
 
 void SimulationSystem::StartSimulation(void) {
 
+	// the energy model and the loop pool are per thread, and Python may call us from any thread.
+	Loop::SetEnergyModel(energyModel);
+	LoopPool::use(&loopPool);
+	EnergyCache::use(&energyCache);
+
 	InitializeRNG();
 
 	if (simulation_mode & SIMULATION_MODE_FLAG_FIRST_BIMOLECULAR) {
@@ -127,6 +167,163 @@ void SimulationSystem::StartSimulation(void) {
 
 }
 
+void SimulationSystem::StartSimulation(long trials, int numThreads) {
+
+	simulation_count_remaining = trials;
+
+	if (numThreads <= 1) {
+		StartSimulation();
+		return;
+	}
+
+	if (!supportsThreads()) {
+
+		if (simOptions->verbosity) {
+			cout << "Simulation settings require Python during the run, using a single thread \n";
+		}
+
+		StartSimulation();
+		return;
+	}
+
+	Loop::SetEnergyModel(energyModel);
+
+	InitializeRNG();
+	StartSimulation_Threaded(numThreads);
+	finalizeSimulation();
+
+}
+
+// Worker threads cannot call into Python, so anything that exports states during a run
+// (or changes the shared energy model) keeps the single threaded path.
+bool SimulationSystem::supportsThreads(void) {
+
+	if (simulation_mode & SIMULATION_MODE_FLAG_TRANSITION)
+		return false;
+
+	if (exportStatesInterval || exportStatesTime || simOptions->getPrintIntialFirstStep())
+		return false;
+
+	return !(simOptions->statespaceActive || simOptions->cotranscriptional);
+
+}
+
+void SimulationSystem::StartSimulation_Threaded(int numThreads) {
+
+	vector<SimulationSystem*> workers;
+	for (int t = 0; t < numThreads; t++) {
+		workers.push_back(new SimulationSystem(new BufferedSimOptions(simOptions), energyModel));
+	}
+
+	// A fixed start state is read once per worker, which keeps it as its template.
+	bool fixedStart = simOptions->fixedStartState;
+
+	if (fixedStart) {
+		for (SimulationSystem* worker : workers) {
+			simOptions->generateComplexes(NULL, current_seed);
+			worker->simOptions->myComplexes = simOptions->myComplexes;
+			simOptions->myComplexes = NULL;
+		}
+	}
+
+	// Everything that needs Python is done here, between the chunks of trials.
+	// Trajectory seeds only depend on the initial seed and the trajectory index,
+	// so every trajectory is the same as in a single threaded run.
+	while (simulation_count_remaining > 0) {
+
+		long trials = std::min(simulation_count_remaining, (long) THREADED_CHUNK_SIZE);
+
+		vector<long> seeds(trials);
+		vector<vector<complex_input>*> starts(trials, NULL);
+
+		for (long i = 0; i < trials; i++) {
+
+			seeds[i] = current_seed;
+
+			if (fixedStart) {
+				simOptions->reuseComplexes(current_seed);
+			} else {
+				simOptions->generateComplexes(NULL, current_seed);
+				starts[i] = simOptions->myComplexes;
+				simOptions->myComplexes = NULL;
+			}
+
+			generateNextRandom();
+		}
+
+		vector<TrialResult> results(trials);
+		std::atomic<long> nextTrial(0);
+
+		Py_BEGIN_ALLOW_THREADS
+
+		vector<std::thread> threads;
+		for (int t = 0; t < numThreads; t++) {
+			threads.push_back(std::thread(&SimulationSystem::runWorker, workers[t], std::ref(nextTrial), std::ref(seeds), std::ref(starts), std::ref(results)));
+		}
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		Py_END_ALLOW_THREADS
+
+		// hand the results back in trial order
+		for (TrialResult& result : results) {
+
+			result.replay(simOptions);
+			simulation_count_remaining--;
+			pingAttr(system_options, increment_trajectory_count);
+
+		}
+	}
+
+	for (SimulationSystem* worker : workers) {
+		noInitialMoves += worker->noInitialMoves;
+		timeOut += worker->timeOut;
+		energyCache.hits += worker->energyCache.hits;
+		energyCache.misses += worker->energyCache.misses;
+		delete worker;
+	}
+
+}
+
+// Without a fixed start state, every trial brings its own start complexes.
+void SimulationSystem::runWorker(std::atomic<long>& nextTrial, vector<long>& seeds, vector<vector<complex_input>*>& starts, vector<TrialResult>& results) {
+
+	Loop::SetEnergyModel(energyModel);
+	LoopPool::use(&loopPool);
+	EnergyCache::use(&energyCache);
+
+	BufferedSimOptions *buffer = (BufferedSimOptions*) simOptions;
+
+	for (long i = nextTrial++; i < (long) seeds.size(); i = nextTrial++) {
+
+		current_seed = seeds[i];
+		rng.seed(current_seed);
+
+		if (starts[i] != NULL)
+			simOptions->myComplexes = starts[i];
+
+		InitializeSystem();
+
+		if (simulation_mode & SIMULATION_MODE_FLAG_FIRST_BIMOLECULAR) {
+			SimulationLoop_FirstStep();
+		} else if (simulation_mode & SIMULATION_MODE_FLAG_TRAJECTORY) {
+			SimulationLoop_Trajectory();
+		} else {
+			SimulationLoop_Standard();
+		}
+
+		if (simOptions->myComplexes != NULL) {
+			delete simOptions->myComplexes;
+			simOptions->myComplexes = NULL;
+		}
+
+		results[i] = buffer->takeResult();
+	}
+
+}
+
 void SimulationSystem::StartSimulation_FirstStep(void) {
 
 	while (simulation_count_remaining > 0) {
@@ -190,7 +387,7 @@ void SimulationSystem::finalizeRun(void) {
 	generateNextRandom();
 
 	// also ensure the builder does not remember the previous state
-	builder.lastState = ExportData();
+	builder.forgetLastState();
 
 }
 
@@ -213,18 +410,39 @@ void SimulationSystem::finalizeSimulation(void) {
 
 	}
 
+	if (simOptions->nativeResults) {
+
+		simOptions->flushResults();
+
+	}
+
+	trajectoryWriter.flush();
+
+	if (system_options != NULL && simOptions->energyCacheSize > 0) {
+
+		setLongAttr(system_options, energy_cache_hits, energyCache.hits);
+		setLongAttr(system_options, energy_cache_misses, energyCache.misses);
+
+	}
+
 }
 
 void SimulationSystem::SimulationLoop_Standard(void) {
 
-	SimTimer myTimer(*simOptions);
-	stopComplexes *traverse = NULL, *first = NULL;
+	SimTimer myTimer(*simOptions, &rng);
+	StopConditions *stops = NULL;
+	int stopIndex = -1;
 
 	bool checkresult = false;
 
 	complexList->initializeList();
 	myTimer.rate = complexList->getTotalFlux();
 
+	if (myTimer.stopoptions && myTimer.stopcount > 0) {
+		stops = simOptions->getStopConditions();
+		complexList->trackStopConditions(stops);
+	}
+
 	do {
 
 		myTimer.advanceTime();
@@ -256,22 +474,8 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 					return;
 				}
 
-				checkresult = false;
-				first = simOptions->getStopComplexes(0);
-				checkresult = complexList->checkStopComplexList(first->citem);
-				traverse = first;
-
-				while (traverse->next != NULL && !checkresult) {
-					traverse = traverse->next;
-					checkresult = complexList->checkStopComplexList(traverse->citem);
-				}
-				// Note: we cannot delete first here if checkresult != 0,
-				// as traverse->tag may be needed. It will get checked at
-				// that point and deleted once traverse->tag is used,
-				// later.
-				if (!checkresult) {
-					delete first;
-				}
+				stopIndex = stops->firstMatch(complexList);
+				checkresult = (stopIndex >= 0);
 			}
 		}
 	} while (myTimer.stime < myTimer.maxsimtime && !checkresult);
@@ -283,8 +487,7 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 	} else if (checkresult) {
 
 		dumpCurrentStateToPython();
-		simOptions->stopResultNormal(current_seed, myTimer.stime, traverse->tag);
-		delete first;
+		simOptions->stopResultNormal(current_seed, myTimer.stime, stops->getTag(stopIndex));
 
 	} else { // stime >= maxsimtime
 
@@ -296,8 +499,9 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 
 void SimulationSystem::SimulationLoop_Trajectory() {
 
-	SimTimer myTimer(*simOptions);
-	stopComplexes *traverse = NULL, *first = NULL;
+	SimTimer myTimer(*simOptions, &rng);
+	StopConditions *stops = NULL;
+	int stopIndex = -1;
 
 	bool stopFlag = false;
 	long current_state_count = 0;
@@ -310,7 +514,8 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 			simOptions->stopResultError(current_seed);
 			return;
 		}
-		first = simOptions->getStopComplexes(0);
+		stops = simOptions->getStopConditions();
+		complexList->trackStopConditions(stops);
 	}
 
 	// write the initial state:
@@ -341,13 +546,8 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 
 		if (myTimer.stopoptions) {
 
-			stopFlag = false;
-			stopFlag = complexList->checkStopComplexList(first->citem);
-			traverse = first;
-			while (traverse->next != NULL && !stopFlag) {
-				traverse = traverse->next;
-				stopFlag = complexList->checkStopComplexList(traverse->citem);
-			}
+			stopIndex = stops->firstMatch(complexList);
+			stopFlag = (stopIndex >= 0);
 		}
 
 	} while (myTimer.stime < myTimer.maxsimtime && !stopFlag);
@@ -358,25 +558,21 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 
 	} else if (stopFlag) {
 
-		simOptions->stopResultNormal(current_seed, myTimer.stime, traverse->tag);
+		simOptions->stopResultNormal(current_seed, myTimer.stime, stops->getTag(stopIndex));
 		// now export the tag to the builder as well
-		builder.stopResultNormal(myTimer.stime, string(traverse->tag));
+		builder.stopResultNormal(myTimer.stime, string(stops->getTag(stopIndex)));
 
 	} else {
 
 		simOptions->stopResultTime(current_seed, myTimer.stime);
 
 	}
-
-	if (first != NULL) {
-		delete first;
-	}
 }
 
 void SimulationSystem::SimulationLoop_Transition(void) {
 
-	SimTimer myTimer(*simOptions);
-	stopComplexes *traverse = NULL, *first = NULL;
+	SimTimer myTimer(*simOptions, &rng);
+	StopConditions *stops = NULL;
 
 	bool checkresult = false;
 	bool stopFlag = false;
@@ -388,31 +584,21 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 		return;
 	}
 
-// figure out which stop entries should cause us to halt, update a bool vector to
-// have true in the indices corresponding to which stop states are halting states.
+// the stop entries that cause us to halt are the ones tagged "stop:", see StopConditions::isHalting.
+
+	stops = simOptions->getStopConditions();
+	complexList->trackStopConditions(stops);
 
-	boolvector stop_entries;
 	boolvector transition_states;
-	stop_entries.resize(myTimer.stopcount, false);
-	transition_states.resize(myTimer.stopcount, false);
+	transition_states.resize(stops->size(), false);
 
 	complexList->initializeList();
 
-	first = simOptions->getStopComplexes(0);
-	traverse = first;
-	checkresult = false;
+	for (int idx = 0; idx < stops->size(); idx++) {
 
-	for (int idx = 0; idx < myTimer.stopcount; idx++) {
+		transition_states[idx] = stops->check(complexList, idx);
 
-		if (strstr(traverse->tag, "stop:") == traverse->tag)
-			stop_entries[idx] = true;
-
-		checkresult = complexList->checkStopComplexList(traverse->citem);
-
-		transition_states[idx] = checkresult;
-		traverse = traverse->next;
 	}
-	delete first;
 	sendTransitionStateVectorToPython(transition_states, myTimer.stime);
 // start
 
@@ -430,19 +616,17 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 			myTimer.rate = complexList->getTotalFlux();
 
 			// check if our transition state membership vector has changed
-			first = simOptions->getStopComplexes(0);
 			checkresult = false;
-			traverse = first;
 
-			for (int idx = 0; idx < myTimer.stopcount; idx++) {
+			for (int idx = 0; idx < stops->size(); idx++) {
 
-				checkresult = complexList->checkStopComplexList(traverse->citem);
+				checkresult = stops->check(complexList, idx);
 
-				if (checkresult && stop_entries[idx]) {
+				if (checkresult && stops->isHalting(idx)) {
 					// multiple stop states could suddenly be true, we add
 					// a status line entry for the first one found.
 					if (!stopFlag) {
-						simOptions->stopResultNormal(current_seed, myTimer.stime, traverse->tag);
+						simOptions->stopResultNormal(current_seed, myTimer.stime, stops->getTag(idx));
 					}
 
 					stopFlag = true;
@@ -453,12 +637,8 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 				}
 
 				transition_states[idx] = checkresult;
-				traverse = traverse->next;
 			}
-			delete first; // we can do this now as we no longer need to
-						  // save the stoplist until the loop exits, due
-						  // to moving printStatusLine to immediately upon
-						  // finding the stopping condition.
+
 			if (state_changed) {
 				sendTransitionStateVectorToPython(transition_states, myTimer.stime);
 				state_changed = false;
@@ -485,8 +665,9 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 
 void SimulationSystem::SimulationLoop_FirstStep(void) {
 
-	SimTimer myTimer(*simOptions);
-	stopComplexes *traverse = NULL, *first = NULL;
+	SimTimer myTimer(*simOptions, &rng);
+	StopConditions *stops = NULL;
+	int stopIndex = -1;
 
 	bool stopFlag = false;
 
@@ -540,6 +721,11 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 // Begin normal steps.
 	myTimer.rate = complexList->getTotalFlux();
 
+	if (myTimer.stopcount > 0 && myTimer.stopoptions) {
+		stops = simOptions->getStopConditions();
+		complexList->trackStopConditions(stops);
+	}
+
 	do {
 
 		myTimer.advanceTime();
@@ -565,26 +751,15 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 
 		if (myTimer.stopcount > 0 && myTimer.stopoptions) {
 
-			stopFlag = false;
-			first = simOptions->getStopComplexes(0);
-			traverse = first;
-			stopFlag = complexList->checkStopComplexList(traverse->citem);
-
-			while (traverse->next != NULL && !stopFlag) {
-				traverse = traverse->next;
-				stopFlag = complexList->checkStopComplexList(traverse->citem);
-			}
-
-			if (!stopFlag && first != NULL)
-				delete first;
+			stopIndex = stops->firstMatch(complexList);
+			stopFlag = (stopIndex >= 0);
 		}
 
 	} while (myTimer.stime < myTimer.maxsimtime && !stopFlag);
 
 	if (stopFlag) {
 		dumpCurrentStateToPython();
-		simOptions->stopResultFirstStep(current_seed, myTimer.stime, frate, traverse->tag);
-		delete first;
+		simOptions->stopResultFirstStep(current_seed, myTimer.stime, frate, stops->getTag(stopIndex));
 	} else {
 		timeOut++;
 		dumpCurrentStateToPython();
@@ -605,8 +780,13 @@ void SimulationSystem::dumpCurrentStateToPython(void) {
 
 	while (temp != NULL) {
 
-		temp->dumpComplexEntryToPython(data);
-		printComplexStateLine(simOptions->getPythonSettings(), current_seed, data);
+		temp->dumpComplexEntryToPython(data, energyModel);
+		simOptions->exportEndState(current_seed, data);
+
+		for (int copyId : temp->copyIds) {
+			data.id = copyId;
+			simOptions->exportEndState(current_seed, data);
+		}
 
 		temp = temp->next;
 	}
@@ -671,12 +851,25 @@ void SimulationSystem::sendTrajectory_CurrentStateToPython(double current_time,
 
 	SComplexListEntry *temp = complexList->getFirst();
 
+	if (trajectoryWriter.isOpen()) {
+
+		trajectoryWriter.writeFrame(current_time, arrType, complexList, energyModel);
+		return;
+
+	}
+
 	while (temp != NULL) {
 
-		temp->dumpComplexEntryToPython(data);
+		temp->dumpComplexEntryToPython(data, energyModel);
 
 		if (!simOptions->statespaceActive) {
+
 			pushTrajectoryComplex(system_options, current_seed, data);
+
+			for (int copyId : temp->copyIds) {
+				data.id = copyId;
+				pushTrajectoryComplex(system_options, current_seed, data);
+			}
 		}
 
 		temp = temp->next;
@@ -705,28 +898,105 @@ int SimulationSystem::InitializeSystem(PyObject *alternate_start) {
 	StrandComplex *tempcomplex;
 	identList *id;
 
-	simOptions->generateComplexes(alternate_start, current_seed);
+	// a fixed start state is built once, every trajectory starts from a copy
+	bool fixedStart = simOptions->fixedStartState && alternate_start == NULL && !simOptions->statespaceActive;
+
+	if (fixedStart && startTemplate != NULL)
+		simOptions->reuseComplexes(current_seed);
+	else
+		simOptions->generateComplexes(alternate_start, current_seed);
+
+	LoopPool::use(&loopPool);
+	EnergyCache::use(&energyCache);
+
+	// the loops read Loop::energyModel of this thread, which StartSimulation and runWorker set.
+	assert(Loop::GetEnergyModel() == energyModel);
+
+	// the energy model outlives the trajectories, each starts with the initial nucleotides.
+	// Worker threads share the model, but cotranscriptional runs keep a single thread.
+	if (simOptions->cotranscriptional)
+		energyModel->numActiveNT = simOptions->initialActiveNT;
 
 // FD: Somehow, check if complex list is pre-populated.
 	startState = NULL;
 	if (complexList != NULL)
 		delete complexList;
 
+	if (fixedStart && startTemplate != NULL) {
+
+		complexList = startTemplate->copy();
+		startState = complexList->getFirst()->thisComplex;
+
+		if (trajectoryWriter.isOpen()) {
+			trajectoryWriter.begin(current_seed);
+		}
+
+		return 0;
+	}
+
 	complexList = new SComplexList(energyModel);
 
+	bool flatEngine = simOptions->stateEngine == STATEENGINE_FLAT && simOptions->myComplexes->size() == 1 && !simOptions->cotranscriptional
+			&& !simOptions->statespaceActive;
+
+	// identical start complexes share an entry, keyed by their strands, sequence and structure
+	bool merge = simOptions->speciesMultiplicity && alternate_start == NULL && !simOptions->statespaceActive && !simOptions->cotranscriptional;
+	std::map<string, SComplexListEntry*> species;
+
 // FD: this is the python - C interface
 	for (unsigned int i = 0; i < simOptions->myComplexes->size(); i++) {
 
-		char* tempSequence = copyToCharArray(simOptions->myComplexes->at(i).sequence);
-		char* tempStructure = copyToCharArray(simOptions->myComplexes->at(i).structure);
+		complex_input& input = simOptions->myComplexes->at(i);
+		string key;
+
+		if (merge) {
+
+			key = input.sequence + " " + input.structure;
+
+			for (identList *strand = input.list; strand != NULL; strand = strand->next)
+				key += " " + std::to_string(strand->uid) + ":" + strand->toString();
+
+			if (species.count(key) > 0) {
+				complexList->addCopy(species[key]);
+				delete input.list;
+				input.list = NULL;
+				continue;
+			}
+		}
 
-		id = simOptions->myComplexes->at(i).list;
+		char* tempSequence = copyToCharArray(input.sequence);
+		char* tempStructure = copyToCharArray(input.structure);
+
+		id = input.list;
+
+		// the ordering takes the strand list, the copies need their own
+		identList *strands = merge ? id->copy() : NULL;
 
 		tempcomplex = new StrandComplex(tempSequence, tempStructure, id);
 
+		if (flatEngine && tempcomplex->getStrandCount() == 1)
+			tempcomplex->useFlatEngine();
+
 		startState = tempcomplex;
-		complexList->addComplex(tempcomplex);
+		SComplexListEntry *entry = complexList->addComplex(tempcomplex);
+
+		if (merge) {
+			entry->species = new complex_input();
+			entry->species->sequence = input.sequence;
+			entry->species->structure = input.structure;
+			entry->species->list = strands;
+			species[key] = entry;
+		}
+
+	}
+
+	if (fixedStart) {
+		complexList->initializeComplexes();
+		startTemplate = complexList->copy();
+	}
 
+	if (trajectoryWriter.isOpen()) {
+		trajectoryWriter.begin(current_seed);
 	}
 
 	if (utility::debugTraces) {
@@ -757,12 +1027,15 @@ void SimulationSystem::InitializeRNG(void) {
 		}
 	}
 // now initialize this generator using our random seed, so that we can reproduce as necessary.
-	srand48(current_seed);
+	initial_seed = current_seed;
+	trajectory_index = 0;
+	rng.seed(current_seed);
 }
 
 void SimulationSystem::generateNextRandom(void) {
-	current_seed = lrand48();
-	srand48(current_seed);
+	trajectory_index++;
+	current_seed = trajectorySeed(initial_seed, trajectory_index);
+	rng.seed(current_seed);
 }
 
 PyObject *SimulationSystem::calculateEnergy(PyObject *start_state, int typeflag) {
@@ -789,6 +1062,32 @@ PyObject *SimulationSystem::calculateEnergy(PyObject *start_state, int typeflag)
 	return retval;
 }
 
+PyObject *SimulationSystem::transitionRates(PyObject *start_state) {
+
+	if (InitializeSystem(start_state) != 0) {
+		Py_RETURN_NONE;
+	}
+	complexList->initializeList();
+
+	PyObject *retval = PyList_New(0);
+// New Reference, we return it. Entries are reversed as in calculateEnergy, the first complex first.
+	for (SComplexListEntry *entry = complexList->getFirst(); entry != NULL; entry = entry->next) {
+
+		std::vector<BasePairMove> moves;
+		entry->thisComplex->listMoves(moves);
+
+		PyObject *list = PyList_New(moves.size());
+		for (unsigned int i = 0; i < moves.size(); i++)
+			PyList_SET_ITEM(list, i, Py_BuildValue("(Oiid)", moves[i].create ? Py_True : Py_False, moves[i].first, moves[i].second, moves[i].rate));
+
+		PyObject *item = Py_BuildValue("(dN)", entry->thisComplex->getEnergy(), list);
+		PyList_Insert(retval, 0, item);
+		Py_DECREF(item);
+	}
+
+	return retval;
+}
+
 void SimulationSystem::exportTime(double& simTime, double& lastExportTime) {
 
 	if (simTime - lastExportTime > simOptions->getOTime()) {
@@ -853,6 +1152,7 @@ void SimulationSystem::localTransitions(void) {
 
 	assert(simOptions->statespaceActive);
 	energyModel->inspection = true;
+	energyModel->selectRatePolicy();
 
 	InitializeRNG(); // the output dir will be '0' if unset
 	InitializeSystem();
@@ -869,7 +1169,7 @@ void SimulationSystem::localTransitions(void) {
 		complexList->updateOpenInfo();
 		complexList->getTotalFlux();	 // required to set joinrate
 
-		SimTimer myTimer(*simOptions);
+		SimTimer myTimer(*simOptions, &rng);
 		myTimer.rchoice = i + 0.01;
 
 		// export the initial state
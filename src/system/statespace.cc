@@ -9,7 +9,7 @@
  *      Author: Frits Dannenberg
  *
  *      This class collects every visited state, and transitions between visited states.
- *      After the simulation is done, the set is exported to a text file.
+ *      After the simulation is done, the set is exported to file, see statespace.h.
  *
  */
 
@@ -18,6 +18,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
 
 const string Builder::the_dir = "p_statespace/";
 
@@ -33,44 +37,48 @@ Builder::Builder(SimOptions* options) {
 
 std::ostream& operator<<(std::ostream& ss, Builder& b) {
 
-	ss << "nStates = " << b.protoSpace.size();
-	ss << "   nTransitions = " << b.protoTransitions.size();
+	b.compactTransitions();
+
+	ss << "nStates = " << b.states.size();
+	ss << "   nTransitions = " << b.transitions.size();
 
 	return ss;
 }
 
 // Put the statespace in memory
-// Note: this copies the contents of the input.
-// Could use shared pointer to prevent this,
-// but statespace building will only be used during inference anyhow.
-// also note the copy only occurs if the state / transition is not found already
-// this is a relatively rare event for a typical simulation.
+// A state is looked up by its fingerprint, only a new state is copied into the pool.
+// Transitions are kept as pairs of state ids, duplicates are removed whenever
+// the list has doubled since the last time.
 
 void Builder::addState(ExportData& data, const double arrType) {
 
-	protoSpace.insert(data);
+	uint32_t id = intern(data);
 
 	// also record the transition itself.
-	if (lastState.complex_count > 0) {
+	if (lastState >= 0) {
 
-		ExportTransition trans;
-		trans.state1 = lastState;
-		trans.state2 = data;
+		Transition trans;
+		trans.from = lastState;
+		trans.to = id;
 		trans.type = arrType;
 
-		protoTransitions.insert(std::move(trans));
+		transitions.push_back(trans);
+
+		if (transitions.size() >= 2 * compacted + 1024) {
+			compactTransitions();
+		}
 
 	} else { // set the initial state
 
-		auto element = protoInitialStates.find(data);
+		auto element = initialStates.find(id);
 
-		if (element == protoInitialStates.end()) {
+		if (element == initialStates.end()) {
 
 			ExportInitial newEntry = ExportInitial();
 			newEntry.join_rate = arrType; // overloading arrType to be join rate
 			newEntry.observation_count++;
 
-			protoInitialStates[data] = std::move(newEntry);
+			initialStates[id] = newEntry;
 
 		} else {
 
@@ -80,24 +88,24 @@ void Builder::addState(ExportData& data, const double arrType) {
 
 	}
 
-	lastState = std::move(data);
+	lastState = id;
 
 }
 
 // export the final state to the appropriate map.
 void Builder::stopResultNormal(double endtime, string tag) {
 
-	if (lastState.complex_count > 0) {
+	if (lastState >= 0) {
 
-		auto element = protoFinalStates.find(lastState);
+		auto element = finalStates.find(lastState);
 
-		if (element == protoFinalStates.end()) {
+		if (element == finalStates.end()) {
 
 			ExportFinal newEntry = ExportFinal();
 			newEntry.tag = tag;
 			newEntry.observation_count++;
 
-			protoFinalStates[std::move(lastState)] = std::move(newEntry);
+			finalStates[lastState] = std::move(newEntry);
 
 		} else {
 
@@ -107,14 +115,102 @@ void Builder::stopResultNormal(double endtime, string tag) {
 
 	}
 
-	// now wipe the last state because we have moved the contents
-	lastState = ExportData();
+	forgetLastState();
+
+}
+
+void Builder::forgetLastState(void) {
+
+	lastState = -1;
+
+}
+
+// The id of the state, which is added if it was not visited before.
+uint32_t Builder::intern(ExportData& data) {
+
+	FingerprintBuilder fingerprint;
+	fingerprint.add((uint64_t) data.id);
+	fingerprint.add(data.sequence);
+	fingerprint.add(data.structure);
+
+	auto element = stateIds.emplace(fingerprint.get(), (uint32_t) states.size());
+
+	if (element.second) {
+
+		State state;
+		state.names = internString(data.names);
+		state.sequence = internString(data.sequence);
+		state.structure = poolString(data.structure);
+		state.energy = data.energy;
+		state.enthalpy = data.enthalpy;
+		state.complex_count = data.complex_count;
+
+		states.push_back(state);
+
+	}
+
+	return element.first->second;
+
+}
+
+size_t Builder::internString(const string& text) {
+
+	auto element = sharedStrings.find(text);
+
+	if (element != sharedStrings.end()) {
+		return element->second;
+	}
+
+	size_t offset = poolString(text);
+	sharedStrings[text] = offset;
+
+	return offset;
+
+}
+
+size_t Builder::poolString(const string& text) {
+
+	size_t offset = pool.size();
+
+	pool.append(text);
+	pool.push_back('\0');
+
+	return offset;
+
+}
+
+void Builder::compactTransitions(void) {
+
+	std::sort(transitions.begin(), transitions.end());
+	transitions.erase(std::unique(transitions.begin(), transitions.end()), transitions.end());
+
+	compacted = transitions.size();
+
+}
+
+// the same line as an ExportData of the state
+void Builder::writeState(std::ostream& str, uint32_t id) {
+
+	State& state = states[id];
+
+	str << std::to_string(state.complex_count) << " ";
+	str << &pool[state.names] << " ";
+	str << &pool[state.sequence] << " ";
+	str << &pool[state.structure] << " ";
+	str << std::to_string(state.energy) << " ";
+	str << std::to_string(state.enthalpy) << "\n";
+
+}
+
+string Builder::directory(void) {
+
+	return Builder::the_dir + to_string(simOptions->getSeed());
 
 }
 
 string Builder::filename(string input) {
 
-	return string(Builder::the_dir + to_string(simOptions->getSeed())) + "/" + input + ".txt";
+	return directory() + "/" + input + ".txt";
 
 }
 
@@ -122,19 +218,43 @@ string Builder::filename(string input) {
 //
 void Builder::writeToFile(void) {
 
-	// create dir
-	// system call to create a directory  TODO fix this to use experimental/filesystem
-	system((string("mkdir -p ") + Builder::the_dir + to_string(simOptions->getSeed())).c_str());
+	// create dir, an existing one is fine
+	if ((mkdir(Builder::the_dir.c_str(), 0777) != 0 && errno != EEXIST) || (mkdir(directory().c_str(), 0777) != 0 && errno != EEXIST)) {
+
+		fprintf(stderr, "Could not create the statespace directory %s: %s\n", directory().c_str(), strerror(errno));
+		exit(1);
 
-	// states
-	unordered_set<ExportData>::iterator itr;
+	}
+
+	compactTransitions();
+
+	if (simOptions->statespaceBinary) {
+		writeBinary();
+	} else {
+		writeText();
+	}
+
+	// now clear the maps
+	pool.clear();
+	sharedStrings.clear();
+	states.clear();
+	stateIds.clear();
+	transitions.clear();
+	compacted = 0;
+	finalStates.clear();
+	initialStates.clear();
+	forgetLastState();
+
+}
+
+void Builder::writeText(void) {
 
 	std::ofstream myfile;
 	myfile.open(filename("protospace"));
 
-	for (auto element : protoSpace) {
+	for (uint32_t id = 0; id < states.size(); id++) {
 
-		myfile << element;
+		writeState(myfile, id);
 	}
 
 	myfile.close();
@@ -142,9 +262,12 @@ void Builder::writeToFile(void) {
 	// transitions
 	myfile.open(filename("prototransitions"));
 
-	for (auto element : protoTransitions) {
+	for (Transition& trans : transitions) {
 
-		myfile << element;
+		myfile << std::to_string(trans.type) << "\n";
+		writeState(myfile, trans.from);
+		writeState(myfile, trans.to);
+		myfile << "\n";
 
 	}
 
@@ -153,10 +276,10 @@ void Builder::writeToFile(void) {
 	// init
 	myfile.open(filename("protoinitialstates"));
 
-	for (auto element : protoInitialStates) {
+	for (auto element : initialStates) {
 
 		myfile << element.second << "\n";
-		myfile << element.first;
+		writeState(myfile, element.first);
 
 	}
 
@@ -165,20 +288,113 @@ void Builder::writeToFile(void) {
 	// final states
 	myfile.open(filename("protofinalstates"));
 
-	for (auto element : protoFinalStates) {
+	for (auto element : finalStates) {
 
-		myfile << element.first;
+		writeState(myfile, element.first);
 		myfile << element.second;
 
 	}
 
 	myfile.close();
 
-	// now clear the maps
-	protoSpace.clear();
-	protoTransitions.clear();
-	protoFinalStates.clear();
-	protoInitialStates.clear();
+}
+
+// Each column is written as a whole, padded so the next one starts at a multiple of 8 bytes.
+template<class T>
+static void writeColumn(std::ofstream& file, const vector<T>& column) {
+
+	static const char padding[8] = { 0 };
+
+	size_t size = column.size() * sizeof(T);
+
+	file.write((const char*) column.data(), size);
+	file.write(padding, (8 - size % 8) % 8);
 
 }
 
+void Builder::writeBinary(void) {
+
+	// final tags go into the pool, so it is written last
+	vector<uint32_t> finalState, initialState;
+	vector<int32_t> finalCount, initialCount;
+	vector<uint64_t> finalTag;
+	vector<double> joinRate;
+
+	for (auto& element : finalStates) {
+
+		finalState.push_back(element.first);
+		finalCount.push_back(element.second.observation_count);
+		finalTag.push_back(internString(element.second.tag));
+
+	}
+
+	for (auto& element : initialStates) {
+
+		initialState.push_back(element.first);
+		initialCount.push_back(element.second.observation_count);
+		joinRate.push_back(element.second.join_rate);
+
+	}
+
+	vector<uint64_t> names, sequence, structure;
+	vector<double> energy, enthalpy;
+	vector<uint8_t> complexCount;
+
+	for (State& state : states) {
+
+		names.push_back(state.names);
+		sequence.push_back(state.sequence);
+		structure.push_back(state.structure);
+		energy.push_back(state.energy);
+		enthalpy.push_back(state.enthalpy);
+		complexCount.push_back(state.complex_count);
+
+	}
+
+	vector<uint32_t> from, to;
+	vector<double> type;
+
+	for (Transition& trans : transitions) {
+
+		from.push_back(trans.from);
+		to.push_back(trans.to);
+		type.push_back(trans.type);
+
+	}
+
+	std::ofstream file(directory() + "/statespace.bin", std::ios::binary);
+
+	const uint64_t counts[5] = { states.size(), transitions.size(), initialState.size(), finalState.size(), pool.size() };
+
+	file.write("MSSPACE1", 8);
+	file.write((const char*) counts, sizeof(counts));
+
+	writeColumn(file, names);
+	writeColumn(file, sequence);
+	writeColumn(file, structure);
+	writeColumn(file, energy);
+	writeColumn(file, enthalpy);
+	writeColumn(file, complexCount);
+
+	writeColumn(file, from);
+	writeColumn(file, to);
+	writeColumn(file, type);
+
+	writeColumn(file, initialState);
+	writeColumn(file, initialCount);
+	writeColumn(file, joinRate);
+
+	writeColumn(file, finalState);
+	writeColumn(file, finalCount);
+	writeColumn(file, finalTag);
+
+	file.write(pool.data(), pool.size());
+
+	if (!file) {
+
+		fprintf(stderr, "Could not write the statespace to %s/statespace.bin\n", directory().c_str());
+		exit(1);
+
+	}
+
+}
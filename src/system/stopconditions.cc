@@ -0,0 +1,309 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the StopConditions and StopTracker objects found in stopconditions.h
+#include <string.h>
+#include "stopconditions.h"
+#include "optionlists.h"
+#include "scomplexlist.h"
+#include "strandordering.h"
+
+using std::vector;
+
+StopConditions::StopConditions(stopComplexes *list) {
+
+	head = list;
+
+	for (stopComplexes *traverse = head; traverse != NULL; traverse = traverse->next) {
+
+		conditions.push_back(traverse);
+		halting.push_back(strstr(traverse->tag, "stop:") == traverse->tag);
+
+		// strand counts are the first thing compared against a complex, count them once here.
+		for (complexItem *item = traverse->citem; item != NULL; item = item->next) {
+
+			item->id_count = 0;
+			for (identList *id = item->strand_ids; id != NULL; id = id->next)
+				item->id_count++;
+
+			compileTarget(item);
+		}
+	}
+
+}
+
+// Structures that cannot be matched position by position are left to the string comparison
+// in SComplexList: unbalanced ones, exact structures with wildcards, and repeated strand names.
+void StopConditions::compileTarget(complexItem *item) {
+
+	if (item->type != STOPTYPE_STRUCTURE && item->type != STOPTYPE_LOOSE_STRUCTURE && item->type != STOPTYPE_PERCENT_OR_COUNT_STRUCTURE)
+		return;
+
+	StructureTarget target;
+	vector<int> open;
+	identList *id = item->strand_ids;
+	int position = 0, strandStart = 0;
+
+	for (char *c = item->structure;; c++) {
+
+		if (*c == '+' || *c == '\0') {
+
+			if (id == NULL)
+				return;
+
+			target.tags.push_back(id->id);
+			target.start.push_back(strandStart);
+			target.length.push_back(position - strandStart);
+			id = id->next;
+			strandStart = position;
+
+			if (*c == '\0')
+				break;
+			continue;
+		}
+
+		if (*c == '(') {
+			open.push_back(position);
+			target.partner.push_back(STOP_UNPAIRED);
+		} else if (*c == ')') {
+			if (open.empty())
+				return;
+			target.partner[open.back()] = position;
+			target.partner.push_back(open.back());
+			open.pop_back();
+		} else if (*c == '.') {
+			target.partner.push_back(STOP_UNPAIRED);
+		} else if (*c == '*' && item->type == STOPTYPE_LOOSE_STRUCTURE) {
+			target.partner.push_back(STOP_WILDCARD);
+		} else if (*c == '*' && item->type == STOPTYPE_PERCENT_OR_COUNT_STRUCTURE) {
+			// checkCountStructure compares '*' as a character, so it never matches
+			target.partner.push_back(STOP_MISMATCH);
+		} else {
+			return;
+		}
+
+		position++;
+	}
+
+	if (id != NULL || !open.empty())
+		return;
+
+	for (unsigned int i = 0; i < target.tags.size(); i++)
+		for (unsigned int j = i + 1; j < target.tags.size(); j++)
+			if (strcmp(target.tags[i], target.tags[j]) == 0)
+				return;
+
+	item->trackIndex = targets.size();
+	targets.push_back(target);
+
+}
+
+StopConditions::~StopConditions(void) {
+
+	if (head != NULL)
+		delete head;
+
+}
+
+int StopConditions::size(void) const {
+
+	return conditions.size();
+
+}
+
+char *StopConditions::getTag(int index) const {
+
+	return conditions[index]->tag;
+
+}
+
+bool StopConditions::isHalting(int index) const {
+
+	return halting[index];
+
+}
+
+bool StopConditions::check(SComplexList *complexList, int index) const {
+
+	return complexList->checkStopComplexList(conditions[index]->citem);
+
+}
+
+int StopConditions::firstMatch(SComplexList *complexList) const {
+
+	for (int index = 0; index < (int) conditions.size(); index++) {
+		if (complexList->checkStopComplexList(conditions[index]->citem))
+			return index;
+	}
+
+	return -1;
+
+}
+
+int StopConditions::targetCount(void) const {
+
+	return targets.size();
+
+}
+
+const StructureTarget& StopConditions::getTarget(int index) const {
+
+	return targets[index];
+
+}
+
+StopTracker::StopTracker(StopConditions *stops, vector<StrandOrdering*>& orderings) {
+
+	this->stops = stops;
+
+	int count = stops->targetCount();
+	bound.resize(count, false);
+	wrong.resize(count);
+	distance.resize(count, 0);
+
+	for (unsigned int i = 0; i < orderings.size(); i++) {
+		for (orderingList *strand = orderings[i]->first; strand != NULL; strand = strand->next) {
+			strand->stopTracker = this;
+			strand->stopWatch = -1;
+		}
+	}
+
+	for (int t = 0; t < count; t++) {
+
+		const StructureTarget& target = stops->getTarget(t);
+		vector<orderingList*> strands;
+
+		for (unsigned int s = 0; s < target.tags.size(); s++) {
+
+			orderingList *found = NULL;
+			int matches = 0;
+
+			for (unsigned int i = 0; i < orderings.size(); i++) {
+				for (orderingList *strand = orderings[i]->first; strand != NULL; strand = strand->next) {
+					if (strcmp(strand->thisTag, target.tags[s]) == 0) {
+						found = strand;
+						matches++;
+					}
+				}
+			}
+
+			if (matches != 1 || found->size != target.length[s])
+				break;
+
+			strands.push_back(found);
+		}
+
+		if (strands.size() != target.tags.size())
+			continue;
+
+		bound[t] = true;
+
+		for (unsigned int s = 0; s < strands.size(); s++) {
+
+			if (strands[s]->stopWatch < 0) {
+				strands[s]->stopWatch = watches.size();
+				watches.push_back(vector<Watch>());
+			}
+
+			Watch watch = { t, target.start[s] };
+			watches[strands[s]->stopWatch].push_back(watch);
+		}
+
+		// start from a fully unpaired state, the pairs are added below
+		wrong[t].resize(target.partner.size(), 0);
+		for (unsigned int k = 0; k < target.partner.size(); k++) {
+			if (target.partner[k] >= 0 || target.partner[k] == STOP_MISMATCH) {
+				wrong[t][k] = 1;
+				distance[t]++;
+			}
+		}
+	}
+
+	if (watches.empty())
+		return;
+
+	for (unsigned int i = 0; i < orderings.size(); i++) {
+
+		vector<orderingList*> openStrand;
+		vector<int> openIndex;
+
+		for (orderingList *strand = orderings[i]->first; strand != NULL; strand = strand->next) {
+			for (int k = 0; k < strand->size; k++) {
+
+				if (strand->thisStruct[k] == '(') {
+					openStrand.push_back(strand);
+					openIndex.push_back(k);
+				} else if (strand->thisStruct[k] == ')') {
+					pairChanged(openStrand.back(), openIndex.back(), strand, k, true);
+					openStrand.pop_back();
+					openIndex.pop_back();
+				}
+			}
+		}
+	}
+
+}
+
+bool StopTracker::isTracked(complexItem *item) const {
+
+	return item->trackIndex >= 0 && bound[item->trackIndex];
+
+}
+
+int StopTracker::getDistance(complexItem *item) const {
+
+	return distance[item->trackIndex];
+
+}
+
+void StopTracker::pairChanged(orderingList *first, int a, orderingList *second, int b, bool paired) {
+
+	update(first, a, second, b, paired);
+	update(second, b, first, a, paired);
+
+}
+
+void StopTracker::update(orderingList *strand, int index, orderingList *other, int otherIndex, bool paired) {
+
+	if (strand->stopWatch < 0)
+		return;
+
+	vector<Watch>& list = watches[strand->stopWatch];
+
+	for (unsigned int w = 0; w < list.size(); w++) {
+
+		int t = list[w].target;
+		int position = list[w].base + index;
+		int current = STOP_UNPAIRED;
+
+		if (paired) {
+			int otherBase = findBase(other, t);
+			current = (otherBase < 0) ? STOP_OUTSIDE : otherBase + otherIndex;
+		}
+
+		int wanted = stops->getTarget(t).partner[position];
+		char isWrong = (wanted != STOP_WILDCARD && wanted != current);
+
+		distance[t] += isWrong - wrong[t][position];
+		wrong[t][position] = isWrong;
+	}
+
+}
+
+int StopTracker::findBase(orderingList *strand, int target) const {
+
+	if (strand->stopWatch < 0)
+		return -1;
+
+	const vector<Watch>& list = watches[strand->stopWatch];
+
+	for (unsigned int w = 0; w < list.size(); w++)
+		if (list[w].target == target)
+			return list[w].base;
+
+	return -1;
+
+}
@@ -0,0 +1,253 @@
+/*
+ Copyright (c) 2017 California Institute of Technology. All rights reserved.
+ Multistrand nucleic acid kinetic simulator
+ help@multistrand.org
+ */
+
+// Implementation of the TrajectoryWriter found in trajectorywriter.h
+#include <stdint.h>
+#include <algorithm>
+#include "trajectorywriter.h"
+#include "scomplexlist.h"
+#include "scomplex.h"
+#include "strandordering.h"
+
+static const char trajectoryMagic[8] = { 'M', 'S', 'T', 'R', 'A', 'J', '0', '1' };
+
+TrajectoryWriter::~TrajectoryWriter(void) {
+
+	if (file != NULL) {
+		fclose(file);
+	}
+
+}
+
+bool TrajectoryWriter::open(const string& path) {
+
+	file = fopen(path.c_str(), "wb");
+
+	if (file == NULL) {
+		fprintf(stderr, "Could not open the trajectory file %s, states are sent to Python instead.\n", path.c_str());
+		return false;
+	}
+
+	fwrite(trajectoryMagic, 1, sizeof(trajectoryMagic), file);
+	return true;
+
+}
+
+bool TrajectoryWriter::isOpen(void) {
+
+	return file != NULL;
+
+}
+
+void TrajectoryWriter::flush(void) {
+
+	if (file != NULL) {
+		fflush(file);
+	}
+
+}
+
+void TrajectoryWriter::begin(long newSeed) {
+
+	seed = newSeed;
+	pending = true;
+	last.clear();
+	lastOrder.clear();
+	changes.clear();
+
+}
+
+// A pair that comes back within a frame cancels out.
+void TrajectoryWriter::pairChanged(StrandOrdering *ordering, int first, int second, bool paired) {
+
+	std::pair<uint32_t, uint32_t> pair(std::min(first, second), std::max(first, second));
+	PairChanges& pairs = changes[ordering];
+	PairChanges::iterator found = pairs.find(pair);
+
+	if (found != pairs.end())
+		pairs.erase(found);
+	else
+		pairs[pair] = paired;
+
+}
+
+void TrajectoryWriter::writeFrame(double time, double arrType, SComplexList *complexes, EnergyModel *model) {
+
+	struct Item {
+		SComplexListEntry *entry;
+		int id;
+		bool full; // new, or its strands changed since the last frame
+	};
+
+	if (pending) {
+		put((int64_t) seed);
+		writeRecord('T');
+		pending = false;
+	}
+
+	vector<Item> current;
+
+	for (SComplexListEntry *entry = complexes->getFirst(); entry != NULL; entry = entry->next) {
+
+		orderingList *strands = entry->thisComplex->ordering->first;
+
+		for (int copy = 0; copy < entry->copies; copy++) {
+
+			int id = (copy == 0) ? entry->id : entry->copyIds[copy - 1];
+			std::unordered_map<int, Written>::iterator found = last.find(id);
+			Item item = { entry, id, !entry->exported || found == last.end() || found->second.strands != strands };
+
+			if (!item.full)
+				found->second.kept = true;
+
+			current.push_back(item);
+		}
+	}
+
+	put(time);
+	put(arrType);
+
+	// removed
+	uint32_t count = 0;
+	for (int id : lastOrder) {
+		count += !last[id].kept;
+	}
+
+	put(count);
+	for (int id : lastOrder) {
+		if (!last[id].kept)
+			put((int32_t) id);
+	}
+
+	// added, from now on their strands report the pairs they change
+	count = 0;
+	for (Item& item : current) {
+		count += item.full;
+	}
+
+	put(count);
+	for (Item& item : current) {
+
+		if (!item.full)
+			continue;
+
+		ExportData data;
+		item.entry->dumpComplexEntryToPython(data, model);
+		data.id = item.id;
+		writeComplex(data);
+
+		item.entry->exported = true;
+		for (orderingList *strand = item.entry->thisComplex->ordering->first; strand != NULL; strand = strand->next)
+			strand->trajectoryWriter = this;
+	}
+
+	// order, only when the complexes no longer follow the last frame
+	bool reordered = (count > 0) || (current.size() != lastOrder.size());
+	for (size_t c = 0; c < current.size() && !reordered; c++) {
+		reordered = (current[c].id != lastOrder[c]);
+	}
+
+	put((uint32_t) (reordered ? current.size() : 0));
+	if (reordered) {
+		for (Item& item : current) {
+			put((int32_t) item.id);
+		}
+	}
+
+	// changed, collected aside as their count goes first
+	string changed;
+	count = 0;
+
+	payload.swap(changed);
+	for (Item& item : current) {
+
+		if (item.full)
+			continue;
+
+		Written& before = last[item.id];
+		double energy = item.entry->getEnergy(model);
+		double enthalpy = item.entry->thisComplex->getEnthalpy();
+
+		std::unordered_map<StrandOrdering*, PairChanges>::iterator found = changes.find(item.entry->thisComplex->ordering);
+		bool paired = (found != changes.end() && !found->second.empty());
+
+		if (!paired && before.energy == energy && before.enthalpy == enthalpy)
+			continue;
+
+		put((int32_t) item.id);
+		put(energy);
+		put(enthalpy);
+
+		for (bool formed : { false, true }) {
+
+			uint32_t pairs = 0;
+
+			if (paired)
+				for (auto& change : found->second)
+					pairs += (change.second == formed);
+
+			put(pairs);
+
+			if (paired)
+				for (auto& change : found->second)
+					if (change.second == formed) {
+						put(change.first.first);
+						put(change.first.second);
+					}
+		}
+
+		count++;
+	}
+	payload.swap(changed);
+
+	put(count);
+	payload.append(changed);
+
+	writeRecord('F');
+
+	last.clear();
+	lastOrder.clear();
+
+	for (Item& item : current) {
+
+		Written written = { item.entry->getEnergy(model), item.entry->thisComplex->getEnthalpy(), item.entry->thisComplex->ordering->first, false };
+		last[item.id] = written;
+		lastOrder.push_back(item.id);
+	}
+
+	changes.clear();
+
+}
+
+void TrajectoryWriter::writeRecord(char kind) {
+
+	uint32_t length = payload.size();
+
+	fputc(kind, file);
+	fwrite(&length, sizeof(length), 1, file);
+	fwrite(payload.data(), 1, payload.size(), file);
+
+	payload.clear();
+
+}
+
+void TrajectoryWriter::writeComplex(ExportData& data) {
+
+	put((int32_t) data.id);
+	put(data.energy);
+	put(data.enthalpy);
+	put(data.names);
+	put(data.sequence);
+	put(data.structure);
+
+}
+
+void TrajectoryWriter::put(const string& text) {
+
+	put((uint32_t) text.size());
+	payload.append(text);
+
+}
@@ -12,14 +12,35 @@ try:
     from multistrand.objects import *
     from multistrand.options import Options
     from multistrand.system import SimSystem, initialize_energy_model, energy  # , initialInfo
+    from multistrand.options import Literals, ResultArrays
+    from multistrand.experiment import standardOptions, hybridization
+    from multistrand.concurrent import FirstStepRate, FirstPassageRate, MergeSim
+    from multistrand.trajectory import TrajectoryFile, CHECKPOINT_INTERVAL
+    from multistrand.system import passage_times, boltzmann_sample, calculate_rate
     
 except ImportError:
     
     print("Could not import Multistrand.")
     raise
 
+try:
+
+    # the Builder solves its statespace with scipy
+    from multistrand.builder import Builder, BuilderRate
+
+except ImportError:
+
+    Builder = None
+
 import unittest
 import warnings
+import collections
+import math
+import pathlib
+import random
+import shutil
+import subprocess
+import tempfile
 # for IPython, some of the IPython libs used by unittest have a
 # deprecated usage of BaseException, so we turn that specific warning
 # off.
@@ -247,6 +268,1124 @@ class MI_System_Object_TestCase(unittest.TestCase):
         MI_System_Object_TestCase.str_run_system_several_times += "Third run results [yet another system]:\n{0}\n".format(str(self.options.interface))
 
 
+def simulationOptions(mode, trials=1, timeOut=1e-3, start=None, stops=None, seed=None, **settings):
+    """ standardOptions at 25 C with the given start state, stop conditions
+    and initial seed. The other settings are set in the order given.
+    """
+    o = standardOptions(simMode=mode, trials=trials, timeOut=timeOut)
+    if start is not None:
+        o.start_state = start
+    if stops is not None:
+        o.stop_conditions = stops
+    if seed is not None:
+        o.initial_seed = seed
+    for name, value in settings.items():
+        setattr(o, name, value)
+    return o
+
+
+def results(o):
+    """ The seed, tag and time of every trajectory. """
+    return [(r.seed, r.tag, r.time) for r in o.interface.results]
+
+
+class MI_Directory_TestCase(unittest.TestCase):
+    """ Runs every test in a new temporary directory, where the statespace
+    files are written.
+    """
+    def setUp(self):
+        self.cwd = os.getcwd()
+        self.directory = tempfile.mkdtemp()
+        os.chdir(self.directory)
+
+    def tearDown(self):
+        os.chdir(self.cwd)
+        shutil.rmtree(self.directory)
+
+
+@unittest.skipIf(Builder is None, "the Builder needs scipy")
+class MI_Loop_Tree_TestCase(MI_Directory_TestCase):
+    """ In inspection mode every transition has rate 1, and the Builder takes
+    every transition of the start state once, through the LoopTree of the
+    complex. The transitions reach every neighbour of a multiloop structure:
+    one for each base pair that is deleted, or created within a loop.
+    """
+    sequence = "CCGCCGACGCGGGGGCCCCCGTTGGGGTACCCCCAGGCGGCGGACGCGCGCTAGCGCACGCGCTT"
+    structure = "..((((...((((....))))..((((...))))...))))...((((((....)))..)))..."
+
+    def setUp(self):
+        MI_Directory_TestCase.setUp(self)
+        self.strand = Strand(name="s", domains=[Domain(name="d", sequence=self.sequence)])
+
+    def makeOptions(self, arguments):
+        return simulationOptions(Literals.trajectory, arguments[0], 1.0, start=[Complex(strands=[self.strand], structure=self.structure)])
+
+    def neighbours(self):
+        complementary = set(["AT", "TA", "CG", "GC", "GT", "TG"])
+        structure = self.structure
+        output = []
+        stack = []
+        loop = dict()
+
+        for i, c in enumerate(structure):
+            if c == "(":
+                stack.append(i)
+            elif c == ")":
+                j = stack.pop()
+                output.append(structure[:j] + "." + structure[j + 1:i] + "." + structure[i + 1:])
+            else:
+                loop[i] = stack[-1] if stack else -1
+
+        for i in loop:
+            for j in loop:
+                if i < j - 3 and loop[i] == loop[j] and self.sequence[i] + self.sequence[j] in complementary:
+                    output.append(structure[:i] + "(" + structure[i + 1:j] + ")" + structure[j + 1:])
+
+        return output
+
+    def test_loop_tree_neighbours(self):
+        """ Test [LoopTree]: inspection takes every transition of a multiloop structure once """
+        initialize_energy_model(self.makeOptions([1]))
+        builder = Builder(self.makeOptions, [1])
+        builder.verbosity = False
+        builder.genAndSavePathsFile(inspecting=True)
+
+        reached = [builder.protoSequences[after][2][0] for before, after in builder.protoTransitions]
+
+        self.assertEqual(len(reached), 42)
+        self.assertEqual(sorted(reached), sorted(self.neighbours()))
+
+
+class MI_Threaded_Start_TestCase(unittest.TestCase):
+    """ Runs the same trials with start(threads=1) and start(threads=4).
+
+    Trajectory seeds only depend on the initial seed, so the threaded run gives
+    the same results, in the same order. Settings that need Python during a
+    trajectory fall back to a single thread and give the same results as well.
+    """
+    def setUp(self):
+        toehold = Domain(name="t", sequence="GTCA")
+        branch = Domain(name="b", sequence="CTTGAGC")
+        self.top = Strand(name="top", domains=[toehold, branch])
+        self.bottom = self.top.C
+
+    def simulate(self, mode, threads, trials=40, **settings):
+        single_top = Complex(strands=[self.top], structure="..")
+        single_bottom = Complex(strands=[self.bottom], structure="..")
+        duplex = Complex(strands=[self.top, self.bottom], structure="((+))")
+        stops = [StopCondition("stop:duplex", [(duplex, Literals.count_macrostate, 2)]),
+                 StopCondition("stop:apart", [(single_top, Literals.dissoc_macrostate, 0), (single_bottom, Literals.dissoc_macrostate, 0)])]
+
+        o = simulationOptions(mode, trials, 1e-5, start=[single_top, single_bottom], stops=stops, seed=1337, join_concentration=1e-3, **settings)
+        SimSystem(o).start(trials=o.num_simulations, threads=threads)
+        return o
+
+    def test_threads_first_passage(self):
+        """ Test [Threads]: first passage trials give the same seeds, tags and times """
+        single = results(self.simulate(Literals.first_passage_time, 1))
+        threaded = results(self.simulate(Literals.first_passage_time, 4))
+
+        self.assertEqual(len(single), 40)
+        self.assertEqual(single, threaded)
+
+    def test_threads_energy_model(self):
+        """ Test [Threads]: every worker thread sets the energy model its loops read """
+        # Loop::energyModel is per thread, a worker that does not set it fails an assertion.
+        # The new process turns that abort into a failure of this test.
+        script = "\n".join([
+            "import sys",
+            "sys.path.insert(0, sys.argv[1])",
+            "from unittests import MI_Threaded_Start_TestCase, results, Literals",
+            "case = MI_Threaded_Start_TestCase('test_threads_energy_model')",
+            "case.setUp()",
+            "print(repr(results(case.simulate(Literals.first_passage_time, 4))))"])
+
+        environment = dict(os.environ, PYTHONPATH=os.pathsep.join(path for path in sys.path if path))
+        process = subprocess.run([sys.executable, "-c", script, os.path.dirname(os.path.abspath(__file__))], env=environment, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+
+        self.assertEqual(process.returncode, 0)
+        self.assertEqual(process.stdout.decode().strip(), repr(results(self.simulate(Literals.first_passage_time, 1))))
+
+    def test_threads_first_step(self):
+        """ Test [Threads]: first step trials give the same seeds, tags, times and rates """
+        single = self.simulate(Literals.first_step, 1)
+        threaded = self.simulate(Literals.first_step, 4)
+
+        self.assertEqual(results(single), results(threaded))
+        self.assertEqual([r.collision_rate for r in single.interface.results],
+                         [r.collision_rate for r in threaded.interface.results])
+
+    def test_threads_transition_mode(self):
+        """ Test [Threads]: transition mode falls back to a single thread """
+        single = self.simulate(Literals.transition, 1, trials=5)
+        threaded = self.simulate(Literals.transition, 4, trials=5)
+
+        self.assertTrue(len(single.interface.transition_lists) > 0)
+        self.assertEqual(single.interface.transition_lists, threaded.interface.transition_lists)
+        self.assertEqual(results(single), results(threaded))
+
+    def test_threads_output_interval(self):
+        """ Test [Threads]: exporting states with output_interval falls back to a single thread """
+        single = self.simulate(Literals.trajectory, 1, trials=3, output_interval=10)
+        threaded = self.simulate(Literals.trajectory, 4, trials=3, output_interval=10)
+
+        self.assertTrue(len(single.full_trajectory) > 0)
+        self.assertEqual(single.full_trajectory, threaded.full_trajectory)
+        self.assertEqual(single.full_trajectory_times, threaded.full_trajectory_times)
+
+
+class MI_Stop_Tracking_TestCase(unittest.TestCase):
+    """ Runs the same trajectories with the structure stop conditions checked
+    by a StopTracker, and by comparing the structure of every complex. Both
+    stop at the same times, with the same tags.
+    """
+    def compare(self, start, stops, trials=20, timeOut=1e-4):
+        runs = []
+        for tracking in [True, False]:
+            o = simulationOptions(Literals.first_passage_time, trials, timeOut, start=start, stops=stops, seed=3, stop_tracking=tracking)
+            SimSystem(o).start()
+            runs.append(results(o))
+
+        self.assertEqual(runs[0], runs[1])
+        return [tag for seed, tag, time in runs[0]]
+
+    def test_stop_tracking_hairpin(self):
+        """ Test [StopTracker]: exact, loose and count conditions on a hairpin """
+        strand = Strand(name="hairpin", domains=[Domain(name="h", sequence="GCGCATTTTTTGCGC")])
+        hairpin = lambda structure: Complex(strands=[strand], structure=structure)
+        start = [hairpin("." * 15)]
+
+        for condition in [(hairpin("(((((.....)))))"), Literals.exact_macrostate, 0),
+                          (hairpin("((***.....***))"), Literals.loose_macrostate, 2),
+                          (hairpin("(((((.....)))))"), Literals.count_macrostate, 2),
+                          (hairpin("(((((**...)))))"), Literals.count_macrostate, 4)]:
+            tags = self.compare(start, [StopCondition(Literals.success, [condition])])
+            self.assertTrue(Literals.success in tags)
+
+        # a wildcard of a count condition differs from any base
+        tags = self.compare(start, [StopCondition(Literals.success, [(hairpin("*" * 15), Literals.count_macrostate, 0)])], trials=2)
+        self.assertEqual(tags, [Literals.time_out] * 2)
+
+    def test_stop_tracking_duplex(self):
+        """ Test [StopTracker]: conditions on the association and dissociation of two strands """
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACTGC")])
+        single_top = Complex(strands=[top], structure="........")
+        single_bottom = Complex(strands=[top.C], structure="........")
+        duplex = lambda structure: Complex(strands=[top, top.C], structure=structure)
+
+        for condition in [(duplex("((((((((+))))))))"), Literals.exact_macrostate, 0),
+                          (duplex("((****((+))****))"), Literals.loose_macrostate, 2),
+                          (duplex("((((((((+))))))))"), Literals.count_macrostate, 3)]:
+            tags = self.compare([single_top, single_bottom], [StopCondition(Literals.success, [condition])])
+            self.assertTrue(Literals.success in tags)
+
+        # two base pairs at the end zip up, or fall apart
+        start = [duplex("((......+......))")]
+        zipped = StopCondition(Literals.success, [(duplex("((((((((+))))))))"), Literals.count_macrostate, 1)])
+        for apart in [[(single_top, Literals.dissoc_macrostate, 0)],
+                      [(single_top, Literals.exact_macrostate, 0), (single_bottom, Literals.exact_macrostate, 0)]]:
+            tags = self.compare(start, [zipped, StopCondition(Literals.failure, apart)], trials=40, timeOut=1e-3)
+            self.assertTrue(Literals.success in tags and Literals.failure in tags)
+
+    def test_stop_tracking_repeated_names(self):
+        """ Test [StopTracker]: conditions on a run with two strands of the same name """
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACTGC")])
+        start = [Complex(strands=[top], structure="........"), Complex(strands=[top], structure="........"), Complex(strands=[top.C], structure="........")]
+        duplex = lambda structure: Complex(strands=[top, top.C], structure=structure)
+
+        for condition in [[(duplex("((((((((+))))))))"), Literals.exact_macrostate, 0)],
+                          [(duplex("((****((+))****))"), Literals.loose_macrostate, 2)],
+                          [(duplex("((((((((+))))))))"), Literals.count_macrostate, 3), (start[0], Literals.exact_macrostate, 0)]]:
+            tags = self.compare(start, [StopCondition(Literals.success, condition)])
+            self.assertTrue(Literals.success in tags)
+
+
+class MI_Flux_Resum_TestCase(unittest.TestCase):
+    """ The total rate of the complexes is updated by differences. Summed again
+    at every update instead, it gives the same trajectory, at the same times up
+    to rounding errors.
+    """
+    def test_flux_resum(self):
+        """ Test [Flux]: the updated total rate is the summed rate over many joins and splits """
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACT")])
+        start = [Complex(strands=[strand], structure=".") for strand in [top, top.C, top, top.C]]
+
+        runs = []
+        for interval in [1, 1024]:
+            o = simulationOptions(Literals.trajectory, 1, 2e-3, start=start, seed=77, join_concentration=0.1, output_interval=1, flux_resum_interval=interval)
+            SimSystem(o).start()
+            runs.append(o)
+
+        summed, updated = runs
+        counts = [len(state) for state in summed.full_trajectory]
+        joins = sum(1 for before, after in zip(counts, counts[1:]) if after < before)
+        splits = sum(1 for before, after in zip(counts, counts[1:]) if after > before)
+
+        self.assertTrue(len(counts) > 4 * 1024 and joins > 10 and splits > 10)
+        self.assertEqual(summed.full_trajectory, updated.full_trajectory)
+
+        for first, second in zip(summed.full_trajectory_times, updated.full_trajectory_times):
+            self.assertTrue(abs(first - second) <= 1e-9 * first, "{0} != {1}".format(first, second))
+
+
+class MI_Energy_Cache_TestCase(unittest.TestCase):
+    """ With energy_cache_size, loop energies are memoized in a bounded table.
+    The trajectories are those without the cache, whatever its size, and the
+    lookups are counted in energy_cache_hits and energy_cache_misses.
+    """
+    def setUp(self):
+        self.strand = Strand(name="hairpins", domains=[Domain(name="h", sequence="GCGCAGTCAGCTTTTGCTGACACGGTACTTTTGTACCGAGCGC")])
+
+    def simulate(self, size, arrhenius, mode=Literals.trajectory, threads=1):
+        start = [Complex(strands=[self.strand], structure="." * len(self.strand.sequence))]
+        o = simulationOptions(mode, 4, 1e-3, start=start, seed=5, energy_cache_size=size)
+        if mode == Literals.trajectory:
+            o.output_interval = 1
+        if arrhenius:
+            o.DNA23Arrhenius()
+        SimSystem(o).start(trials=o.num_simulations, threads=threads)
+        return o
+
+    def test_energy_cache_trajectories(self):
+        """ Test [Energy Cache]: trajectories do not depend on the cache or its size """
+        for arrhenius in [False, True]:
+            direct = self.simulate(0, arrhenius)
+            self.assertEqual((direct.energy_cache_hits, direct.energy_cache_misses), (0, 0))
+            self.assertTrue(len(direct.full_trajectory) > 1000)
+
+            for size in [64, 4096]:
+                cached = self.simulate(size, arrhenius)
+                self.assertEqual(direct.full_trajectory, cached.full_trajectory)
+                self.assertEqual(direct.full_trajectory_times, cached.full_trajectory_times)
+                self.assertTrue(cached.energy_cache_hits > 0 and cached.energy_cache_misses > 0)
+
+    def test_energy_cache_threads(self):
+        """ Test [Energy Cache]: worker threads have their own cache, and their lookups are counted """
+        single = self.simulate(4096, False, Literals.first_passage_time)
+        threaded = self.simulate(4096, False, Literals.first_passage_time, threads=4)
+
+        self.assertEqual(results(single), results(threaded))
+        self.assertTrue(threaded.energy_cache_hits > 0 and threaded.energy_cache_misses > 0)
+
+
+class MI_Move_Container_TestCase(unittest.TestCase):
+    """ The indexed move container chooses the move that the linear scan would,
+    so both give the same trajectory at the same times.
+    """
+    def compare(self, start, timeOut, arrhenius=False, **settings):
+        runs = []
+        for container in [Literals.movelist_linear, Literals.movelist_indexed]:
+            o = simulationOptions(Literals.trajectory, 1, timeOut, start=start, seed=19, output_interval=1, move_container=container, **settings)
+            if arrhenius:
+                o.DNA23Arrhenius()
+            SimSystem(o).start()
+            runs.append(o)
+
+        linear, indexed = runs
+        self.assertTrue(len(linear.full_trajectory) > 1000)
+        self.assertEqual(linear.full_trajectory, indexed.full_trajectory)
+        self.assertEqual(linear.full_trajectory_times, indexed.full_trajectory_times)
+        self.assertEqual(results(linear), results(indexed))
+        return linear
+
+    def multiloops(self, structure):
+        """ The number of pairs that close a multiloop. """
+        branches = [0]
+        count = 0
+        for c in structure:
+            if c == "(":
+                branches[-1] += 1
+                branches.append(0)
+            elif c == ")":
+                count += branches.pop() >= 2
+        return count
+
+    def test_move_container_multiloop(self):
+        """ Test [Move Container]: a strand breathing in a three way junction """
+        strand = Strand(name="junction", domains=[Domain(name="j", sequence="GCGCAGTCAGCTTTTGCTGACACGGTACTTTTGTACCGAGCGC")])
+        o = self.compare([Complex(strands=[strand], structure="((((.((((((....)))))).((((((....)))))).))))")], 1e-3)
+        self.assertTrue(sum(1 for state in o.full_trajectory if self.multiloops(state[0][4]) > 0) > 1000)
+
+    def test_move_container_arrhenius(self):
+        """ Test [Move Container]: two strands joining and splitting, with Arrhenius rates """
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACTGCTTTT")])
+        start = [Complex(strands=[top], structure="." * 12), Complex(strands=[top.C], structure="." * 12)]
+        o = self.compare(start, 1e-2, arrhenius=True, join_concentration=1e-3)
+        self.assertTrue(any(len(state) == 1 for state in o.full_trajectory))
+
+
+class MI_Native_Results_TestCase(MI_Directory_TestCase):
+    """ With native_results, the results are gathered in ResultArrays instead
+    of Result objects. Both hold the same trajectories, and the rates computed
+    from either are the same. MergeSim merges the arrays of its processes.
+    """
+    def simulate(self, mode, native):
+        o = simulationOptions(mode, 60, 1e-3)
+        hybridization(o, "GTCACTGCTTTT")
+        o.join_concentration = 1e-6
+        o.initial_seed = 4242
+        o.native_results = native
+        SimSystem(o).start()
+        return o
+
+    def assertSameRate(self, first, second):
+        self.assertTrue(abs(first - second) <= 1e-12 * abs(first), "{0} != {1}".format(first, second))
+
+    def assertSameResults(self, results, arrays):
+        self.assertEqual(len(results), len(arrays))
+        self.assertEqual([r.seed for r in results], arrays.seed.tolist())
+        self.assertEqual([r.tag for r in results], [arrays.tags[code] for code in arrays.tag])
+        self.assertEqual([r.time for r in results], arrays.time.tolist())
+
+    def test_native_first_step(self):
+        """ Test [Native Results]: first step arrays hold the same trajectories and rates as Result objects """
+        results = self.simulate(Literals.first_step, False).interface.results
+        arrays = self.simulate(Literals.first_step, True).interface.result_arrays
+
+        self.assertSameResults(results, arrays)
+        self.assertEqual([r.collision_rate for r in results], arrays.collision_rate.tolist())
+
+        fromResults = FirstStepRate(results)
+        fromArrays = FirstStepRate(arrays)
+
+        self.assertTrue(fromArrays.nForward > 0 and fromArrays.nReverse > 0)
+        self.assertEqual(fromResults.nForward, fromArrays.nForward)
+        self.assertEqual(fromResults.nReverse, fromArrays.nReverse)
+        self.assertSameRate(fromResults.k1(), fromArrays.k1())
+        self.assertSameRate(fromResults.k2(), fromArrays.k2())
+
+        resampled = fromArrays.resample()
+        self.assertTrue(isinstance(resampled.dataset, ResultArrays))
+        self.assertEqual(len(resampled.dataset), len(arrays))
+
+    def test_native_first_passage(self):
+        """ Test [Native Results]: first passage arrays hold the same trajectories and rates as Result objects """
+        results = self.simulate(Literals.first_passage_time, False).interface.results
+        arrays = self.simulate(Literals.first_passage_time, True).interface.result_arrays
+
+        self.assertSameResults(results, arrays)
+        self.assertSameRate(FirstPassageRate(results).k1(), FirstPassageRate(arrays).k1())
+
+        resampled = FirstPassageRate(arrays).resample()
+        self.assertTrue(isinstance(resampled.dataset, ResultArrays))
+
+    def test_native_merge_sim(self):
+        """ Test [Native Results]: MergeSim gathers the arrays of every process """
+        def factory(trials):
+            o = simulationOptions(Literals.first_step, trials, 1e-3)
+            hybridization(o, "GTCACTGCTTTT")
+            o.join_concentration = 1e-6
+            o.native_results = True
+            return o
+
+        merge = MergeSim()
+        merge.setNumOfThreads(2)
+        merge.setOptionsFactory1(factory, 40)
+        merge.run()
+
+        arrays = merge.results.dataset
+        self.assertTrue(isinstance(arrays, ResultArrays))
+        self.assertEqual(len(arrays), 40)
+        self.assertEqual(merge.results.nTotal, 40)
+        self.assertTrue(merge.results.nForward > 0 and merge.results.k1() > 0.0)
+
+
+class MI_Trajectory_File_TestCase(MI_Directory_TestCase):
+    """ The states written to options.trajectory_file read back as the states
+    of options.full_trajectory for the same seed.
+    """
+    def setUp(self):
+        MI_Directory_TestCase.setUp(self)
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACT")])
+        self.start = [Complex(strands=[top], structure="."), Complex(strands=[top.C], structure=".")]
+
+    def simulate(self, path, start=None, interval=1):
+        o = simulationOptions(Literals.trajectory, 1, 1e-3, start=start or self.start, seed=77, join_concentration=0.1, output_interval=interval, trajectory_file=path)
+        SimSystem(o).start()
+        return o
+
+    def test_trajectory_file(self):
+        """ Test [Trajectory File]: frames() and frame(k) give the states of full_trajectory """
+        reference = self.simulate(None)
+        written = self.simulate(pathlib.Path(self.directory) / "states.traj")
+
+        self.assertTrue(isinstance(written.trajectory_file, str))
+        self.assertEqual(written.full_trajectory, [])
+
+        states = reference.full_trajectory
+        counts = [len(state) for state in states]
+        joins = sum(1 for before, after in zip(counts, counts[1:]) if after < before)
+        splits = sum(1 for before, after in zip(counts, counts[1:]) if after > before)
+        self.assertTrue(joins > 0 and splits > 0)
+        self.assertTrue(len(states) > 2 * CHECKPOINT_INTERVAL)
+
+        trajectory = TrajectoryFile(written.trajectory_file)
+        frames = list(trajectory.frames())
+
+        self.assertEqual([frame.complexes for frame in frames], states)
+        self.assertEqual([frame.time for frame in frames], reference.full_trajectory_times)
+
+        last = len(states) - 1
+        for k in [last, 0, CHECKPOINT_INTERVAL - 1, CHECKPOINT_INTERVAL, CHECKPOINT_INTERVAL + 1, 2 * CHECKPOINT_INTERVAL + 7, 5]:
+            self.assertEqual(trajectory.frame(k).complexes, states[k])
+
+    def test_trajectory_file_interval(self):
+        """ Test [Trajectory File]: the base pairs of several steps make one frame """
+        left = Strand(name="left", domains=[Domain(name="a", sequence="GCATCG"), Domain(name="b", sequence="TTGACC")])
+        right = Strand(name="right", domains=[Domain(name="c", sequence="CAGTGA")])
+        start = [Complex(strands=[left], structure="." * 12), Complex(strands=[left.C], structure="." * 12), Complex(strands=[right], structure="." * 6)]
+
+        reference = self.simulate(None, start, 7)
+        written = self.simulate(pathlib.Path(self.directory) / "states.traj", start, 7)
+
+        states = reference.full_trajectory
+        counts = [len(state) for state in states]
+        self.assertTrue(any(after != before for before, after in zip(counts, counts[1:])))
+        self.assertTrue(len(states) > 100)
+
+        frames = list(TrajectoryFile(written.trajectory_file).frames())
+        self.assertEqual([frame.complexes for frame in frames], states)
+
+    def test_trajectory_file_type(self):
+        """ Test [Trajectory File]: trajectory_file takes paths only """
+        o = Options()
+        o.trajectory_file = pathlib.Path(self.directory) / "states.traj"
+        self.assertEqual(o.trajectory_file, os.path.join(self.directory, "states.traj"))
+
+        with self.assertRaises(TypeError):
+            o.trajectory_file = 3
+
+
+@unittest.skipIf(Builder is None, "the Builder needs scipy")
+class MI_Builder_Statespace_TestCase(MI_Directory_TestCase):
+    """ Builds the statespace of a small association, and of a hairpin folding,
+    with the Builder.
+
+    The Builder reads the statespace of its trajectories from the text files,
+    or from the binary columns of options.statespace_binary, both give the same
+    statespace. BuilderRate solves it with scipy or natively, both give the
+    same passage time.
+    """
+    def setUp(self):
+        MI_Directory_TestCase.setUp(self)
+        top = Strand(name="top", domains=[Domain(name="d", sequence="TTGGTG")])
+        self.start = [Complex(strands=[top], structure="."), Complex(strands=[top.C], structure=".")]
+        self.success = Complex(strands=[top, top.C], structure="(+)")
+
+        hairpin = Strand(name="hairpin", domains=[Domain(name="h", sequence="GCGCGCTTTTTTTTTTGCGCGC")])
+        self.unfolded = [Complex(strands=[hairpin], structure="." * 22)]
+        self.folded = Complex(strands=[hairpin], structure="((((((..........))))))")
+
+        initialize_energy_model(self.makeOptions([1]))
+
+    def makeOptions(self, arguments):
+        stops = [StopCondition(Literals.success, [(self.success, Literals.exact_macrostate, 0)])]
+        o = simulationOptions(Literals.trajectory, arguments[0], 0.1, start=self.start, stops=stops, seed=17, join_concentration=0.001, output_interval=1)
+        o.temperature = 50.0
+        return o
+
+    def makeFoldingOptions(self, arguments):
+        stops = [StopCondition(Literals.success, [(self.folded, Literals.exact_macrostate, 0)])]
+        o = simulationOptions(Literals.trajectory, arguments[0], 1e-3, start=self.unfolded, stops=stops, seed=17, output_interval=1)
+        o.temperature = 50.0
+        return o
+
+    def makeBuilder(self, binary, makeOptions=None, trials=3):
+        builder = Builder(makeOptions or self.makeOptions, [trials])
+        builder.verbosity = False
+        builder.binaryStatespace = binary
+        builder.genAndSavePathsFile()
+        return builder
+
+    def assertSameStatespace(self, text, binary):
+        self.assertTrue(len(text.protoTransitions) > 0)
+        self.assertEqual(text.protoSpace, binary.protoSpace)
+        self.assertEqual(text.protoTransitions, binary.protoTransitions)
+        self.assertEqual(text.protoFinalStates, binary.protoFinalStates)
+        self.assertEqual(text.protoSequences, binary.protoSequences)
+
+    def test_binary_statespace(self):
+        """ Test [Builder]: the binary statespace is the statespace of the text files """
+        self.assertFalse(Builder(self.makeOptions, [3]).binaryStatespace)
+
+        self.assertSameStatespace(self.makeBuilder(False), self.makeBuilder(True))
+
+    def test_binary_statespace_folding(self):
+        """ Test [Builder]: the binary statespace of a hairpin folding is the statespace of the text files """
+        text = self.makeBuilder(False, self.makeFoldingOptions, 10)
+        binary = self.makeBuilder(True, self.makeFoldingOptions, 10)
+
+        self.assertTrue(len(text.protoSpace) > 100)
+        self.assertSameStatespace(text, binary)
+
+    def passageTime(self, builder, toggle):
+        default = BuilderRate.solveToggle
+        BuilderRate.solveToggle = toggle
+        try:
+            return BuilderRate(builder).averageTimeFromInitial(bimolecular=True)
+        finally:
+            BuilderRate.solveToggle = default
+
+    def test_native_passage_times(self):
+        """ Test [BuilderRate]: the native solvers give the passage time of the scipy solver """
+        builder = self.makeBuilder(False)
+        reference = self.passageTime(builder, 2)
+
+        self.assertTrue(reference > 0.0)
+
+        for toggle in sorted(BuilderRate.nativeSolvers):
+            time = self.passageTime(builder, toggle)
+            self.assertTrue(abs(time - reference) <= 1e-6 * reference, "solveToggle {0}: {1} != {2}".format(toggle, time, reference))
+
+    def test_native_passage_times_folding(self):
+        """ Test [BuilderRate]: the ILU(0) and BiCGSTAB native solvers give the passage time of the scipy solver on a folding """
+        builder = self.makeBuilder(False, self.makeFoldingOptions, 10)
+        reference = self.passageTime(builder, 2)
+
+        self.assertTrue(len(builder.protoSpace) > 100)
+        self.assertTrue(reference > 0.0)
+
+        # restarted GMRES with the Jacobi preconditioner (13) stalls on folding
+        # spaces, as scipy's gmres does with the same restart length
+        for toggle in [11, 12, 14]:
+            time = self.passageTime(builder, toggle)
+            self.assertTrue(abs(time - reference) <= 1e-6 * reference, "solveToggle {0}: {1} != {2}".format(toggle, time, reference))
+
+    def test_native_passage_times_tables(self):
+        """ Test [BuilderRate]: passage_times rejects tables of mismatched lengths """
+        default = BuilderRate.solveToggle
+        BuilderRate.solveToggle = 11
+        try:
+            rates = BuilderRate(self.makeBuilder(False))
+        finally:
+            BuilderRate.solveToggle = default
+
+        tables = [rates.energies, rates.final, rates.source, rates.target, rates.kind, rates.left, rates.right]
+
+        for i in range(len(tables)):
+            shortened = list(tables)
+            shortened[i] = tables[i][:-1]
+            with self.assertRaises(ValueError):
+                passage_times(rates.build.options, *shortened)
+
+        # a transition to a state that does not exist
+        target = rates.target.copy()
+        target[0] = len(rates.final)
+        with self.assertRaises(ValueError):
+            passage_times(rates.build.options, rates.energies, rates.final, rates.source, target, rates.kind, rates.left, rates.right)
+
+
+class MI_Boltzmann_Sample_TestCase(unittest.TestCase):
+    """ Compares boltzmann_sample with the enumerated structures of small
+    complexes: the free energy with the partition function of their loop
+    energies, and the sampled structures with their Boltzmann distribution.
+
+    The sequences have no G-T wobble pairs, so the enumeration only needs the
+    Watson-Crick pairs.
+    """
+    samples = 20000
+
+    def setUp(self):
+        self.options = standardOptions(tempIn=25.0)
+        initialize_energy_model(self.options)
+
+    def enumerate(self, sequences):
+        """ Every connected, pseudoknot free structure, in dot paren notation. """
+        sequence = "".join(sequences)
+        strand = [k for k, s in enumerate(sequences) for i in range(len(s))]
+        complementary = set([("A", "T"), ("T", "A"), ("C", "G"), ("G", "C")])
+
+        def pairs(i, j):
+            return (sequence[i], sequence[j]) in complementary and (strand[i] != strand[j] or j - i > 3)
+
+        def fold(i, j):
+            if i >= j:
+                yield ""
+                return
+            for rest in fold(i + 1, j):
+                yield "." + rest
+            for k in range(i + 1, j):
+                if pairs(i, k):
+                    for inside in fold(i + 1, k):
+                        for rest in fold(k + 1, j):
+                            yield "(" + inside + ")" + rest
+
+        def connected(structure):
+            # pairs between consecutive strands connect them all
+            open_pairs = []
+            joined = set()
+            for position, c in enumerate(structure):
+                if c == "(":
+                    open_pairs.append(position)
+                elif c == ")":
+                    first = strand[open_pairs.pop()]
+                    if first != strand[position]:
+                        joined.add(first)
+            return len(joined) == len(sequences) - 1
+
+        output = []
+        for structure in fold(0, len(sequence)):
+            if connected(structure):
+                cuts = [sum(len(s) for s in sequences[:k]) for k in range(len(sequences) + 1)]
+                output.append("+".join(structure[cuts[k]:cuts[k + 1]] for k in range(len(sequences))))
+        return output
+
+    def checkComplex(self, sequences):
+        try:
+            import scipy.stats
+        except ImportError:
+            self.skipTest("the chi-square test needs scipy")
+
+        strands = [Strand(name="s" + str(k), domains=[Domain(name="d" + str(k), sequence=s)]) for k, s in enumerate(sequences)]
+        RT = 0.0019872041 * self.options._temperature_kelvin
+
+        weights = dict()
+        for structure in self.enumerate(sequences):
+            dG = energy([Complex(strands=strands, structure=structure)], self.options, 0)[0]
+            weights[structure] = math.exp(-dG / RT)
+        Z = sum(weights.values())
+
+        structures, free_energy = boltzmann_sample(self.options, "+".join(sequences), self.samples, 5)
+
+        self.assertAlmostEqual(free_energy, -RT * math.log(Z), places=4)
+        self.assertEqual(len(structures), self.samples)
+
+        counts = collections.Counter(structures)
+        self.assertTrue(set(counts) <= set(weights))
+
+        # structures expected fewer than 5 times are pooled
+        expected = dict((structure, self.samples * w / Z) for structure, w in weights.items())
+        frequent = [structure for structure in weights if expected[structure] >= 5]
+        observed = [counts[structure] for structure in frequent]
+        predicted = [expected[structure] for structure in frequent]
+        if len(frequent) < len(weights):
+            observed.append(self.samples - sum(observed))
+            predicted.append(self.samples - sum(predicted))
+
+        chi2 = sum((o - e) ** 2 / e for o, e in zip(observed, predicted))
+        self.assertTrue(chi2 < scipy.stats.chi2.ppf(0.999, len(observed) - 1), "chi-square {0} over {1} classes".format(chi2, len(observed)))
+
+        # a start complex of the options samples its structures the same way
+        options = standardOptions(tempIn=25.0)
+        options.start_state = [Complex(strands=strands, structure="+".join("." for s in sequences), boltzmann_sample=True)]
+        sampled = options.start_state[0]
+        sampled.boltzmann_count = 100
+        self.assertTrue(set(sampled.structure for i in range(100)) <= set(weights))
+
+    def test_boltzmann_hairpin(self):
+        """ Test [Boltzmann]: a single strand samples its enumerated distribution """
+        self.checkComplex(["GCGAAAACGC"])
+
+    def test_boltzmann_duplex(self):
+        """ Test [Boltzmann]: two strands sample their enumerated distribution """
+        self.checkComplex(["GCAGC", "GCCGC"])
+
+
+class MI_Join_Rates_TestCase(unittest.TestCase):
+    """ The first step collision rate, with the Arrhenius rates of DNA23, is the
+    sum of the join rates of every pair of complementary exposed bases, one in
+    each complex. Exposed bases are the unpaired bases of the exterior loop and
+    of the loops with a nick. A base meets the other with the half contexts on
+    its two sides: a strand end, an unpaired base or a base pair.
+    """
+    def exposed(self, sequences, structure):
+        """ (base, left context, right context) of every exposed base. """
+        sequence = "+".join(sequences)
+        stack = []
+        loop = dict()
+        open_loops = set([-1])
+
+        for i, c in enumerate(structure):
+            if c == "(":
+                stack.append(i)
+            elif c == ")":
+                stack.pop()
+            elif c == "+":
+                open_loops.add(stack[-1] if stack else -1)
+            else:
+                loop[i] = stack[-1] if stack else -1
+
+        def context(i):
+            if i < 0 or i >= len(structure) or structure[i] == "+":
+                return "End"
+            return "Loop" if structure[i] == "." else "Stack"
+
+        return [(sequence[i], context(i - 1), context(i + 1)) for i in loop if loop[i] in open_loops]
+
+    def test_join_rates(self):
+        """ Test [Join Rates]: the collision rate sums the Arrhenius rates of the exposed base pairs """
+        first = (["TACGGCATCGCGAAT", "TCGCTTTGCC"], "...((((..((((..+))))..))))")
+        second = (["AGCCGGATTACCGGTTGA"], "..((((....))))....")
+
+        strands = [[Strand(name="s" + str(k) + str(i), domains=[Domain(name="d" + str(k) + str(i), sequence=s)]) for i, s in enumerate(sequences)]
+                   for k, (sequences, structure) in enumerate([first, second])]
+        start = [Complex(strands=strands[0], structure=first[1]), Complex(strands=strands[1], structure=second[1])]
+
+        o = simulationOptions(Literals.first_step, 1, 1e-6, start=start, seed=5)
+        o.DNA23Arrhenius()
+        SimSystem(o).start()
+
+        RT = 0.0019872041 * o._temperature_kelvin
+        names = {("End", "End"): "End", ("End", "Loop"): "LoopEnd", ("End", "Stack"): "StackEnd",
+                 ("Loop", "Loop"): "Loop", ("Loop", "Stack"): "StackLoop", ("Stack", "Stack"): "StackStack"}
+
+        def k(one, two):
+            name = names[tuple(sorted([one, two]))]
+            return math.exp(getattr(o, "lnA" + name) - getattr(o, "E" + name) / RT)
+
+        complementary = set(["AT", "TA", "CG", "GC"])
+        expected = 0.0
+        for base, left, right in self.exposed(*first):
+            for other, otherLeft, otherRight in self.exposed(*second):
+                if base + other in complementary:
+                    expected += k(left, otherRight) * k(right, otherLeft)
+        expected *= o.bimolecular_scaling
+
+        rate = o.interface.results[0].collision_rate
+        self.assertTrue(expected > 0.0)
+        self.assertTrue(abs(rate - expected) <= 1e-12 * expected, "{0} != {1}".format(rate, expected))
+
+
+class MI_Complex_Index_TestCase(MI_Directory_TestCase):
+    """ From complex_index_threshold complexes on, a ComplexIndex chooses the
+    complex that reacts and the partners of a join. With 18 complexes, it finds
+    the transitions of a walk over the list, and the same first passage times.
+    """
+    sequences = ["GTCAC", "TTGGA", "CACTG", "AGCTT", "GGATC", "TCCAA", "ACGTA", "CTTGC", "GATTC"]
+
+    def setUp(self):
+        MI_Directory_TestCase.setUp(self)
+        strands = [Strand(name="s" + str(k), domains=[Domain(name="d" + str(k), sequence=s)]) for k, s in enumerate(self.sequences)]
+        self.strands = strands + [strand.C for strand in strands]
+
+    def makeOptions(self, arguments):
+        start = [Complex(strands=[strand], structure=".") for strand in self.strands]
+        duplex = Complex(strands=[self.strands[0], self.strands[len(self.sequences)]], structure="(+)")
+        stops = [StopCondition(Literals.success, [(duplex, Literals.count_macrostate, 2)])]
+        o = simulationOptions(Literals.first_passage_time, arguments[0], 1e-2, start=start, stops=stops, seed=23, complex_index_threshold=arguments[1])
+        if arguments[2]:
+            o.DNA23Arrhenius()
+        return o
+
+    @unittest.skipIf(Builder is None, "the Builder needs scipy")
+    def test_complex_index_transitions(self):
+        """ Test [ComplexIndex]: inspection of 18 complexes finds the transitions of a walk over the list """
+        for arrhenius in [False, True]:
+            transitions = []
+            for threshold in [16, 1000000]:
+                initialize_energy_model(self.makeOptions([1, threshold, arrhenius]))
+                builder = Builder(self.makeOptions, [1, threshold, arrhenius])
+                builder.verbosity = False
+                builder.genAndSavePathsFile(inspecting=True)
+                transitions.append(sorted(builder.protoTransitions))
+
+            self.assertTrue(len(transitions[0]) > 100)
+            self.assertEqual(transitions[0], transitions[1])
+
+    def test_complex_index_first_passage(self):
+        """ Test [ComplexIndex]: first passage times of 18 complexes are those of a walk over the list """
+        # With Arrhenius rates the strands join and split billions of times per second, and
+        # a run takes millions of steps to find the duplex. Those runs are diluted and cut
+        # short at 0.2 ms: the times compared are those of a success or of the time out.
+        for arrhenius, trials in [(False, 400), (True, 100)]:
+            statistics = []
+            for threshold in [16, 1000000]:
+                o = self.makeOptions([trials, threshold, arrhenius])
+                if arrhenius:
+                    o.join_concentration = 1e-2
+                    o.simulation_time = 2e-4
+                SimSystem(o).start()
+
+                tags = [r.tag for r in o.interface.results]
+                if arrhenius:
+                    self.assertTrue(0 < tags.count(Literals.success) < trials)
+                else:
+                    self.assertEqual(set(tags), set([Literals.success]))
+                times = [r.time for r in o.interface.results]
+                mean = sum(times) / len(times)
+                error = math.sqrt(sum((t - mean) ** 2 for t in times) / (len(times) - 1) / len(times))
+                statistics.append((mean, error))
+
+            (indexed, indexedError), (walked, walkedError) = statistics
+            self.assertTrue(abs(indexed - walked) < 5 * math.hypot(indexedError, walkedError), "{0} != {1}".format(indexed, walked))
+
+
+class MI_Species_Multiplicity_TestCase(unittest.TestCase):
+    """ Five identical strands and one complement, held as five complexes or,
+    with species_multiplicity, as one entry with five copies. Both give the
+    same first passage statistics, and every copy is exported.
+    """
+    copies = 5
+
+    def setUp(self):
+        self.top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACTGC")])
+
+    def simulate(self, merge, mode, trials, **settings):
+        start = [Complex(strands=[self.top], structure=".") for i in range(self.copies)] + [Complex(strands=[self.top.C], structure=".")]
+        duplex = Complex(strands=[self.top, self.top.C], structure="(+)")
+        stops = [StopCondition(Literals.success, [(duplex, Literals.exact_macrostate, 0)])]
+        o = simulationOptions(mode, trials, 1.0, start=start, stops=stops, seed=11, join_concentration=1e-4, species_multiplicity=merge, **settings)
+        SimSystem(o).start()
+        return o
+
+    def test_species_first_passage(self):
+        """ Test [Species]: first passage times are the same with and without species_multiplicity """
+        statistics = []
+
+        for merge in [False, True]:
+            o = self.simulate(merge, Literals.first_passage_time, 1000)
+
+            self.assertEqual(set(r.tag for r in o.interface.results), set([Literals.success]))
+            times = [r.time for r in o.interface.results]
+            mean = sum(times) / len(times)
+            error = math.sqrt(sum((t - mean) ** 2 for t in times) / (len(times) - 1) / len(times))
+            statistics.append((mean, error))
+
+        (separate, separateError), (merged, mergedError) = statistics
+        self.assertTrue(abs(separate - merged) < 5 * math.hypot(separateError, mergedError), "{0} != {1}".format(separate, merged))
+
+    def test_species_exported_states(self):
+        """ Test [Species]: exported states list every copy """
+        for merge in [False, True]:
+            o = self.simulate(merge, Literals.trajectory, 1, output_interval=1)
+
+            # the trajectory ends when a copy has joined the complement
+            self.assertEqual(len(o.full_trajectory[-1]), self.copies)
+            first = o.full_trajectory[0]
+            self.assertEqual(sorted(c[1] for c in first), list(range(self.copies + 1)))
+            self.assertEqual(sorted(c[3] for c in first), sorted([self.top.sequence] * self.copies + [self.top.C.sequence]))
+
+            for state in o.full_trajectory:
+                self.assertEqual(sum(c[3].count("+") + 1 for c in state), self.copies + 1)
+
+
+class MI_Cotranscriptional_TestCase(unittest.TestCase):
+    """ A cotranscriptional run of 280 nucleotides, which fold into hairpins.
+    Loops more than 200 nucleotides behind the last active one are frozen, and
+    the base pairs that change are never that far behind. A nucleotide comes
+    every 10 us, well after the first step of the 8 nucleotides active at the
+    start, so that any seed transcribes the whole strand.
+    """
+    rate = 1e-5
+
+    def test_frozen_loops(self):
+        """ Test [Cotranscriptional]: base pairs behind the active window do not change """
+        sequence = "GCGGCGAAAGCCGC" * 20
+        strand = Strand(name="transcript", domains=[Domain(name="d", sequence=sequence)])
+        start = [Complex(strands=[strand], structure="." * len(sequence))]
+
+        o = simulationOptions(Literals.trajectory, 1, (len(sequence) + 20) * self.rate, start=start, seed=31,
+                              cotranscriptional=True, cotranscriptional_rate=self.rate, output_interval=1)
+        SimSystem(o).start()
+
+        structures = [state[0][4] for state in o.full_trajectory]
+        times = o.full_trajectory_times
+        self.assertEqual(structures[0], "." * len(sequence))
+
+        # the active nucleotides after every step, as counted by SimTimer::checkForNewNucleotide
+        active = 8
+        for k in range(1, len(structures)):
+            changed = [i for i, (before, after) in enumerate(zip(structures[k - 1], structures[k])) if before != after]
+            for i in changed:
+                self.assertTrue(active - 201 <= i < active, "step {0} changes base {1} of {2} active".format(k, i, active))
+            if times[k] > active * self.rate:
+                active += 1
+
+        self.assertTrue(active > len(sequence))
+        frozen = [i for i, c in enumerate(structures[-1]) if c != "." and i < active - 201]
+        self.assertTrue(len(frozen) > 0)
+
+
+class MI_Start_Template_TestCase(unittest.TestCase):
+    """ The loops and moves of a fixed start state are built once, and copied
+    for every trajectory. Built again for every trajectory, with
+    copy_start_state disabled, they give the same results.
+    """
+    def compare(self, mode, trials, timeOut, start, stops=None, **settings):
+        runs = []
+        for copy in [False, True]:
+            o = simulationOptions(mode, trials, timeOut, start=start, stops=stops, seed=41, copy_start_state=copy, **settings)
+            self.assertEqual(o.fixed_start_state, copy)
+            SimSystem(o).start()
+            runs.append(o)
+
+        self.assertEqual(results(runs[0]), results(runs[1]))
+        self.assertEqual(runs[0].full_trajectory, runs[1].full_trajectory)
+        self.assertEqual(runs[0].full_trajectory_times, runs[1].full_trajectory_times)
+        return runs[0]
+
+    def test_start_template_association(self):
+        """ Test [Start Template]: first passage trials of an association """
+        top = Strand(name="top", domains=[Domain(name="d", sequence="GTCACTGC")])
+        duplex = Complex(strands=[top, top.C], structure="((((((((+))))))))")
+        stops = [StopCondition(Literals.success, [(duplex, Literals.count_macrostate, 2)])]
+
+        o = self.compare(Literals.first_passage_time, 30, 1e-3, [Complex(strands=[top], structure="........"), Complex(strands=[top.C], structure="........")], stops)
+        self.assertTrue(Literals.success in [r.tag for r in o.interface.results])
+
+    def test_start_template_cotranscriptional(self):
+        """ Test [Start Template]: cotranscriptional trajectories """
+        strand = Strand(name="transcript", domains=[Domain(name="d", sequence="GCGGCGAAAGCCGC" * 3)])
+        o = self.compare(Literals.trajectory, 3, 50e-6, [Complex(strands=[strand], structure="." * 42)],
+                         cotranscriptional=True, cotranscriptional_rate=1e-6, output_interval=1)
+        self.assertTrue(len(o.full_trajectory) > 0)
+
+    def test_start_template_flat(self):
+        """ Test [Start Template]: trajectories of the flat state engine """
+        strand = Strand(name="hairpin", domains=[Domain(name="h", sequence="GCGCATTTTTTGCGC")])
+        o = self.compare(Literals.trajectory, 3, 1e-5, [Complex(strands=[strand], structure="." * 15)],
+                         state_engine=Literals.engine_flat, output_interval=1)
+        self.assertTrue(len(o.full_trajectory) > 0)
+
+
+class MI_Transition_Rates_TestCase(unittest.TestCase):
+    """ Every base pair move of a state, with Kawasaki and Metropolis rates, has
+    the rate of the energy difference between the structures it connects. The
+    states hold stacks, bulges and interior loops next to each other, and a
+    multiloop that closes into a bulge or an interior loop.
+    """
+    states = [("AGTCAGCCATATGCCTCCCGGGCATAATCGGATGC", "((.((......))).)...((...).........)"),
+              ("ATGACGTCAAGCGTCGAGGTGTCAACCCACGTGA", "(.....)(.(...)...).(((........)))."),
+              ("GTTTCAACTGACTTTACACGGTCTTTGGGCTAGAGCAAGTACCGA", ".((..(........(....)....)(......)...).......)")]
+
+    def transitions(self, sequence, structure, **settings):
+        """ (energy, moves) of the complex in the given structure. """
+        strand = Strand(name="s", domains=[Domain(name="d", sequence=sequence)])
+        o = simulationOptions(Literals.trajectory, start=[Complex(strands=[strand], structure=structure)], **settings)
+        return SimSystem(o).transitionRates()[0], o
+
+    def test_transition_rates(self):
+        """ Test [Transition Rates]: every move rate matches the energy difference of its structures """
+        for sequence, structure in self.states:
+            for dangles in [Literals.dangles_none, Literals.dangles_some, Literals.dangles_all]:
+                for method in [Literals.kawasaki, Literals.metropolis]:
+                    (start, moves), o = self.transitions(sequence, structure, dangles=dangles, rate_method=method)
+                    self.assertTrue(any(not create for create, first, second, rate in moves))
+
+                    for create, first, second, rate in moves:
+                        after = list(structure)
+                        after[first], after[second] = ("(", ")") if create else (".", ".")
+                        (end, _), o = self.transitions(sequence, "".join(after), dangles=dangles, rate_method=method)
+                        self.assertAlmostEqual(rate / calculate_rate(start, end, o), 1.0, places=9, msg=(structure, "".join(after), dangles, method))
+
+
+class MI_State_Engine_TestCase(unittest.TestCase):
+    """ The flat state engine and the loop graph hold the same loops: on random
+    single strands in random structures, they give the same energy and the same
+    base pair moves at the same rates, with every dangle setting and with the
+    Kawasaki, Metropolis and Arrhenius rate methods.
+    """
+    complementary = set(["AT", "TA", "CG", "GC", "GT", "TG"])
+
+    def randomState(self, generator):
+        """ A random sequence, and a structure of random base pairs that nest. """
+        sequence = "".join(generator.choice("ACGT") for _ in range(generator.randrange(30, 60)))
+        partner = [-1] * len(sequence)
+        for _ in range(1000):
+            i, j = sorted(generator.sample(range(len(sequence)), 2))
+            if j - i < 4 or partner[i] != -1 or partner[j] != -1 or sequence[i] + sequence[j] not in self.complementary:
+                continue
+            if all(partner[k] == -1 or i < partner[k] < j for k in range(i + 1, j)):
+                partner[i], partner[j] = j, i
+        structure = "".join("." if p == -1 else ("(" if p > k else ")") for k, p in enumerate(partner))
+        return sequence, structure
+
+    def transitions(self, sequence, structure, engine, dangles, method):
+        strand = Strand(name="s", domains=[Domain(name="d", sequence=sequence)])
+        o = simulationOptions(Literals.trajectory, start=[Complex(strands=[strand], structure=structure)],
+                              state_engine=engine, dangles=dangles)
+        if method == Literals.arrhenius:
+            o.DNA23Arrhenius()
+        else:
+            o.rate_method = method
+        return SimSystem(o).transitionRates()[0]
+
+    def test_state_engines(self):
+        """ Test [State Engine]: the flat engine has the energy and the move rates of the loop graph """
+        generator = random.Random(7)
+        for _ in range(8):
+            sequence, structure = self.randomState(generator)
+            for dangles in [Literals.dangles_none, Literals.dangles_some, Literals.dangles_all]:
+                for method in [Literals.kawasaki, Literals.metropolis, Literals.arrhenius]:
+                    message = (sequence, structure, dangles, method)
+                    graph = self.transitions(sequence, structure, Literals.engine_loops, dangles, method)
+                    flat = self.transitions(sequence, structure, Literals.engine_flat, dangles, method)
+
+                    self.assertAlmostEqual(graph[0], flat[0], places=9, msg=message)
+                    self.assertEqual([move[:3] for move in graph[1]], [move[:3] for move in flat[1]], message)
+                    for one, other in zip(graph[1], flat[1]):
+                        self.assertAlmostEqual(one[3] / other[3], 1.0, places=9, msg=(message, one[:3]))
+
+
+class MI_Parameter_Snapshot_TestCase(MI_Directory_TestCase):
+    """ With parameter_snapshot_dir, the parsed energy tables are written to the
+    directory and mapped from there by later processes. Every energy model is
+    built in a new process, so that it cannot take the tables from memory.
+    """
+    states = MI_Transition_Rates_TestCase.states
+
+    script = "\n".join([
+        "import sys",
+        "from multistrand.objects import Strand, Domain, Complex",
+        "from multistrand.experiment import standardOptions",
+        "from multistrand.system import initialize_energy_model, energy",
+        "o = standardOptions(tempIn=float(sys.argv[1]))",
+        "o.sodium = float(sys.argv[2])",
+        "o.parameter_snapshot_dir = sys.argv[3]",
+        "initialize_energy_model(o)",
+        "for sequence, structure in zip(sys.argv[4::2], sys.argv[5::2]):",
+        "    strand = Strand(name='s', domains=[Domain(name='d', sequence=sequence)])",
+        "    print(repr(energy([Complex(strands=[strand], structure=structure)], o, 0)[0]))"])
+
+    def energies(self, temperature=25.0, sodium=1.0):
+        """ The energies of the states, from an energy model built in a new process. """
+        arguments = [str(temperature), str(sodium), self.directory] + [part for state in self.states for part in state]
+        environment = dict(os.environ, PYTHONPATH=os.pathsep.join(path for path in sys.path if path))
+        output = subprocess.check_output([sys.executable, "-c", self.script] + arguments, env=environment, stderr=subprocess.DEVNULL)
+        return [float(line) for line in output.decode().split()]
+
+    def snapshots(self):
+        return sorted(name for name in os.listdir(self.directory) if name.endswith(".msp"))
+
+    def test_snapshot_written(self):
+        """ Test [Parameter Snapshot]: the first model writes a snapshot, the next one maps it """
+        parsed = self.energies()
+        files = self.snapshots()
+        self.assertEqual(len(files), 1)
+
+        path = os.path.join(self.directory, files[0])
+        written = os.stat(path)
+        self.assertEqual(self.energies(), parsed)
+        self.assertEqual(self.snapshots(), files)
+        self.assertEqual(os.stat(path).st_mtime_ns, written.st_mtime_ns)
+
+    def test_snapshot_conditions(self):
+        """ Test [Parameter Snapshot]: other temperatures and salts do not use the snapshot """
+        parsed = self.energies()
+        self.assertNotEqual(self.energies(temperature=37.0), parsed)
+        self.assertEqual(len(self.snapshots()), 2)
+        self.assertNotEqual(self.energies(sodium=0.5), parsed)
+        self.assertEqual(len(self.snapshots()), 3)
+        self.assertEqual(self.energies(), parsed)
+
+    def test_snapshot_damaged(self):
+        """ Test [Parameter Snapshot]: a corrupted or truncated snapshot is parsed again """
+        parsed = self.energies()
+        path = os.path.join(self.directory, self.snapshots()[0])
+        size = os.path.getsize(path)
+
+        with open(path, "r+b") as snapshot:
+            snapshot.seek(size - 100)
+            snapshot.write(bytes(100))
+        self.assertEqual(self.energies(), parsed)
+        self.assertEqual(os.path.getsize(path), size)
+
+        with open(path, "r+b") as snapshot:
+            snapshot.truncate(size // 2)
+        self.assertEqual(self.energies(), parsed)
+        self.assertEqual(os.path.getsize(path), size)
+
+
 class SetupSuite( object ):
     """ Container for default set of tests and standard method for running them."""
 
@@ -259,6 +1398,60 @@ class SetupSuite( object ):
         self._suite.addTests(
             unittest.TestLoader().loadTestsFromTestCase(
                 MI_Options_Object_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Loop_Tree_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Threaded_Start_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Stop_Tracking_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Flux_Resum_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Energy_Cache_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Move_Container_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Native_Results_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Trajectory_File_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Builder_Statespace_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Boltzmann_Sample_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Join_Rates_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Complex_Index_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Species_Multiplicity_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Cotranscriptional_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Start_Template_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Transition_Rates_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_State_Engine_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Parameter_Snapshot_TestCase ))
 
     def runTests(self):
         if hasattr(self, "_suite") and self._suite is not None: